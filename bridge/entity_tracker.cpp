@@ -0,0 +1,310 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "entity_tracker.h"
+
+#include "shared/ids.h"
+
+entity_info_t* entity_tracker_t::find_entity(const int eid)
+{
+    auto it = entity_map.find(eid);
+    return (it == entity_map.end()) ? NULL : &entities[it->second];
+}
+
+void entity_tracker_t::spawn_entity(const entity_info_t& ent)
+{
+    auto it = entity_map.find(ent.eid);
+    if (it != entity_map.end())
+    {
+        entities[it->second] = ent;
+        return;
+    }
+
+    entity_map[ent.eid] = entities.size();
+    entities.push_back(ent);
+}
+
+void entity_tracker_t::trim(const size_t history_limit)
+{
+    if (entities_destroyed <= history_limit)
+        return;
+
+    size_t to_drop = entities_destroyed - history_limit * 3 / 4;
+    entities_destroyed -= to_drop;
+
+    size_t out = 0;
+    for (size_t i = 0; i < entities.size(); i++)
+    {
+        const bool destroyed = entities[i].pack_destruction != CAPTURE_IDX_NONE;
+        if (destroyed && to_drop)
+        {
+            to_drop--;
+            if (sel == i)
+                sel = -1;
+            continue;
+        }
+
+        if (sel == i)
+            sel = out;
+        if (!destroyed)
+            entity_map[entities[i].eid] = out;
+        if (out != i)
+            entities[out] = std::move(entities[i]);
+        out++;
+    }
+    entities.resize(out);
+}
+
+#define CAST_PACK_TO_P(type) type* p = (type*)pack
+bool entity_tracker_t::feed_packet_from_server(packet_t* pack, const size_t pack_idx, const size_t history_limit)
+{
+    switch (pack->id)
+    {
+    case PACKET_ID_ENT_SPAWN_NAMED:
+    {
+        CAST_PACK_TO_P(packet_ent_spawn_named_t);
+
+        entity_info_t t;
+        t.eid = p->eid;
+        t.pos_x = p->x;
+        t.pos_y = p->y;
+        t.pos_z = p->z;
+        t.yaw = p->rotation;
+        t.pitch = p->pitch;
+        t.pack_creation = pack_idx;
+        t.tick_creation = p->assemble_tick;
+        t.type_name = p->get_name();
+
+        spawn_entity(t);
+
+        return true;
+    }
+    case PACKET_ID_ENT_SPAWN_PICKUP:
+    {
+        CAST_PACK_TO_P(packet_ent_spawn_pickup_t);
+
+        entity_info_t t;
+        t.eid = p->eid;
+        t.pos_x = p->x;
+        t.pos_y = p->y;
+        t.pos_z = p->z;
+        t.yaw = p->rotation;
+        t.pitch = p->pitch;
+        t.roll = p->roll;
+        t.pack_creation = pack_idx;
+        t.tick_creation = p->assemble_tick;
+        t.type_name = p->get_name();
+
+        spawn_entity(t);
+
+        return true;
+    }
+    case PACKET_ID_ADD_OBJ:
+    {
+        CAST_PACK_TO_P(packet_add_obj_t);
+
+        entity_info_t t;
+        t.eid = p->eid;
+        t.pos_x = p->x;
+        t.pos_y = p->y;
+        t.pos_z = p->z;
+        t.pack_creation = pack_idx;
+        t.tick_creation = p->assemble_tick;
+        t.type_name = mc_id::get_name_vehicle(p->obj_type);
+
+        spawn_entity(t);
+
+        return true;
+    }
+    case PACKET_ID_ENT_ENSURE_SPAWN:
+    {
+        CAST_PACK_TO_P(packet_ent_create_t);
+
+        entity_info_t t;
+        t.eid = p->eid;
+        t.pack_creation = pack_idx;
+        t.tick_creation = p->assemble_tick;
+        t.type_name = p->get_name();
+
+        spawn_entity(t);
+
+        return true;
+    }
+    case PACKET_ID_ENT_SPAWN_MOB:
+    {
+        CAST_PACK_TO_P(packet_ent_spawn_mob_t);
+
+        entity_info_t t;
+        t.eid = p->eid;
+        t.pos_x = p->x;
+        t.pos_y = p->y;
+        t.pos_z = p->z;
+        t.yaw = p->yaw;
+        t.pitch = p->pitch;
+        t.pack_creation = pack_idx;
+        t.tick_creation = p->assemble_tick;
+        t.type_name = mc_id::get_name_mob(p->mob_type);
+
+        spawn_entity(t);
+
+        return true;
+    }
+    case PACKET_ID_ENT_SPAWN_PAINTING:
+    {
+        CAST_PACK_TO_P(packet_ent_spawn_painting_t);
+
+        entity_info_t t;
+        t.eid = p->eid;
+        t.pos_x = p->center_x;
+        t.pos_y = p->center_y;
+        t.pos_z = p->center_z;
+        t.pack_creation = pack_idx;
+        t.tick_creation = p->assemble_tick;
+        t.type_name = p->get_name();
+
+        spawn_entity(t);
+
+        return true;
+    }
+    case PACKET_ID_ENT_SPAWN_XP:
+    {
+        CAST_PACK_TO_P(packet_ent_spawn_xp_t);
+
+        entity_info_t t;
+        t.eid = p->eid;
+        t.pos_x = p->x;
+        t.pos_y = p->y;
+        t.pos_z = p->z;
+        t.pack_creation = pack_idx;
+        t.tick_creation = p->assemble_tick;
+        t.type_name = p->get_name();
+
+        spawn_entity(t);
+
+        return true;
+    }
+    case PACKET_ID_THUNDERBOLT:
+    {
+        CAST_PACK_TO_P(packet_thunder_t);
+
+        entity_info_t t;
+        t.eid = p->eid;
+        t.pos_x = p->x;
+        t.pos_y = p->y;
+        t.pos_z = p->z;
+        t.pack_creation = pack_idx;
+        t.tick_creation = p->assemble_tick;
+        t.type_name = p->get_name();
+
+        spawn_entity(t);
+
+        return true;
+    }
+    case PACKET_ID_ENT_VELOCITY:
+    {
+        CAST_PACK_TO_P(packet_ent_velocity_t);
+
+        if (entity_info_t* e = find_entity(p->eid))
+        {
+            e->vel_x = p->vel_x;
+            e->vel_y = p->vel_y;
+            e->vel_z = p->vel_z;
+        }
+        return true;
+    }
+    case PACKET_ID_ENT_MOVE_REL:
+    {
+        CAST_PACK_TO_P(packet_ent_move_rel_t);
+
+        if (entity_info_t* e = find_entity(p->eid))
+        {
+            e->pos_x += p->delta_x;
+            e->pos_y += p->delta_y;
+            e->pos_z += p->delta_z;
+        }
+        return true;
+    }
+    case PACKET_ID_ENT_LOOK:
+    {
+        CAST_PACK_TO_P(packet_ent_look_t);
+
+        if (entity_info_t* e = find_entity(p->eid))
+        {
+            e->yaw = p->yaw;
+            e->pitch = p->pitch;
+        }
+        return true;
+    }
+    case PACKET_ID_ENT_LOOK_MOVE_REL:
+    {
+        CAST_PACK_TO_P(packet_ent_look_move_rel_t);
+
+        if (entity_info_t* e = find_entity(p->eid))
+        {
+            e->pos_x += p->delta_x;
+            e->pos_y += p->delta_y;
+            e->pos_z += p->delta_z;
+            e->yaw = p->yaw;
+            e->pitch = p->pitch;
+        }
+        return true;
+    }
+    case PACKET_ID_ENT_MOVE_TELEPORT:
+    {
+        CAST_PACK_TO_P(packet_ent_teleport_t);
+
+        if (entity_info_t* e = find_entity(p->eid))
+        {
+            e->pos_x = p->x;
+            e->pos_y = p->y;
+            e->pos_z = p->z;
+            e->yaw = p->rotation;
+            e->pitch = p->pitch;
+        }
+        return true;
+    }
+    case PACKET_ID_ENT_DESTROY:
+    {
+        CAST_PACK_TO_P(packet_ent_destroy_t);
+
+        entity_info_t* e = find_entity(p->eid);
+        if (!e)
+        {
+            /* Keep a record of entities destroyed without being seen */
+            entities.push_back(entity_info_t());
+            e = &entities.back();
+            e->eid = p->eid;
+        }
+
+        e->pack_destruction = pack_idx;
+        e->tick_destruction = p->assemble_tick;
+        entity_map.erase(p->eid);
+        entities_destroyed++;
+        trim(history_limit);
+
+        return true;
+    }
+    }
+
+    return false;
+}
+#undef CAST_PACK_TO_P
@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "shared/capture.h"
+#include "shared/packet.h"
+
+struct entity_info_t
+{
+    int eid = 0;
+
+    int pos_x = 0;
+    int pos_y = 0;
+    int pos_z = 0;
+
+    int vel_x = 0;
+    int vel_y = 0;
+    int vel_z = 0;
+
+    jbyte yaw = 0;
+    jbyte pitch = 0;
+    jbyte roll = 0;
+
+    /** Capture indices of the packets that created and destroyed the entity */
+    size_t pack_creation = CAPTURE_IDX_NONE;
+    size_t pack_destruction = CAPTURE_IDX_NONE;
+    Uint64 tick_creation = 0;
+    Uint64 tick_destruction = 0;
+
+    /** Entity type (or creation packet name if the type is unknown) */
+    const char* type_name = NULL;
+
+    std::string name;
+};
+
+/**
+ * Entities that a server told a client about
+ *
+ * Live entities are always kept, destroyed entities are kept up to a limit
+ */
+struct entity_tracker_t
+{
+    /**
+     * Live entities and the most recently destroyed ones in order of creation
+     *
+     * This is a deque so that pointers stay valid as it grows (Pointers are invalidated by entity_tracker_t::trim())
+     */
+    std::deque<entity_info_t> entities;
+
+    /** Number of destroyed entities in entities */
+    size_t entities_destroyed = 0;
+
+    /**
+     * Live entities, eid -> index into entities
+     */
+    std::unordered_map<int, size_t> entity_map;
+
+    /** Index into entities that is kept pointing at the same entity by entity_tracker_t::trim() (-1 if unset or dropped) */
+    size_t sel = -1;
+
+    /**
+     * Returns the live entity with the specified eid, or NULL if there isn't one
+     */
+    entity_info_t* find_entity(const int eid);
+
+    /**
+     * Adds an entity, or replaces the live entity with the same eid
+     */
+    void spawn_entity(const entity_info_t& ent);
+
+    /**
+     * Drops the oldest destroyed entities once there are more than history_limit of them
+     *
+     * Trims down to 3/4 of the limit so that the entities only need to be re-indexed every so often
+     */
+    void trim(const size_t history_limit);
+
+    /**
+     * @param pack Packet to process
+     * @param pack_idx Capture index of the packet
+     * @param history_limit Maximum number of destroyed entities to keep (See: entity_tracker_t::trim())
+     *
+     * @returns True if the packet was an entity packet
+     */
+    bool feed_packet_from_server(packet_t* pack, const size_t pack_idx, const size_t history_limit);
+};
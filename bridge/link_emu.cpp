@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "link_emu.h"
+
+#include <SDL3/SDL_stdinc.h>
+
+bool link_emu_t::send(SDLNet_StreamSocket* const sock, const Uint8* const dat, const size_t len, const params_t& params, const Uint64 tick_ns)
+{
+    if (!len)
+        return true;
+
+    if (!params.is_active() && segments.empty())
+        return SDLNet_WriteToStreamSocket(sock, dat, len);
+
+    Uint64 release_tick = tick_ns + Uint64(params.latency) * 1000000;
+    if (params.jitter)
+        release_tick += Uint64(SDL_rand(params.jitter + 1)) * 1000000;
+
+    /* TCP does not reorder data, so neither should the jitter */
+    release_tick = SDL_max(release_tick, last_release_tick);
+    last_release_tick = release_tick;
+
+    segments.push_back({ release_tick, len });
+    data.insert(data.end(), dat, dat + len);
+
+    return pump(sock, params, tick_ns);
+}
+
+bool link_emu_t::pump(SDLNet_StreamSocket* const sock, const params_t& params, const Uint64 tick_ns)
+{
+    if (params.bandwidth)
+    {
+        const double bucket_size = SDL_max(params.burst, 1u);
+        tokens = SDL_min(tokens + double(tick_ns - last_refill_tick) * double(params.bandwidth) / 1000000000.0, bucket_size);
+    }
+    last_refill_tick = tick_ns;
+
+    while (segments.size() && segments.front().release_tick <= tick_ns)
+    {
+        segment_t& seg = segments.front();
+
+        size_t allowed = seg.len;
+        if (params.bandwidth)
+            allowed = SDL_min(allowed, size_t(tokens));
+
+        if (!allowed)
+            break;
+
+        if (!SDLNet_WriteToStreamSocket(sock, data.data() + data_pos, allowed))
+            return false;
+
+        data_pos += allowed;
+        seg.len -= allowed;
+        if (params.bandwidth)
+            tokens -= double(allowed);
+
+        if (!seg.len)
+            segments.pop_front();
+    }
+
+    /* Reclaim the space of written data */
+    if (data_pos == data.size())
+    {
+        data.clear();
+        data_pos = 0;
+    }
+    else if (data_pos > (1 << 20) && data_pos > data.size() / 2)
+    {
+        data.erase(data.begin(), data.begin() + data_pos);
+        data_pos = 0;
+    }
+
+    return true;
+}
+
+Uint64 link_emu_t::get_time_to_next_release(const params_t& params, const Uint64 tick_ns) const
+{
+    if (segments.empty())
+        return SDL_MAX_UINT64;
+
+    const segment_t& seg = segments.front();
+    if (seg.release_tick > tick_ns)
+        return seg.release_tick - tick_ns;
+
+    if (!params.bandwidth)
+        return 0;
+
+    /* Wait until either the whole segment or a full bucket can be written, to avoid lots of tiny writes */
+    const double wanted = SDL_min(double(seg.len), double(SDL_max(params.burst, 1u)));
+    if (tokens >= wanted)
+        return 0;
+
+    return Uint64((wanted - tokens) * 1000000000.0 / double(params.bandwidth));
+}
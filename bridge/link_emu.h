@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "shared/sdl_net/include/SDL3_net/SDL_net.h"
+#include <SDL3/SDL_stdinc.h>
+
+#include <deque>
+#include <vector>
+
+/**
+ * One direction of an emulated network link
+ *
+ * Written data is held in a delay queue until its release time (latency + jitter),
+ * and is then written to the socket at a rate limited by a token bucket (bandwidth + burst)
+ */
+struct link_emu_t
+{
+    struct params_t
+    {
+        /** Fixed delay (milliseconds) */
+        Uint32 latency = 0;
+
+        /** Maximum random extra delay (milliseconds), data is never reordered */
+        Uint32 jitter = 0;
+
+        /** Bandwidth cap (bytes/second), 0 for unlimited */
+        Uint32 bandwidth = 0;
+
+        /** Maximum number of bytes that can be sent at once after the link was idle */
+        Uint32 burst = 0;
+
+        inline bool is_active() const { return latency || jitter || bandwidth; }
+    };
+
+    /**
+     * Queues data for sock, or writes it immediately if nothing is emulated and nothing is queued
+     *
+     * @param sock Socket to write to
+     * @param data Data to send
+     * @param len Length of data
+     * @param params Link parameters
+     * @param tick_ns Current time (SDL_GetTicksNS())
+     *
+     * @returns False if writing to sock failed
+     */
+    bool send(SDLNet_StreamSocket* const sock, const Uint8* const data, const size_t len, const params_t& params, const Uint64 tick_ns);
+
+    /**
+     * Writes out all queued data that has been released and fits in the bandwidth budget
+     *
+     * @param sock Socket to write to
+     * @param params Link parameters
+     * @param tick_ns Current time (SDL_GetTicksNS())
+     *
+     * @returns False if writing to sock failed
+     */
+    bool pump(SDLNet_StreamSocket* const sock, const params_t& params, const Uint64 tick_ns);
+
+    /**
+     * Returns the time until link_emu_t::pump() can write more data (nanoseconds), or UINT64_MAX if nothing is queued
+     */
+    Uint64 get_time_to_next_release(const params_t& params, const Uint64 tick_ns) const;
+
+    /**
+     * Returns the number of bytes waiting in the delay queue
+     */
+    inline size_t get_bytes_queued() const { return data.size() - data_pos; }
+
+private:
+    struct segment_t
+    {
+        Uint64 release_tick;
+        size_t len;
+    };
+
+    std::deque<segment_t> segments;
+
+    std::vector<Uint8> data;
+    size_t data_pos = 0;
+
+    /** Release time of the most recently queued segment, used to keep jittered segments in order */
+    Uint64 last_release_tick = 0;
+
+    double tokens = 0.0;
+    Uint64 last_refill_tick = 0;
+};
@@ -35,18 +35,27 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <deque>
 #include <string>
 #include <vector>
 
 #include "tetra/log.h"
 #include "tetra/tetra_core.h"
+#ifndef MCS_B181_BRIDGE_HEADLESS
 #include "tetra/tetra_sdl_gpu.h"
+#endif
 #include "tetra/util/convar.h"
 
 #include "shared/build_info.h"
 #include "shared/misc.h"
 #include "shared/packet.h"
 
+#include "shared/capture.h"
+
+#include "entity_tracker.h"
+#include "link_emu.h"
+
 /**
  * We use this in timestamp_from_tick() to ensure it's output is stable
  */
@@ -106,14 +115,83 @@ void kick_sock(SDLNet_StreamSocket* sock, std::string reason, bool log = true)
     SDLNet_UnrefAddress(client_addr);
 }
 
+enum packet_source_t
+{
+    PACKET_SOURCE_ALL,
+    PACKET_SOURCE_CLIENT,
+    PACKET_SOURCE_SERVER,
+};
+
+static inline bool packet_source_matches(const packet_source_t source, const capture_t::index_entry_t& entry)
+{
+    if (source == PACKET_SOURCE_ALL)
+        return true;
+    return (source == PACKET_SOURCE_CLIENT) == bool(entry.from_client);
+}
+
 struct packet_viewer_dat_t
 {
-    packet_viewer_dat_t() { default_filters(); }
+    packet_viewer_dat_t()
+    {
+        default_filters();
+        memset(index_filters, 0, ARR_SIZE(index_filters));
+    }
     size_t sel = -1;
     bool filters[256];
     bool force_scroll = true;
     bool select_recent = false;
 
+    /** Decoded copy of the selected packet */
+    packet_t* sel_pack = NULL;
+    size_t sel_pack_idx = CAPTURE_IDX_NONE;
+
+    /** Capture indices of the packets in the window matching the filters, oldest first (32 bits is ~100 GiB of capture index) */
+    std::deque<Uint32> index;
+
+    /** Number of capture entries already examined for index */
+    size_t index_scanned = 0;
+
+    /** Filters that index was built with */
+    bool index_filters[256];
+
+    /**
+     * Brings index up to date with the capture
+     *
+     * Only entries added since the last call are examined, unless the filters changed,
+     * in which case only the window is examined again
+     *
+     * @param window Number of most recent capture entries to index
+     */
+    void update_index(capture_t& capture, const packet_source_t source, const size_t window)
+    {
+        if (memcmp(filters, index_filters, sizeof(filters)))
+        {
+            memcpy(index_filters, filters, sizeof(filters));
+            index.clear();
+            index_scanned = 0;
+        }
+
+        const size_t num_packs = capture.size();
+        const size_t window_start = num_packs > window ? num_packs - window : 0;
+
+        while (index.size() && index.front() < window_start)
+            index.pop_front();
+
+        for (index_scanned = SDL_max(index_scanned, window_start); index_scanned < num_packs; index_scanned++)
+        {
+            capture_t::index_entry_t entry = capture.get_entry(index_scanned);
+            if (filters[entry.id] && packet_source_matches(source, entry))
+                index.push_back(index_scanned);
+        }
+    }
+
+    void free_sel_pack()
+    {
+        delete sel_pack;
+        sel_pack = NULL;
+        sel_pack_idx = CAPTURE_IDX_NONE;
+    }
+
     void default_filters()
     {
         memset(filters, 1, ARR_SIZE(filters));
@@ -121,6 +199,93 @@ struct packet_viewer_dat_t
     }
 };
 
+/**
+ * Packet count and size over a sliding time window, maintained as packets arrive
+ */
+struct packet_window_t
+{
+    struct sample_t
+    {
+        Uint64 tick;
+        size_t len;
+    };
+
+    std::deque<sample_t> samples;
+
+    size_t num_bytes = 0;
+
+    /**
+     * Adds a packet and drops every packet older than max_diff relative to it
+     */
+    void add(const Uint64 tick, const size_t len, const Uint64 max_diff)
+    {
+        samples.push_back({ tick, len });
+        num_bytes += len;
+
+        expire(tick, max_diff);
+    }
+
+    /**
+     * Drops every packet older than max_diff relative to tick_now
+     */
+    void expire(const Uint64 tick_now, const Uint64 max_diff)
+    {
+        while (samples.size() && tick_now - samples.front().tick >= max_diff)
+        {
+            num_bytes -= samples.front().len;
+            samples.pop_front();
+        }
+    }
+
+    /**
+     * Returns the time between the oldest packet in the window and tick_now
+     */
+    inline Uint64 get_tick_diff(const Uint64 tick_now) const { return samples.size() ? tick_now - samples.front().tick : 0; }
+};
+
+/**
+ * Per packet id totals and sliding windows for one direction
+ */
+struct packet_type_stats_t
+{
+    packet_window_t windows[256];
+    size_t total_packets[256] = {};
+    size_t total_bytes[256] = {};
+
+    void add(const Uint8 id, const Uint64 tick, const size_t len, const Uint64 max_diff)
+    {
+        windows[id].add(tick, len, max_diff);
+        total_packets[id]++;
+        total_bytes[id] += len;
+    }
+
+    /**
+     * Drops old packets from the windows of ids that have not been seen recently
+     */
+    void expire(const Uint64 tick_now, const Uint64 max_diff)
+    {
+        for (int i = 0; i < 256; i++)
+            windows[i].expire(tick_now, max_diff);
+    }
+};
+
+#define PACKET_TYPE_CSV_HEADER "time,client,source,id,name,packets_per_sec,bytes_per_sec,share,total_packets,total_bytes\n"
+
+/**
+ * A row of the packet type breakdown
+ */
+struct packet_type_row_t
+{
+    bool from_client;
+    Uint8 id;
+    double packets_per_sec;
+    double bytes_per_sec;
+    /** Fraction of the bytes in the windows of both directions */
+    double share;
+    size_t total_packets;
+    size_t total_bytes;
+};
+
 #define TABLE_VALUE(fmt, ...)            \
     do                                   \
     {                                    \
@@ -146,67 +311,64 @@ struct packet_viewer_dat_t
 #define TABLE_FIELD_STRING(x) TABLE_FIELD(#x ": ", "\"%s\"", x.c_str())
 #define TABLE_FIELD_CSTRING(x) TABLE_FIELD(#x ": ", "\"%s\"", x)
 
+/* History limits, these keep the memory use of long running connections constant */
+static convar_int_t bridge_history_chat("bridge_history_chat", 1024, 16, 1048576, "Maximum number of chat messages kept per connection");
+static convar_int_t bridge_history_entities(
+    "bridge_history_entities", 4096, 16, 1048576, "Maximum number of destroyed entities kept per connection (Live entities are always kept)");
+static convar_int_t bridge_history_players(
+    "bridge_history_players", 256, 16, 1048576, "Maximum number of offline players kept per connection (Online players are always kept)");
+static convar_int_t bridge_packet_viewer_window("bridge_packet_viewer_window", 262144, 1024, 16777216,
+    "Number of most recent packets listed by the packet viewers (Older packets stay in the capture)");
+static convar_int_t bridge_analysis_backlog(
+    "bridge_analysis_backlog", 16384, 64, 1048576, "Stop reading from a connection while this much forwarded data is waiting to be decoded (KiB)");
+
 struct chat_t
 {
-    std::string* msg;
+    std::string msg;
     bool sent_by_client;
 };
 
-struct entity_info_t
+/**
+ * Draws a table with the state of an entity, followed by the packets that created and destroyed it
+ */
+static void draw_entity_info(const entity_info_t& ent, capture_t& capture)
 {
-    int eid = 0;
-
-    int pos_x = 0;
-    int pos_y = 0;
-    int pos_z = 0;
-
-    int vel_x = 0;
-    int vel_y = 0;
-    int vel_z = 0;
-
-    jbyte yaw = 0;
-    jbyte pitch = 0;
-    jbyte roll = 0;
-
-    packet_t* pack_creation = NULL;
-    packet_t* pack_destruction = NULL;
-    std::string name;
-
-    void draw_imgui()
+    if (ImGui::BeginTable("Current Players Table", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
     {
-        if (ImGui::BeginTable("Current Players Table", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
-        {
-            ImGui::TableSetupColumn("Field", ImGuiTableColumnFlags_WidthFixed, ImGui::CalcTextSize("x").x * 18);
-            ImGui::TableSetupColumn("Value", ImGuiTableColumnFlags_WidthStretch);
-            ImGui::TableHeadersRow();
+        ImGui::TableSetupColumn("Field", ImGuiTableColumnFlags_WidthFixed, ImGui::CalcTextSize("x").x * 18);
+        ImGui::TableSetupColumn("Value", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
 
-            if (pack_creation)
-                TABLE_FIELD("Created: ", "%s", timestamp_from_tick(pack_creation->assemble_tick).c_str());
+        if (ent.pack_creation != CAPTURE_IDX_NONE)
+            TABLE_FIELD("Created: ", "%s", timestamp_from_tick(ent.tick_creation).c_str());
 
-            if (pack_destruction)
-                TABLE_FIELD("Destroyed: ", "%s", timestamp_from_tick(pack_destruction->assemble_tick).c_str());
+        if (ent.pack_destruction != CAPTURE_IDX_NONE)
+            TABLE_FIELD("Destroyed: ", "%s", timestamp_from_tick(ent.tick_destruction).c_str());
 
-            if (name.length())
-                TABLE_FIELD("Name", "%s", name.c_str());
-            TABLE_FIELD("pos: ", "<%.2f, %.2f, %.2f>", (float)pos_x / 32, (float)pos_y / 32, (float)pos_z / 32);
-            TABLE_FIELD("vel: ", "<%.2f, %.2f, %.2f>", (float)vel_x / (32000 / 5), (float)vel_y / (32000 / 5), (float)vel_z / (32000 / 5));
+        if (ent.name.length())
+            TABLE_FIELD("Name", "%s", ent.name.c_str());
+        TABLE_FIELD("pos: ", "<%.2f, %.2f, %.2f>", (float)ent.pos_x / 32, (float)ent.pos_y / 32, (float)ent.pos_z / 32);
+        TABLE_FIELD("vel: ", "<%.2f, %.2f, %.2f>", (float)ent.vel_x / (32000 / 5), (float)ent.vel_y / (32000 / 5), (float)ent.vel_z / (32000 / 5));
 
-            ImGui::EndTable();
-        }
+        ImGui::EndTable();
+    }
 
-        if (pack_creation)
-        {
-            ImGui::SeparatorText("Packet Creation");
-            pack_creation->draw_imgui();
-        }
+    packet_t* pack = NULL;
 
-        if (pack_destruction)
-        {
-            ImGui::SeparatorText("Packet Destruction");
-            pack_destruction->draw_imgui();
-        }
+    if (ent.pack_creation != CAPTURE_IDX_NONE && (pack = capture.decode(ent.pack_creation)))
+    {
+        ImGui::SeparatorText("Packet Creation");
+        pack->draw_imgui();
+        delete pack;
     }
-};
+
+    if (ent.pack_destruction != CAPTURE_IDX_NONE && (pack = capture.decode(ent.pack_destruction)))
+    {
+        ImGui::SeparatorText("Packet Destruction");
+        pack->draw_imgui();
+        delete pack;
+    }
+}
 
 struct world_diag_t
 {
@@ -252,17 +414,46 @@ public:
     Uint64 keep_alive_time_from_client = 0;
     Uint64 keep_alive_time_from_server = 0;
 
-    std::vector<chat_t> chat_history;
+    /** Most recent chat messages (See: bridge_history_chat) */
+    std::deque<chat_t> chat_history;
+
+    /** Number of chat messages ever received, including those dropped from chat_history */
+    size_t chat_total = 0;
+
     char chat_buf[101] = "";
     bool send_chat = false;
 
-    std::vector<packet_play_list_item_t*> player_list;
+    /**
+     * Chat messages can only be injected when the bridge knows where packet boundaries are (ie. not in passthrough mode)
+     */
+    bool can_send_chat = true;
+
+    std::vector<packet_play_list_item_t> player_list;
 
-    std::vector<entity_info_t> entities;
+    /** Live entities and the most recently destroyed ones (See: bridge_history_entities) */
+    entity_tracker_t entity_tracker;
+
+    /**
+     * Adds a chat message, dropping the oldest one if the history is full
+     */
+    void add_chat(const std::string& msg, const bool sent_by_client)
+    {
+        chat_history.push_back({ msg, sent_by_client });
+        chat_total++;
+        while (chat_history.size() > size_t(bridge_history_chat.get()))
+            chat_history.pop_front();
+    }
 
 #define CAST_PACK_TO_P(type) type* p = (type*)pack
-    void feed_packet_from_server(packet_t* pack)
+    /**
+     * @param pack Packet to process
+     * @param pack_idx Capture index of the packet
+     */
+    void feed_packet_from_server(packet_t* pack, const size_t pack_idx)
     {
+        if (entity_tracker.feed_packet_from_server(pack, pack_idx, size_t(bridge_history_entities.get())))
+            return;
+
         switch (pack->id)
         {
         case PACKET_ID_KEEP_ALIVE:
@@ -292,7 +483,7 @@ public:
         case PACKET_ID_CHAT_MSG:
         {
             CAST_PACK_TO_P(packet_chat_message_t);
-            chat_history.push_back({ &p->msg, 0 });
+            add_chat(p->msg, 0);
             break;
         }
         case PACKET_ID_PLAYER_POS_LOOK:
@@ -308,13 +499,17 @@ public:
             break;
         }
         default:
-            feed_packet_common(pack);
+            feed_packet_common(pack, pack_idx);
             break;
         }
         tick();
     }
 
-    void feed_packet_from_client(packet_t* pack)
+    /**
+     * @param pack Packet to process
+     * @param pack_idx Capture index of the packet
+     */
+    void feed_packet_from_client(packet_t* pack, const size_t pack_idx)
     {
         switch (pack->id)
         {
@@ -339,7 +534,7 @@ public:
         case PACKET_ID_CHAT_MSG:
         {
             CAST_PACK_TO_P(packet_chat_message_t);
-            chat_history.push_back({ &p->msg, 1 });
+            add_chat(p->msg, 1);
             break;
         }
         case PACKET_ID_PLAYER_POS_LOOK:
@@ -355,7 +550,7 @@ public:
             break;
         }
         default:
-            feed_packet_common(pack);
+            feed_packet_common(pack, pack_idx);
             break;
         }
         tick();
@@ -415,7 +610,7 @@ public:
     }
 
     bool chat_auto_scroll = true;
-    size_t last_chat_history_size = 0;
+    size_t last_chat_total = 0;
 
     void draw_imgui_chat()
     {
@@ -430,14 +625,14 @@ public:
 
             for (size_t i = 0; i < chat_history.size(); i++)
             {
-                chat_t c = chat_history[i];
-                TABLE_FIELD(c.sent_by_client ? "Client: " : "Server: ", "%s", c.msg->c_str());
+                const chat_t& c = chat_history[i];
+                TABLE_FIELD(c.sent_by_client ? "Client: " : "Server: ", "%s", c.msg.c_str());
             }
 
-            if (chat_auto_scroll && last_chat_history_size != chat_history.size())
+            if (chat_auto_scroll && last_chat_total != chat_total)
                 ImGui::SetScrollHereY(0.0f);
 
-            last_chat_history_size = chat_history.size();
+            last_chat_total = chat_total;
 
             ImGui::EndTable();
         list_box_end:
@@ -445,9 +640,11 @@ public:
         }
 
         ImGuiInputTextFlags flags = ImGuiInputTextFlags_EnterReturnsTrue;
-        flags |= send_chat ? ImGuiInputTextFlags_ReadOnly : 0;
-        if (ImGui::InputText("##chat input", chat_buf, ARR_SIZE(chat_buf), flags))
+        flags |= (send_chat || !can_send_chat) ? ImGuiInputTextFlags_ReadOnly : 0;
+        if (ImGui::InputText("##chat input", chat_buf, ARR_SIZE(chat_buf), flags) && can_send_chat)
             send_chat = true;
+        if (!can_send_chat)
+            ImGui::SetItemTooltip("Sending chat messages is not possible in passthrough mode");
 
         ImGui::SameLine();
         ImGui::Text("%zu/%zu", strlen(chat_buf), ARR_SIZE(chat_buf) - 1);
@@ -455,9 +652,8 @@ public:
 
     bool ent_viewer_force_scroll = false;
     bool ent_viewer_no_destroyed = true;
-    size_t ent_viewer_sel = -1;
 
-    void draw_imgui_entities()
+    void draw_imgui_entities(capture_t& capture)
     {
         ImGui::Checkbox("Force Scroll", &ent_viewer_force_scroll);
         ImGui::SameLine();
@@ -474,9 +670,9 @@ public:
         {
             float text_spacing = ImGui::GetTextLineHeightWithSpacing();
 
-            for (size_t i = 0; i < entities.size(); i++)
+            for (size_t i = 0; i < entity_tracker.entities.size(); i++)
             {
-                if (ent_viewer_no_destroyed && entities[i].pack_destruction)
+                if (ent_viewer_no_destroyed && entity_tracker.entities[i].pack_destruction != CAPTURE_IDX_NONE)
                     continue;
                 ImGui::PushID(i);
                 char buf[56] = "";
@@ -485,34 +681,12 @@ public:
                     ImGui::Spacing();
                 else
                 {
-                    if (entities[i].pack_creation)
-                    {
-                        packet_t* pack = entities[i].pack_creation;
-                        const char* name = NULL;
-                        switch (pack->id)
-                        {
-                        case PACKET_ID_ENT_SPAWN_MOB:
-                        {
-                            CAST_PACK_TO_P(packet_ent_spawn_mob_t);
-                            name = mc_id::get_name_mob(p->mob_type);
-                            break;
-                        }
-                        case PACKET_ID_ADD_OBJ:
-                        {
-                            CAST_PACK_TO_P(packet_add_obj_t);
-                            name = mc_id::get_name_vehicle(p->obj_type);
-                            break;
-                        }
-                        default:
-                            name = entities[i].pack_creation->get_name();
-                            break;
-                        }
-                        snprintf(buf, ARR_SIZE(buf), "(%s)", name);
-                    }
-                    snprintf(buf2, ARR_SIZE(buf2), "eid[%d]: %s", entities[i].eid, buf);
+                    if (entity_tracker.entities[i].type_name)
+                        snprintf(buf, ARR_SIZE(buf), "(%s)", entity_tracker.entities[i].type_name);
+                    snprintf(buf2, ARR_SIZE(buf2), "eid[%d]: %s", entity_tracker.entities[i].eid, buf);
 
-                    if (ImGui::Selectable(buf2, ent_viewer_sel == i))
-                        ent_viewer_sel = i;
+                    if (ImGui::Selectable(buf2, entity_tracker.sel == i))
+                        entity_tracker.sel = i;
                 }
 
                 ImGui::PopID();
@@ -532,8 +706,8 @@ public:
             return;
         }
 
-        if (ent_viewer_sel < entities.size())
-            entities[ent_viewer_sel].draw_imgui();
+        if (entity_tracker.sel < entity_tracker.entities.size())
+            draw_entity_info(entity_tracker.entities[entity_tracker.sel], capture);
         else
         {
             PACKET_NEW_TABLE_CHOICE_IF("blank_table", goto skip_end_table;);
@@ -558,7 +732,7 @@ public:
 
             for (size_t i = 0; i < player_list.size(); i++)
             {
-                packet_play_list_item_t* p = player_list[i];
+                packet_play_list_item_t* p = &player_list[i];
                 if (!p->online)
                     continue;
                 ImGui::TableNextRow();
@@ -585,7 +759,7 @@ public:
 
             for (size_t i = 0; i < player_list.size(); i++)
             {
-                packet_play_list_item_t* p = player_list[i];
+                packet_play_list_item_t* p = &player_list[i];
                 if (p->online)
                     continue;
                 ImGui::TableNextRow();
@@ -633,7 +807,7 @@ private:
 
     void tick_real() { time++; }
 
-    void feed_packet_common(packet_t* pack)
+    void feed_packet_common(packet_t* pack, const size_t pack_idx)
     {
         switch (pack->id)
         {
@@ -708,374 +882,617 @@ private:
 
             size_t i = 0;
             for (i = 0; i < player_list.size(); i++)
-            {
-                if (player_list[i]->username == p->username)
-                {
-                    player_list[i] = p;
+                if (player_list[i].username == p->username)
                     break;
-                }
-            }
-
-            player_list.push_back(p);
-
-            break;
-        }
-        case PACKET_ID_ENT_SPAWN_NAMED:
-        {
-            CAST_PACK_TO_P(packet_ent_spawn_named_t);
 
-            entity_info_t t;
-            t.eid = p->eid;
-            t.pos_x = p->x;
-            t.pos_y = p->y;
-            t.pos_z = p->z;
-            t.yaw = p->rotation;
-            t.pitch = p->pitch;
-            t.pack_creation = p;
+            if (i < player_list.size())
+                player_list[i] = *p;
+            else
+                player_list.push_back(*p);
 
-            for (size_t i = 0; i < entities.size(); i++)
+            /* Offline players are kept for the previous players table, the one seen the longest ago is dropped once there are too many */
+            if (!p->online)
             {
-                if (entities[i].eid == p->eid)
+                size_t num_offline = 0;
+                size_t oldest = player_list.size();
+                for (i = 0; i < player_list.size(); i++)
                 {
-                    entities[i] = t;
-                    break;
+                    if (player_list[i].online)
+                        continue;
+                    num_offline++;
+                    if (oldest == player_list.size() || player_list[i].assemble_tick < player_list[oldest].assemble_tick)
+                        oldest = i;
                 }
-            }
 
-            entities.push_back(t);
+                if (num_offline > size_t(bridge_history_players.get()))
+                    player_list.erase(player_list.begin() + oldest);
+            }
 
             break;
         }
-        case PACKET_ID_ENT_SPAWN_PICKUP:
-        {
-            CAST_PACK_TO_P(packet_ent_spawn_pickup_t);
+        }
+    }
+};
 
-            entity_info_t t;
-            t.eid = p->eid;
-            t.pos_x = p->x;
-            t.pos_y = p->y;
-            t.pos_z = p->z;
-            t.yaw = p->rotation;
-            t.pitch = p->pitch;
-            t.roll = p->roll;
-            t.pack_creation = p;
+static convar_int_t bridge_passthrough {
+    "bridge_passthrough",
+    1,
+    0,
+    1,
+    "Forward raw bytes between the sockets and decode packets on a separate analysis thread (Only applies to new connections)",
+    CONVAR_FLAG_INT_IS_BOOL,
+};
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i] = t;
-                    break;
-                }
-            }
+static convar_int_t bridge_verify_bytes {
+    "bridge_verify_bytes",
+    0,
+    0,
+    1,
+    "Compare the re-serialized form of every packet decoded in passthrough mode against the bytes that were forwarded",
+    CONVAR_FLAG_INT_IS_BOOL,
+};
 
-            entities.push_back(t);
+static convar_string_t bridge_capture_dir("bridge_capture_dir", "captures", "Directory to write packet captures to");
+
+/* Link emulation, "to_server" applies to data sent by the client and "to_client" applies to data sent by the server */
+static convar_int_t bridge_link_latency_to_server("bridge_link_latency_to_server", 0, 0, 60000, "Emulated latency of data sent to the server (milliseconds)");
+static convar_int_t bridge_link_latency_to_client("bridge_link_latency_to_client", 0, 0, 60000, "Emulated latency of data sent to the client (milliseconds)");
+static convar_int_t bridge_link_jitter_to_server("bridge_link_jitter_to_server", 0, 0, 60000, "Maximum emulated jitter of data sent to the server (milliseconds)");
+static convar_int_t bridge_link_jitter_to_client("bridge_link_jitter_to_client", 0, 0, 60000, "Maximum emulated jitter of data sent to the client (milliseconds)");
+static convar_int_t bridge_link_bandwidth_to_server(
+    "bridge_link_bandwidth_to_server", 0, 0, 1048576, "Bandwidth cap of data sent to the server (KiB/s) [0: Unlimited]");
+static convar_int_t bridge_link_bandwidth_to_client(
+    "bridge_link_bandwidth_to_client", 0, 0, 1048576, "Bandwidth cap of data sent to the client (KiB/s) [0: Unlimited]");
+static convar_int_t bridge_link_burst_to_server("bridge_link_burst_to_server", 16, 1, 1048576, "Burst limit of data sent to the server (KiB)");
+static convar_int_t bridge_link_burst_to_client("bridge_link_burst_to_client", 16, 1, 1048576, "Burst limit of data sent to the client (KiB)");
+static convar_int_t bridge_link_queue_limit(
+    "bridge_link_queue_limit", 4096, 1, 1048576, "Stop reading from a socket while the emulated link it feeds has this much queued (KiB)");
+static convar_int_t bridge_link_packet_loss(
+    "bridge_link_packet_loss", 0, 0, 100, "Percent chance of a simulated lost packet (Passed to SDLNet_SimulateStreamPacketLoss(), only applies to new connections)");
 
-            break;
-        }
-        case PACKET_ID_ADD_OBJ:
-        {
-            CAST_PACK_TO_P(packet_add_obj_t);
+/**
+ * Returns the current link emulation parameters for one direction
+ */
+static link_emu_t::params_t get_link_params(const bool to_server)
+{
+    link_emu_t::params_t params;
+    params.latency = (to_server ? bridge_link_latency_to_server : bridge_link_latency_to_client).get();
+    params.jitter = (to_server ? bridge_link_jitter_to_server : bridge_link_jitter_to_client).get();
+    params.bandwidth = (to_server ? bridge_link_bandwidth_to_server : bridge_link_bandwidth_to_client).get() * 1024;
+    params.burst = (to_server ? bridge_link_burst_to_server : bridge_link_burst_to_client).get() * 1024;
+    return params;
+}
 
-            entity_info_t t;
-            t.eid = p->eid;
-            t.pos_x = p->x;
-            t.pos_y = p->y;
-            t.pos_z = p->z;
-            t.pack_creation = p;
+/**
+ * Set by the analysis thread when a client sends "/stop_bridge"
+ */
+static SDL_AtomicInt stop_requested;
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i] = t;
-                    break;
-                }
-            }
+/**
+ * A run of bytes read from one side of a connection
+ */
+struct raw_segment_t
+{
+    Uint64 tick;
+    Uint32 len;
+    bool from_client;
 
-            entities.push_back(t);
+    /**
+     * Packet already decoded by the I/O thread (Re-serialize mode), NULL if the analysis thread must decode the bytes
+     */
+    packet_t* pack;
+};
 
-            break;
-        }
-        case PACKET_ID_ENT_ENSURE_SPAWN:
-        {
-            CAST_PACK_TO_P(packet_ent_create_t);
+struct client_t
+{
+    /**
+     * Socket obtained from the server component of the bridge
+     *
+     * NOTE: The sockets and packet handlers of live connections are owned by the I/O thread
+     */
+    SDLNet_StreamSocket* sock_to_client = NULL;
 
-            entity_info_t t;
-            t.eid = p->eid;
-            t.pack_creation = p;
+    /**
+     * Socket created to connect to the real server
+     */
+    SDLNet_StreamSocket* sock_to_server = NULL;
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i] = t;
-                    break;
-                }
-            }
+    packet_handler_t pack_handler_client = packet_handler_t(true);
 
-            entities.push_back(t);
+    packet_handler_t pack_handler_server = packet_handler_t(false);
 
-            break;
-        }
-        case PACKET_ID_ENT_SPAWN_MOB:
-        {
-            CAST_PACK_TO_P(packet_ent_spawn_mob_t);
+    /**
+     * If set, bytes are copied straight between the sockets and packets are only decoded by the analysis thread,
+     * otherwise every packet is parsed and re-assembled on the forwarding path
+     */
+    bool passthrough = false;
 
-            entity_info_t t;
-            t.eid = p->eid;
-            t.pos_x = p->x;
-            t.pos_y = p->y;
-            t.pos_z = p->z;
-            t.yaw = p->yaw;
-            t.pitch = p->pitch;
-            t.pack_creation = p;
+    /**
+     * Guards raw_bytes, raw_segments, and pending_chat
+     *
+     * This is separate from client_t::lock so that forwarding never waits on decoding or drawing
+     */
+    SDL_Mutex* raw_lock = NULL;
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i] = t;
-                    break;
-                }
-            }
+    /** Bytes forwarded but not yet decoded (See: bridge_analysis_backlog) */
+    std::vector<Uint8> raw_bytes;
+    std::vector<raw_segment_t> raw_segments;
 
-            entities.push_back(t);
+    /** Chat messages queued by the GUI for the I/O thread to send to the server */
+    std::vector<std::string> pending_chat;
 
-            break;
-        }
-        case PACKET_ID_ENT_SPAWN_PAINTING:
-        {
-            CAST_PACK_TO_P(packet_ent_spawn_painting_t);
+    /** Emulated links, only accessed by the I/O thread */
+    link_emu_t link_to_server;
+    link_emu_t link_to_client;
 
-            entity_info_t t;
-            t.eid = p->eid;
-            t.pos_x = p->center_x;
-            t.pos_y = p->center_y;
-            t.pos_z = p->center_z;
-            t.pack_creation = p;
+    /** Analysis thread copies of raw_bytes and raw_segments, kept around to reuse their allocations */
+    std::vector<Uint8> analysis_bytes;
+    std::vector<raw_segment_t> analysis_segments;
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i] = t;
-                    break;
-                }
-            }
+    /**
+     * Guards the decoded data (packet lists, world_diag, stats)
+     */
+    SDL_Mutex* lock = NULL;
 
-            entities.push_back(t);
+    size_t bytes_forwarded_from_client = 0;
+    size_t bytes_forwarded_from_server = 0;
 
-            break;
-        }
-        case PACKET_ID_ENT_SPAWN_XP:
-        {
-            CAST_PACK_TO_P(packet_ent_spawn_xp_t);
+    /** Number of decoded packets where packet_t::assemble() did not reproduce the forwarded bytes (see bridge_verify_bytes) */
+    size_t verify_mismatches = 0;
+    size_t verify_checked = 0;
 
-            entity_info_t t;
-            t.eid = p->eid;
-            t.pos_x = p->x;
-            t.pos_y = p->y;
-            t.pos_z = p->z;
-            t.pack_creation = p;
+    /** Set when the analysis thread fails to decode a stream, forwarding continues regardless */
+    std::string analysis_error;
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i] = t;
-                    break;
-                }
-            }
+    Uint64 time_init = 0;
 
-            entities.push_back(t);
+    /** Tick of the most recently analyzed data */
+    Uint64 time_last_read = 0;
 
-            break;
-        }
-        case PACKET_ID_THUNDERBOLT:
-        {
-            CAST_PACK_TO_P(packet_thunder_t);
+    /** Tick of the most recently forwarded data, only accessed by the I/O thread */
+    Uint64 io_time_last_read = 0;
 
-            entity_info_t t;
-            t.eid = p->eid;
-            t.pos_x = p->x;
-            t.pos_y = p->y;
-            t.pos_z = p->z;
-            t.pack_creation = p;
+    /** Set once the connection is closed, only accessed by the I/O thread */
+    bool skip = 0;
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i] = t;
-                    break;
-                }
-            }
+    /**
+     * Every packet of the connection, packets are only kept in memory long enough to feed them to world_diag
+     */
+    capture_t capture;
 
-            entities.push_back(t);
+    size_t num_packs_from_client = 0;
+    size_t num_packs_from_server = 0;
 
-            break;
-        }
-        case PACKET_ID_ENT_VELOCITY:
-        {
-            CAST_PACK_TO_P(packet_ent_velocity_t);
+    /** Statistics for the last 10 seconds, indexed by packet_source_t */
+    packet_window_t packet_windows[3];
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i].vel_x = p->vel_x;
-                    entities[i].vel_y = p->vel_y;
-                    entities[i].vel_z = p->vel_z;
-                    break;
-                }
-            }
-            break;
-        }
-        case PACKET_ID_ENT_MOVE_REL:
-        {
-            CAST_PACK_TO_P(packet_ent_move_rel_t);
+    /** Per packet id statistics, index 0 is from the server and index 1 is from the client */
+    packet_type_stats_t packet_type_stats[2];
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i].pos_x += p->delta_x;
-                    entities[i].pos_y += p->delta_y;
-                    entities[i].pos_z += p->delta_z;
-                    break;
-                }
-            }
-            break;
-        }
-        case PACKET_ID_ENT_LOOK:
-        {
-            CAST_PACK_TO_P(packet_ent_look_t);
+    /** Values at the previous client_t::dump_stats() call */
+    size_t stats_last_num_packs_from_client = 0;
+    size_t stats_last_num_packs_from_server = 0;
+    size_t stats_last_bytes_from_client = 0;
+    size_t stats_last_bytes_from_server = 0;
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i].yaw = p->yaw;
-                    entities[i].pitch = p->pitch;
-                    break;
-                }
-            }
-            break;
-        }
-        case PACKET_ID_ENT_LOOK_MOVE_REL:
-        {
-            CAST_PACK_TO_P(packet_ent_look_move_rel_t);
+    /**
+     * Set for captures opened from disk, the analysis thread feeds their packets to world_diag in the background
+     */
+    bool offline = false;
+    size_t offline_replay_pos = 0;
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i].pos_x += p->delta_x;
-                    entities[i].pos_y += p->delta_y;
-                    entities[i].pos_z += p->delta_z;
-                    entities[i].yaw = p->yaw;
-                    entities[i].pitch = p->pitch;
-                    break;
-                }
-            }
-            break;
+    packet_viewer_dat_t packet_viewer_dat_server;
+    packet_viewer_dat_t packet_viewer_dat_client;
+    packet_viewer_dat_t packet_viewer_dat;
+
+    world_diag_t world_diag;
+
+    std::string kick_reason;
+
+    /** Set if the capture could not be created, the connection is still forwarded but nothing is recorded */
+    std::string capture_error;
+
+    client_t()
+    {
+        raw_lock = SDL_CreateMutex();
+        lock = SDL_CreateMutex();
+    }
+
+    /**
+     * Feeds a packet to the world diagnostics and stats
+     *
+     * NOTE: client_t::lock must be held
+     *
+     * @param pack Packet to record
+     * @param pack_idx Capture index of the packet
+     * @param from_client True if the packet was sent by the client
+     * @param len Size of the packet on the wire
+     */
+    void record_packet(packet_t* pack, const size_t pack_idx, const bool from_client, const size_t len)
+    {
+        packet_windows[PACKET_SOURCE_ALL].add(pack->assemble_tick, len, 10000);
+        packet_windows[from_client ? PACKET_SOURCE_CLIENT : PACKET_SOURCE_SERVER].add(pack->assemble_tick, len, 10000);
+        packet_type_stats[from_client].add(pack->id, pack->assemble_tick, len, 10000);
+
+        if (from_client)
+        {
+            world_diag.feed_packet_from_client(pack, pack_idx);
+            num_packs_from_client++;
         }
-        case PACKET_ID_ENT_MOVE_TELEPORT:
+        else
         {
-            CAST_PACK_TO_P(packet_ent_teleport_t);
+            world_diag.feed_packet_from_server(pack, pack_idx);
+            num_packs_from_server++;
+        }
+    }
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i].pos_x = p->x;
-                    entities[i].pos_y = p->y;
-                    entities[i].pos_z = p->z;
-                    entities[i].yaw = p->rotation;
-                    entities[i].pitch = p->pitch;
-                    break;
-                }
-            }
-            break;
+    /**
+     * Captures and records a decoded packet, and then frees it
+     *
+     * NOTE: client_t::lock must be held
+     *
+     * @param pack Packet to add
+     * @param from_client True if the packet was sent by the client
+     * @param wire_data Bytes the packet was decoded from
+     * @param wire_len Length of wire_data
+     */
+    void add_packet(packet_t* pack, const bool from_client, const Uint8* const wire_data, const size_t wire_len)
+    {
+        if (from_client && pack->id == PACKET_ID_CHAT_MSG && ((packet_chat_message_t*)pack)->msg == "/stop_bridge")
+            SDL_SetAtomicInt(&stop_requested, 1);
+
+        const size_t pack_idx = capture.append(pack->assemble_tick, from_client, wire_data, wire_len);
+
+        record_packet(pack, pack_idx, from_client, wire_len);
+
+        delete pack;
+    }
+
+    /**
+     * Feeds the next batch of packets from an opened capture to world_diag
+     *
+     * NOTE: Only call from the analysis thread
+     *
+     * @returns True if there are packets remaining
+     */
+    bool replay_offline()
+    {
+        SDL_LockMutex(lock);
+        for (int i = 0; i < 4096 && offline_replay_pos < capture.size(); i++, offline_replay_pos++)
+        {
+            capture_t::index_entry_t entry = capture.get_entry(offline_replay_pos);
+            packet_t* pack = capture.decode(offline_replay_pos);
+            if (!pack)
+                continue;
+            time_last_read = entry.tick;
+            record_packet(pack, offline_replay_pos, entry.from_client, entry.len);
+            delete pack;
+        }
+        bool ret = offline_replay_pos < capture.size();
+        SDL_UnlockMutex(lock);
+        return ret;
+    }
+
+    /**
+     * Queues forwarded bytes for the analysis thread
+     *
+     * @param pack Packet decoded from data, or NULL if the analysis thread should decode it
+     */
+    void queue_raw(const Uint8* const data, const size_t len, const bool from_client, const Uint64 sdl_tick_cur, packet_t* const pack)
+    {
+        SDL_LockMutex(raw_lock);
+        raw_bytes.insert(raw_bytes.end(), data, data + len);
+        raw_segments.push_back({ sdl_tick_cur, Uint32(len), from_client, pack });
+        SDL_UnlockMutex(raw_lock);
+    }
+
+    /**
+     * Returns true if the analysis thread has fallen behind by more than bridge_analysis_backlog
+     *
+     * Reading stops until it catches up, the same way the emulated links push back on the sender
+     */
+    bool analysis_backlogged()
+    {
+        SDL_LockMutex(raw_lock);
+        const bool ret = raw_bytes.size() >= size_t(bridge_analysis_backlog.get()) * 1024;
+        SDL_UnlockMutex(raw_lock);
+        return ret;
+    }
+
+    /**
+     * Closes both sockets and stops forwarding
+     *
+     * NOTE: Only call from the I/O thread
+     *
+     * @param reason Reason to display
+     * @param send_kick Send a kick packet with the reason to both sides before closing (Only safe on packet boundaries)
+     */
+    void disconnect(const std::string& reason, const bool send_kick)
+    {
+        if (send_kick)
+        {
+            kick_sock(sock_to_client, reason);
+            kick_sock(sock_to_server, reason);
+            SDLNet_WaitUntilStreamSocketDrained(sock_to_client, 100);
+            SDLNet_WaitUntilStreamSocketDrained(sock_to_server, 100);
         }
-        case PACKET_ID_ENT_DESTROY:
+
+        skip = true;
+        SDLNet_DestroyStreamSocket(sock_to_client);
+        SDLNet_DestroyStreamSocket(sock_to_server);
+        sock_to_client = NULL;
+        sock_to_server = NULL;
+
+        SDL_LockMutex(lock);
+        kick_reason = reason;
+        SDL_UnlockMutex(lock);
+    }
+
+    /**
+     * Copies all currently available bytes from src to dst, and queues a copy for the analysis thread
+     *
+     * @returns Number of bytes forwarded, or -1 if either socket failed
+     */
+    int forward_raw(SDLNet_StreamSocket* const src, SDLNet_StreamSocket* const dst, const bool from_client, const Uint64 sdl_tick_cur)
+    {
+        link_emu_t& link = from_client ? link_to_server : link_to_client;
+        const link_emu_t::params_t params = get_link_params(from_client);
+        const size_t queue_limit = size_t(bridge_link_queue_limit.get()) * 1024;
+
+        Uint8 buf[16384];
+        int total = 0;
+        while (1)
         {
-            CAST_PACK_TO_P(packet_ent_destroy_t);
+            /* Leave data in the socket to push back on the sender */
+            if (link.get_bytes_queued() >= queue_limit || analysis_backlogged())
+                break;
 
-            for (size_t i = 0; i < entities.size(); i++)
-            {
-                if (entities[i].eid == p->eid)
-                {
-                    entities[i].pack_destruction = p;
-                    break;
-                }
-            }
+            int len = SDLNet_ReadFromStreamSocket(src, buf, ARR_SIZE(buf));
+            if (len < 0)
+                return -1;
+            if (len == 0)
+                break;
 
-            entity_info_t t;
-            t.eid = p->eid;
-            t.pack_destruction = p;
+            if (!link.send(dst, buf, len, params, SDL_GetTicksNS()))
+                return -1;
 
-            entities.push_back(t);
+            queue_raw(buf, len, from_client, sdl_tick_cur, NULL);
 
-            break;
+            total += len;
+
+            if (len < int(ARR_SIZE(buf)))
+                break;
         }
+
+        return total;
+    }
+
+    /**
+     * Sends data through the emulated link in one direction
+     *
+     * @returns False if the destination socket failed
+     */
+    bool link_send(const bool to_server, const std::vector<Uint8>& dat)
+    {
+        link_emu_t& link = to_server ? link_to_server : link_to_client;
+        return link.send(to_server ? sock_to_server : sock_to_client, dat.data(), dat.size(), get_link_params(to_server), SDL_GetTicksNS());
+    }
+
+    /**
+     * Writes out data released by the emulated links
+     *
+     * NOTE: Only call from the I/O thread
+     *
+     * @param time_to_next_release Set to the smaller of itself and the time until either link can write more (nanoseconds)
+     *
+     * @returns False if the connection was closed
+     */
+    bool pump_links(Uint64& time_to_next_release)
+    {
+        const link_emu_t::params_t params_to_server = get_link_params(true);
+        const link_emu_t::params_t params_to_client = get_link_params(false);
+        const Uint64 tick_ns = SDL_GetTicksNS();
+
+        if (!link_to_server.pump(sock_to_server, params_to_server, tick_ns) || !link_to_client.pump(sock_to_client, params_to_client, tick_ns))
+        {
+            disconnect("Connection closed (emulated link)", false);
+            return false;
         }
+
+        time_to_next_release = SDL_min(time_to_next_release, link_to_server.get_time_to_next_release(params_to_server, tick_ns));
+        time_to_next_release = SDL_min(time_to_next_release, link_to_client.get_time_to_next_release(params_to_client, tick_ns));
+
+        return true;
     }
-};
 
-struct client_t
-{
     /**
-     * Socket obtained from the server component of the bridge
+     * Forwards data in both directions in passthrough mode
+     *
+     * NOTE: Only call from the I/O thread
+     *
+     * @returns True if any bytes were forwarded
      */
-    SDLNet_StreamSocket* sock_to_client = NULL;
+    bool forward_passthrough(const Uint64 sdl_tick_cur)
+    {
+        int from_client = forward_raw(sock_to_client, sock_to_server, true, sdl_tick_cur);
+        int from_server = (from_client < 0) ? -1 : forward_raw(sock_to_server, sock_to_client, false, sdl_tick_cur);
+
+        if (from_client < 0 || from_server < 0)
+        {
+            /* Injecting a kick packet could land in the middle of a packet, so just close both sides */
+            disconnect((from_client < 0) ? "Connection closed (client side)" : "Connection closed (server side)", false);
+            return false;
+        }
+
+        if (from_client > 0 || from_server > 0)
+            io_time_last_read = sdl_tick_cur;
+
+        return from_client > 0 || from_server > 0;
+    }
 
     /**
-     * Socket created to connect to the real server
+     * Parses, re-assembles, and forwards every complete packet in both directions, and sends any queued chat messages
+     *
+     * NOTE: Only call from the I/O thread
+     *
+     * @returns True if any packets were forwarded
      */
-    SDLNet_StreamSocket* sock_to_server = NULL;
+    bool forward_reserialize(const Uint64 sdl_tick_cur)
+    {
+        SDL_LockMutex(raw_lock);
+        std::vector<std::string> chat;
+        std::swap(chat, pending_chat);
+        SDL_UnlockMutex(raw_lock);
 
-    packet_handler_t pack_handler_client = packet_handler_t(true);
+        for (const std::string& msg : chat)
+        {
+            packet_chat_message_t cmsg;
+            cmsg.msg = msg;
+            link_send(true, cmsg.assemble());
+        }
 
-    packet_handler_t pack_handler_server = packet_handler_t(false);
+        const size_t queue_limit = size_t(bridge_link_queue_limit.get()) * 1024;
 
-    Uint64 time_init = 0;
+        bool forwarded = false;
+        bool progress = true;
+        /* Bounded so that one busy connection cannot starve the others */
+        for (int i = 0; i < 256 && progress; i++)
+        {
+            progress = false;
 
-    Uint64 time_last_read = 0;
+            /* Leave data in the sockets to push back on the sender */
+            if (analysis_backlogged())
+                break;
 
-    bool skip = 0;
+            packet_t* pack_from_client = NULL;
+            if (link_to_server.get_bytes_queued() < queue_limit)
+                pack_from_client = pack_handler_client.get_next_packet(sock_to_client);
+            if (pack_from_client)
+            {
+                progress = true;
+                TRACE("Got packet from client: 0x%02x", pack_from_client->id);
+                /* "/stop_bridge" is handled by client_t::add_packet() */
+                if (pack_from_client->id != PACKET_ID_CHAT_MSG || ((packet_chat_message_t*)pack_from_client)->msg != "/stop_bridge")
+                    link_send(true, pack_from_client->assemble());
+
+                pack_from_client->assemble_tick = sdl_tick_cur;
+                const std::vector<Uint8>& data = pack_handler_client.get_last_packet_data();
+                queue_raw(data.data(), data.size(), true, sdl_tick_cur, pack_from_client);
+            }
+            else if (pack_handler_client.get_error().length())
+            {
+                disconnect("Error parsing packet from client: " + pack_handler_client.get_error(), true);
+                return forwarded;
+            }
+
+            packet_t* pack_from_server = NULL;
+            if (link_to_client.get_bytes_queued() < queue_limit)
+                pack_from_server = pack_handler_server.get_next_packet(sock_to_server);
+            if (pack_from_server)
+            {
+                progress = true;
+                TRACE("Got packet from server: 0x%02x", pack_from_server->id);
+                link_send(false, pack_from_server->assemble());
+
+                pack_from_server->assemble_tick = sdl_tick_cur;
+                const std::vector<Uint8>& data = pack_handler_server.get_last_packet_data();
+                queue_raw(data.data(), data.size(), false, sdl_tick_cur, pack_from_server);
+            }
+            else if (pack_handler_server.get_error().length())
+            {
+                disconnect("Error parsing packet from server: " + pack_handler_server.get_error(), true);
+                return forwarded;
+            }
 
-    int change_happened = 0;
+            forwarded |= progress;
+        }
 
-    std::vector<packet_t*> packs_from_client;
+        if (forwarded)
+            io_time_last_read = sdl_tick_cur;
 
-    std::vector<packet_t*> packs_from_server;
+        return forwarded;
+    }
 
-    /* TODO: Store where the packet came from, or at least which handler was used */
-    std::vector<packet_t*> packets;
+    /**
+     * Decodes everything forwarded since the last call
+     *
+     * NOTE: Only call from the analysis thread
+     */
+    void analyze_pending()
+    {
+        SDL_LockMutex(raw_lock);
+        std::swap(raw_bytes, analysis_bytes);
+        std::swap(raw_segments, analysis_segments);
+        SDL_UnlockMutex(raw_lock);
 
-    size_t packets_mem_footprint = 0;
+        if (analysis_segments.empty())
+            return;
 
-    packet_viewer_dat_t packet_viewer_dat_server;
-    packet_viewer_dat_t packet_viewer_dat_client;
-    packet_viewer_dat_t packet_viewer_dat;
+        const bool verify = bridge_verify_bytes.get();
 
-    world_diag_t world_diag;
+        SDL_LockMutex(lock);
+        size_t off = 0;
+        for (raw_segment_t seg : analysis_segments)
+        {
+            packet_handler_t& handler = seg.from_client ? pack_handler_client : pack_handler_server;
+            const Uint8* data = analysis_bytes.data() + off;
+            off += seg.len;
 
-    std::string kick_reason;
+            time_last_read = seg.tick;
+            if (seg.from_client)
+                bytes_forwarded_from_client += seg.len;
+            else
+                bytes_forwarded_from_server += seg.len;
+
+            if (seg.pack)
+            {
+                add_packet(seg.pack, seg.from_client, data, seg.len);
+                continue;
+            }
+
+            if (handler.get_error().length())
+                continue;
+
+            handler.feed_bytes(data, seg.len);
+
+            while (packet_t* pack = handler.get_next_packet())
+            {
+                pack->assemble_tick = seg.tick;
+
+                if (verify)
+                {
+                    verify_checked++;
+                    if (pack->assemble() != handler.get_last_packet_data())
+                        verify_mismatches++;
+                }
+
+                add_packet(pack, seg.from_client, handler.get_last_packet_data().data(), handler.get_last_packet_data().size());
+            }
+
+            if (handler.get_error().length() && !analysis_error.length())
+            {
+                analysis_error = std::string(seg.from_client ? "Client: " : "Server: ") + handler.get_error();
+                LOG_WARN("Error decoding packets (forwarding will continue): %s", analysis_error.c_str());
+            }
+        }
+        capture.flush();
+        SDL_UnlockMutex(lock);
+
+        analysis_bytes.clear();
+        analysis_segments.clear();
+    }
 
     void destroy()
     {
-        for (size_t j = 0; j < packs_from_server.size(); j++)
-            if (packs_from_server[j])
-                delete packs_from_server[j];
-        packs_from_server.resize(0);
+        capture.close();
+
+        packet_viewer_dat_server.free_sel_pack();
+        packet_viewer_dat_client.free_sel_pack();
+        packet_viewer_dat.free_sel_pack();
 
-        for (size_t j = 0; j < packs_from_client.size(); j++)
-            if (packs_from_client[j])
-                delete packs_from_client[j];
-        packs_from_client.resize(0);
+        for (raw_segment_t& seg : raw_segments)
+            delete seg.pack;
+        raw_segments.clear();
 
         if (sock_to_client)
         {
@@ -1088,16 +1505,213 @@ struct client_t
             SDLNet_DestroyStreamSocket(sock_to_server);
             sock_to_server = NULL;
         }
+
+        SDL_DestroyMutex(raw_lock);
+        SDL_DestroyMutex(lock);
+        raw_lock = NULL;
+        lock = NULL;
     }
 
-    void kick(std::string reason)
+    /**
+     * Writes a single line of "key=value" stats for the connection
+     *
+     * NOTE: client_t::lock must be held
+     *
+     * @param out File to write to
+     * @param idx Index of the client
+     * @param elapsed Time since the previous call (milliseconds)
+     */
+    void dump_stats(FILE* const out, const size_t idx, const Uint64 elapsed)
     {
-        kick_reason = reason;
-        kick_sock(sock_to_client, reason);
-        kick_sock(sock_to_server, reason);
+        const double secs = SDL_max(double(elapsed) / 1000.0, 0.001);
+
+        fprintf(out,
+            "time=\"%s\" client=%zu user=\"%s\" state=%s mode=%s packs_client=%zu packs_server=%zu packs_client_rate=%.1f packs_server_rate=%.1f "
+            "bytes_client=%zu bytes_server=%zu bytes_client_rate=%.1f bytes_server_rate=%.1f capture_bytes=%zu entities=%zu players=%zu chat=%zu "
+            "analysis_error=\"%s\" capture_error=\"%s\" kick_reason=\"%s\"\n",
+            timestamp_from_tick(SDL_GetTicks()).c_str(), idx, world_diag.username.c_str(), kick_reason.length() ? "closed" : "active",
+            offline ? "offline" : (passthrough ? "passthrough" : "reserialize"), num_packs_from_client, num_packs_from_server,
+            double(num_packs_from_client - stats_last_num_packs_from_client) / secs, double(num_packs_from_server - stats_last_num_packs_from_server) / secs,
+            bytes_forwarded_from_client, bytes_forwarded_from_server, double(bytes_forwarded_from_client - stats_last_bytes_from_client) / secs,
+            double(bytes_forwarded_from_server - stats_last_bytes_from_server) / secs, capture.size_on_disk(), world_diag.entity_tracker.entity_map.size(),
+            world_diag.player_list.size(), world_diag.chat_history.size(), analysis_error.c_str(), capture_error.c_str(), kick_reason.c_str());
+
+        stats_last_num_packs_from_client = num_packs_from_client;
+        stats_last_num_packs_from_server = num_packs_from_server;
+        stats_last_bytes_from_client = bytes_forwarded_from_client;
+        stats_last_bytes_from_server = bytes_forwarded_from_server;
     }
 
-    void draw_packets(const char* label, std::vector<packet_t*>& packs, packet_viewer_dat_t& dat)
+    /**
+     * Builds the per packet id breakdown, rates are averaged over the last 10 seconds
+     *
+     * NOTE: client_t::lock must be held
+     *
+     * @returns One row for every packet id that has been seen in either direction
+     */
+    std::vector<packet_type_row_t> get_packet_type_rows()
+    {
+        /* Rates are relative to now so that they fall off once traffic stops (Captures opened from disk have no "now") */
+        const Uint64 tick_now = offline ? time_last_read : SDL_max(SDL_GetTicks(), time_last_read);
+
+        packet_windows[PACKET_SOURCE_ALL].expire(tick_now, 10000);
+        packet_type_stats[0].expire(tick_now, 10000);
+        packet_type_stats[1].expire(tick_now, 10000);
+
+        const Uint64 tdiff = packet_windows[PACKET_SOURCE_ALL].get_tick_diff(tick_now);
+        const double secs = tdiff ? double(tdiff) / 1000.0 : 0.0;
+
+        size_t window_bytes = 0;
+        for (int i = 0; i < 2; i++)
+            for (int id = 0; id < 256; id++)
+                window_bytes += packet_type_stats[i].windows[id].num_bytes;
+
+        std::vector<packet_type_row_t> rows;
+        for (int i = 0; i < 2; i++)
+        {
+            const packet_type_stats_t& stats = packet_type_stats[i];
+            for (int id = 0; id < 256; id++)
+            {
+                if (!stats.total_packets[id])
+                    continue;
+
+                const packet_window_t& window = stats.windows[id];
+
+                packet_type_row_t row;
+                row.from_client = i;
+                row.id = id;
+                row.packets_per_sec = secs > 0.0 ? double(window.samples.size()) / secs : 0.0;
+                row.bytes_per_sec = secs > 0.0 ? double(window.num_bytes) / secs : 0.0;
+                row.share = window_bytes ? double(window.num_bytes) / double(window_bytes) : 0.0;
+                row.total_packets = stats.total_packets[id];
+                row.total_bytes = stats.total_bytes[id];
+                rows.push_back(row);
+            }
+        }
+
+        return rows;
+    }
+
+    /**
+     * Writes the per packet id breakdown as CSV rows
+     *
+     * NOTE: client_t::lock must be held
+     *
+     * @param out File to write to
+     * @param idx Index of the client
+     */
+    void write_packet_type_csv(FILE* const out, const size_t idx)
+    {
+        const std::string timestamp = timestamp_from_tick(SDL_GetTicks());
+        for (const packet_type_row_t& row : get_packet_type_rows())
+            fprintf(out, "\"%s\",%zu,%s,0x%02x,%s,%.2f,%.1f,%.4f,%zu,%zu\n", timestamp.c_str(), idx, row.from_client ? "client" : "server", row.id,
+                packet_t::get_name_for_id(row.id), row.packets_per_sec, row.bytes_per_sec, row.share, row.total_packets, row.total_bytes);
+    }
+
+    /**
+     * Writes the per packet id breakdown to "<capture path>_packet_types.csv"
+     *
+     * NOTE: client_t::lock must be held
+     */
+    void export_packet_types()
+    {
+        const std::string path = capture.get_path() + "_packet_types.csv";
+        FILE* out = fopen(path.c_str(), "w");
+        if (!out)
+        {
+            LOG_WARN("Unable to open \"%s\" for writing", path.c_str());
+            return;
+        }
+
+        fputs(PACKET_TYPE_CSV_HEADER, out);
+        write_packet_type_csv(out, 0);
+        fclose(out);
+
+        LOG("Wrote packet type breakdown to \"%s\"", path.c_str());
+    }
+
+    void draw_packet_types()
+    {
+        if (ImGui::Button("Export CSV"))
+            export_packet_types();
+
+        std::vector<packet_type_row_t> rows = get_packet_type_rows();
+
+        const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Sortable | ImGuiTableFlags_SortMulti
+            | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingFixedFit;
+        if (!ImGui::BeginTable("Packet Type Table", 8, flags, ImVec2(0.0f, ImGui::GetTextLineHeightWithSpacing() * 16)))
+            return;
+
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Source");
+        ImGui::TableSetupColumn("ID");
+        ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Packets/s");
+        ImGui::TableSetupColumn("Bytes/s", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableSetupColumn("Share");
+        ImGui::TableSetupColumn("Total packets");
+        ImGui::TableSetupColumn("Total bytes");
+        ImGui::TableHeadersRow();
+
+        ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs();
+        if (specs && specs->SpecsCount)
+        {
+            std::stable_sort(rows.begin(), rows.end(), [specs](const packet_type_row_t& a, const packet_type_row_t& b) {
+                for (int i = 0; i < specs->SpecsCount; i++)
+                {
+                    const ImGuiTableColumnSortSpecs& spec = specs->Specs[i];
+                    int cmp = 0;
+                    switch (spec.ColumnIndex)
+                    {
+#define CMP(x) cmp = (a.x < b.x) ? -1 : (b.x < a.x) ? 1 : 0
+                    case 0:
+                        CMP(from_client);
+                        break;
+                    case 1:
+                        CMP(id);
+                        break;
+                    case 2:
+                        cmp = strcmp(packet_t::get_name_for_id(a.id), packet_t::get_name_for_id(b.id));
+                        break;
+                    case 3:
+                        CMP(packets_per_sec);
+                        break;
+                    case 4:
+                    case 5:
+                        CMP(bytes_per_sec);
+                        break;
+                    case 6:
+                        CMP(total_packets);
+                        break;
+                    case 7:
+                        CMP(total_bytes);
+                        break;
+#undef CMP
+                    }
+                    if (cmp)
+                        return spec.SortDirection == ImGuiSortDirection_Ascending ? cmp < 0 : cmp > 0;
+                }
+                return false;
+            });
+        }
+
+        for (const packet_type_row_t& row : rows)
+        {
+            ImGui::TableNextRow();
+            TABLE_VALUE("%s", row.from_client ? "Client" : "Server");
+            TABLE_VALUE("0x%02x", row.id);
+            TABLE_VALUE("%s", packet_t::get_name_for_id(row.id));
+            TABLE_VALUE("%.1f", row.packets_per_sec);
+            TABLE_VALUE("%.1f KB/s", row.bytes_per_sec / 1000.0);
+            TABLE_VALUE("%.1f%%", row.share * 100.0);
+            TABLE_VALUE("%zu", row.total_packets);
+            TABLE_VALUE("%.1f KB", double(row.total_bytes) / 1000.0);
+        }
+
+        ImGui::EndTable();
+    }
+
+    void draw_packets(const char* label, const packet_source_t source, packet_viewer_dat_t& dat)
     {
         if (!ImGui::TreeNode(label))
             return;
@@ -1145,13 +1759,17 @@ struct client_t
             ImGui::EndCombo();
         }
 
-        if (!packs.size())
+        const size_t num_packs = capture.size();
+
+        if (!num_packs)
         {
             ImGui::Text("No packets");
             ImGui::TreePop();
             return;
         }
 
+        dat.update_index(capture, source, bridge_packet_viewer_window.get());
+
         float child_height = ImGui::GetMainViewport()->WorkSize.y / 3;
 
         float list_width = ImGui::CalcTextSize("x").x * 90 + ImGui::GetStyle().ScrollbarSize;
@@ -1161,45 +1779,35 @@ struct client_t
 
         if (ImGui::BeginListBox("##Packet Listbox", ImVec2(list_width, child_height)))
         {
-            if (dat.select_recent)
-            {
-                for (size_t i = 0; i < packs.size(); i++)
-                {
-                    if (!dat.filters[packs[i]->id])
-                        continue;
-                    dat.sel = i;
-                }
-            }
+            if (dat.select_recent && dat.index.size())
+                dat.sel = dat.index.back();
 
-            float text_spacing = ImGui::GetTextLineHeightWithSpacing();
-
-            for (size_t i = 0; i < packs.size(); i++)
+            /* Only the visible rows are formatted */
+            ImGuiListClipper clipper;
+            clipper.Begin(dat.index.size());
+            while (clipper.Step())
             {
-                if (!dat.filters[packs[i]->id])
-                    continue;
-                ImGui::PushID(i);
-                char buf[56];
-                char buf2[88];
-                if (!ImGui::IsRectVisible(ImVec2(20, text_spacing)))
-                {
-                    buf2[0] = 0;
-                    ImGui::Spacing();
-                }
-                else
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
                 {
-                    snprintf(buf, ARR_SIZE(buf), "Packet[%zu]: 0x%02x (%s)", i, packs[i]->id, packs[i]->get_name());
+                    const size_t i = dat.index[row];
+                    capture_t::index_entry_t entry = capture.get_entry(i);
+                    ImGui::PushID(i);
+                    char buf[56];
+                    char buf2[88];
+                    snprintf(buf, ARR_SIZE(buf), "Packet[%zu]: 0x%02x (%s)", i, entry.id, packet_t::get_name_for_id(entry.id));
                     int buf_len = strlen(buf);
                     memset(buf + buf_len, ' ', ARR_SIZE(buf) - buf_len);
                     buf[ARR_SIZE(buf) - 1] = '\0';
 
-                    snprintf(buf2, ARR_SIZE(buf2), "%s %s", buf, timestamp_from_tick(packs[i]->assemble_tick).c_str());
+                    snprintf(buf2, ARR_SIZE(buf2), "%s %s", buf, timestamp_from_tick(entry.tick).c_str());
 
                     if (ImGui::Selectable(buf2, dat.sel == i))
                         dat.sel = i;
-                }
 
-                ImGui::PopID();
+                    ImGui::PopID();
+                }
             }
+            clipper.End();
 
             if (dat.force_scroll)
                 ImGui::SetScrollHereY(0.0f);
@@ -1216,8 +1824,15 @@ struct client_t
             return;
         }
 
-        if (dat.sel < packs.size())
-            packs[dat.sel]->draw_imgui();
+        if (dat.sel < num_packs && dat.sel != dat.sel_pack_idx)
+        {
+            dat.free_sel_pack();
+            dat.sel_pack = capture.decode(dat.sel);
+            dat.sel_pack_idx = dat.sel;
+        }
+
+        if (dat.sel < num_packs && dat.sel_pack)
+            dat.sel_pack->draw_imgui();
         else
         {
             PACKET_NEW_TABLE_CHOICE_IF("blank_table", goto skip_end_table;);
@@ -1243,29 +1858,6 @@ struct client_t
             TABLE_FIELD(name, "%.2f TB%s", (float)(size / (1000u * 1000u * 1000u)) / 1000.0f, rate ? "/s" : "");
     }
 
-    void calc_packet_data(std::vector<packet_t*>& packs, size_t& num, Uint64& tick_diff, size_t& mem_foot, Uint64 max_diff)
-    {
-        int misses = 0;
-        num = 0;
-        tick_diff = 0;
-        mem_foot = 0;
-        for (size_t i = packs.size() - 1; i < packs.size(); i--)
-        {
-            if (time_last_read - packs[i]->assemble_tick < max_diff)
-            {
-                tick_diff = time_last_read - packs[i]->assemble_tick;
-                num++;
-                mem_foot += packs[i]->mem_size() + sizeof(packet_t*);
-            }
-            else
-            {
-                misses++;
-                if (misses > 1000)
-                    return;
-            }
-        }
-    }
-
     void draw_imgui()
     {
         float field_size = ImGui::CalcTextSize("Num packets from client (read - 10sec): ").x;
@@ -1280,26 +1872,38 @@ struct client_t
             TABLE_FIELD("Last read timestamp: ", "%s", timestamp_from_tick(time_last_read).c_str());
             TABLE_FIELD("Duration of connection: ", "%.2fs", ((float)((time_last_read - time_init) / 10)) / 100.0f);
 
-            TABLE_FIELD("Num packets from client: ", "%zu", packs_from_client.size());
-            TABLE_FIELD("Num packets from server: ", "%zu", packs_from_server.size());
-            TABLE_FIELD("Num packets: ", "%zu", packets.size());
+            TABLE_FIELD("Num packets from client: ", "%zu", num_packs_from_client);
+            TABLE_FIELD("Num packets from server: ", "%zu", num_packs_from_server);
+            TABLE_FIELD("Num packets: ", "%zu", num_packs_from_client + num_packs_from_server);
 
-            size_t mem_foot = packets_mem_footprint + (packets.capacity() + packs_from_client.capacity() + packs_from_server.capacity()) * sizeof(packets[0]);
+            const size_t capture_size = capture.size_on_disk();
 
-            draw_memory_field("Est. Packet memory footprint: ", mem_foot, false);
-            draw_memory_field("Client data transfer: ", pack_handler_client.get_bytes_received(), false);
-            draw_memory_field("Server data transfer: ", pack_handler_server.get_bytes_received(), false);
+            TABLE_FIELD("Capture: ", "%s%s", capture.get_path().c_str(), offline ? " (Opened from disk)" : "");
+            if (capture_error.length())
+                TABLE_FIELD("Capture error: ", "%s", capture_error.c_str());
+            draw_memory_field("Capture size: ", capture_size, false);
+            draw_memory_field("Client data transfer: ", bytes_forwarded_from_client, false);
+            draw_memory_field("Server data transfer: ", bytes_forwarded_from_server, false);
+
+            TABLE_FIELD("Forwarding mode: ", "%s", passthrough ? "Passthrough" : "Re-serialize");
+            if (passthrough)
+            {
+                if (verify_checked)
+                    TABLE_FIELD("Re-serialization mismatches: ", "%zu/%zu", verify_mismatches, verify_checked);
+                if (analysis_error.length())
+                    TABLE_FIELD("Analysis error: ", "%s", analysis_error.c_str());
+            }
 
             size_t tdiff = time_last_read - time_init;
             if (tdiff != 0)
             {
-                TABLE_FIELD("AVG Client packets/s: ", "%zu", packs_from_client.size() * 1000 / tdiff);
-                TABLE_FIELD("AVG Server packets/s: ", "%zu", packs_from_server.size() * 1000 / tdiff);
-                TABLE_FIELD("AVG Packets/s: ", "%zu", (packets.size()) * 1000 / tdiff);
+                TABLE_FIELD("AVG Client packets/s: ", "%zu", num_packs_from_client * 1000 / tdiff);
+                TABLE_FIELD("AVG Server packets/s: ", "%zu", num_packs_from_server * 1000 / tdiff);
+                TABLE_FIELD("AVG Packets/s: ", "%zu", (num_packs_from_client + num_packs_from_server) * 1000 / tdiff);
 
-                draw_memory_field("AVG Est. Memory footprint rate: ", mem_foot * 1000 / tdiff, true);
-                draw_memory_field("AVG Client data rate: ", pack_handler_client.get_bytes_received() * 1000 / tdiff, true);
-                draw_memory_field("AVG Server data rate: ", pack_handler_server.get_bytes_received() * 1000 / tdiff, true);
+                draw_memory_field("AVG Capture growth rate: ", capture_size * 1000 / tdiff, true);
+                draw_memory_field("AVG Client data rate: ", bytes_forwarded_from_client * 1000 / tdiff, true);
+                draw_memory_field("AVG Server data rate: ", bytes_forwarded_from_server * 1000 / tdiff, true);
             }
 
             if (kick_reason.length())
@@ -1317,30 +1921,35 @@ struct client_t
             ImGui::TableSetupColumn("Value", ImGuiTableColumnFlags_WidthStretch);
             ImGui::TableHeadersRow();
 
-            size_t packets_recent[3] = { 0, 0, 0 };
-            Uint64 packets_recent_ticks[3] = { time_last_read, time_last_read, time_last_read };
-            size_t packets_recent_foot[3] = { 0, 0, 0 };
+            size_t packets_recent[3];
+            Uint64 packets_recent_ticks[3];
+            size_t packets_recent_foot[3];
 
-            calc_packet_data(packs_from_client, packets_recent[0], packets_recent_ticks[0], packets_recent_foot[0], 10000);
-            calc_packet_data(packs_from_server, packets_recent[1], packets_recent_ticks[1], packets_recent_foot[1], 10000);
-            calc_packet_data(packets, packets_recent[2], packets_recent_ticks[2], packets_recent_foot[2], 10000);
+            const packet_source_t sources[3] = { PACKET_SOURCE_CLIENT, PACKET_SOURCE_SERVER, PACKET_SOURCE_ALL };
+            for (int i = 0; i < 3; i++)
+            {
+                const packet_window_t& window = packet_windows[sources[i]];
+                packets_recent[i] = window.samples.size();
+                packets_recent_ticks[i] = window.get_tick_diff(time_last_read);
+                packets_recent_foot[i] = window.num_bytes;
+            }
 
             TABLE_FIELD("Num packets from client: ", "%zu", packets_recent[0]);
             TABLE_FIELD("Num packets from server: ", "%zu", packets_recent[1]);
             TABLE_FIELD("Num packets: ", "%zu", packets_recent[2]);
 
-            draw_memory_field("Est. Packet mem footprint (client): ", packets_recent_foot[0], false);
-            draw_memory_field("Est. Packet mem footprint (server): ", packets_recent_foot[1], false);
-            draw_memory_field("Est. Packet mem footprint (total): ", packets_recent_foot[2], false);
+            draw_memory_field("Packet bytes (client): ", packets_recent_foot[0], false);
+            draw_memory_field("Packet bytes (server): ", packets_recent_foot[1], false);
+            draw_memory_field("Packet bytes (total): ", packets_recent_foot[2], false);
 
             if (packets_recent_ticks[0] != 0)
-                draw_memory_field("AVG Est. Memory footprint rate (client): ", packets_recent_foot[0] * 1000 / packets_recent_ticks[0], true);
+                draw_memory_field("AVG Data rate (client): ", packets_recent_foot[0] * 1000 / packets_recent_ticks[0], true);
 
             if (packets_recent_ticks[1] != 0)
-                draw_memory_field("AVG Est. Memory footprint rate (server): ", packets_recent_foot[1] * 1000 / packets_recent_ticks[1], true);
+                draw_memory_field("AVG Data rate (server): ", packets_recent_foot[1] * 1000 / packets_recent_ticks[1], true);
 
             if (packets_recent_ticks[2] != 0)
-                draw_memory_field("AVG Est. Memory footprint rate (total): ", packets_recent_foot[2] * 1000 / packets_recent_ticks[2], true);
+                draw_memory_field("AVG Data rate (total): ", packets_recent_foot[2] * 1000 / packets_recent_ticks[2], true);
 
             if (packets_recent_ticks[0] != 0)
                 TABLE_FIELD("AVG Client packets/s: ", "%zu", packets_recent[0] * 1000 / packets_recent_ticks[0]);
@@ -1389,13 +1998,19 @@ struct client_t
         {
             /* TODO: Basic list of entities, their types (if declared), their positions, and maybe a history */
             /* TODO-OPT: More advanced list of entities */
-            world_diag.draw_imgui_entities();
+            world_diag.draw_imgui_entities(capture);
             ImGui::TreePop();
         }
 
-        draw_packets("Packets from Client", packs_from_client, packet_viewer_dat_server);
-        draw_packets("Packets from Server", packs_from_server, packet_viewer_dat_client);
-        draw_packets("Packets", packets, packet_viewer_dat);
+        if (ImGui::TreeNode("Packet types"))
+        {
+            draw_packet_types();
+            ImGui::TreePop();
+        }
+
+        draw_packets("Packets from Client", PACKET_SOURCE_CLIENT, packet_viewer_dat_server);
+        draw_packets("Packets from Server", PACKET_SOURCE_SERVER, packet_viewer_dat_client);
+        draw_packets("Packets", PACKET_SOURCE_ALL, packet_viewer_dat);
     }
 };
 
@@ -1415,6 +2030,293 @@ SDLNet_Address* resolve_addr(const char* addr)
 static convar_string_t address_listen("address_listen", "127.0.0.3", "Address to listen for connections");
 static convar_string_t address_server("address_server", "127.0.0.1", "Address of the server to bridge to");
 
+/**
+ * Clients are only ever appended, and never freed before exit, so pointers obtained while holding clients_lock stay valid
+ */
+static std::vector<client_t*> clients;
+static SDL_Mutex* clients_lock = NULL;
+
+/** Signalled whenever bytes are queued for the analysis thread */
+static SDL_Semaphore* analysis_sem = NULL;
+static SDL_AtomicInt analysis_shutdown;
+
+static int SDLCALL analysis_thread_func(void*)
+{
+    std::vector<client_t*> clients_copy;
+    bool work_remaining = false;
+    while (!SDL_GetAtomicInt(&analysis_shutdown))
+    {
+        if (!work_remaining)
+            SDL_WaitSemaphoreTimeout(analysis_sem, 100);
+        work_remaining = false;
+
+        SDL_LockMutex(clients_lock);
+        clients_copy = clients;
+        SDL_UnlockMutex(clients_lock);
+
+        for (client_t* c : clients_copy)
+        {
+            if (!c->offline)
+                c->analyze_pending();
+            if (c->offline)
+                work_remaining |= c->replay_offline();
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Generates a capture path of the form "<bridge_capture_dir>/<date>_<time>_client<client_num>"
+ */
+static std::string new_capture_path(const size_t client_num)
+{
+    SDL_Time time = 0;
+    SDL_DateTime dt;
+    SDL_zero(dt);
+    if (SDL_GetCurrentTime(&time))
+        SDL_TimeToDateTime(time, &dt, 1);
+
+    char buf[128];
+    snprintf(buf, ARR_SIZE(buf), "%04d-%02d-%02d_%02d-%02d-%02d_client%zu", dt.year, dt.month, dt.day, dt.hour, dt.minute, dt.second, client_num);
+
+    std::string dir = bridge_capture_dir.get();
+    if (dir.length())
+    {
+        SDL_CreateDirectory(dir.c_str());
+        dir += "/";
+    }
+
+    return dir + buf;
+}
+
+/**
+ * Opens a capture from disk as an inactive client
+ */
+static void open_capture(const std::string& path)
+{
+    client_t* c = new client_t();
+
+    if (!c->capture.open(path))
+    {
+        c->destroy();
+        delete c;
+        return;
+    }
+
+    c->offline = true;
+    c->world_diag.can_send_chat = false;
+    c->kick_reason = "Opened from disk";
+    if (c->capture.size())
+    {
+        c->time_init = c->capture.get_entry(0).tick;
+        c->time_last_read = c->time_init;
+    }
+
+    LOG("Opened capture \"%s\" (%zu packets)", path.c_str(), c->capture.size());
+
+    SDL_LockMutex(clients_lock);
+    clients.push_back(c);
+    SDL_UnlockMutex(clients_lock);
+
+    SDL_SignalSemaphore(analysis_sem);
+}
+
+static convar_int_t bridge_stats_interval {
+    "bridge_stats_interval",
+#ifdef MCS_B181_BRIDGE_HEADLESS
+    5000,
+#else
+    0,
+#endif
+    0,
+    3600000,
+    "Interval between stat dumps (milliseconds, 0 to disable)",
+};
+
+static convar_string_t bridge_stats_file("bridge_stats_file", "", "File to append stat dumps to (stdout if empty)");
+static convar_string_t bridge_stats_packet_types_file(
+    "bridge_stats_packet_types_file", "", "File to append the per packet type breakdown to as CSV on every stat dump (disabled if empty)");
+
+/**
+ * Writes the stats of every client to bridge_stats_file
+ *
+ * @param clients_copy Snapshot of clients
+ * @param elapsed Time since the previous dump (milliseconds)
+ */
+static void dump_stats(const std::vector<client_t*>& clients_copy, const Uint64 elapsed)
+{
+    FILE* out = stdout;
+    if (bridge_stats_file.get().length())
+        out = fopen(bridge_stats_file.get().c_str(), "a");
+
+    if (!out)
+    {
+        LOG_WARN("Unable to open \"%s\" for writing stats", bridge_stats_file.get().c_str());
+        return;
+    }
+
+    FILE* out_types = NULL;
+    if (bridge_stats_packet_types_file.get().length())
+    {
+        out_types = fopen(bridge_stats_packet_types_file.get().c_str(), "a");
+        if (!out_types)
+            LOG_WARN("Unable to open \"%s\" for writing stats", bridge_stats_packet_types_file.get().c_str());
+        else if (ftell(out_types) == 0)
+            fputs(PACKET_TYPE_CSV_HEADER, out_types);
+    }
+
+    for (size_t i = 0; i < clients_copy.size(); i++)
+    {
+        SDL_LockMutex(clients_copy[i]->lock);
+        clients_copy[i]->dump_stats(out, i, elapsed);
+        if (out_types)
+            clients_copy[i]->write_packet_type_csv(out_types, i);
+        SDL_UnlockMutex(clients_copy[i]->lock);
+    }
+
+    if (out_types)
+        fclose(out_types);
+
+    if (out == stdout)
+        fflush(out);
+    else
+        fclose(out);
+}
+
+static SDL_AtomicInt io_shutdown;
+
+struct io_thread_dat_t
+{
+    SDLNet_Server* server = NULL;
+    SDLNet_Address* addr_real_server = NULL;
+};
+
+/**
+ * Accepts all pending connections and connects them to the real server
+ *
+ * @param live List of connections owned by the I/O thread to add the new connections to
+ */
+static void accept_clients(io_thread_dat_t* const dat, std::vector<client_t*>& live)
+{
+    while (1)
+    {
+        SDLNet_StreamSocket* sock_to_client = NULL;
+        if (!SDLNet_AcceptClient(dat->server, &sock_to_client))
+        {
+            LOG("SDLNet_AcceptClient: %s", SDL_GetError());
+            exit(1);
+        }
+        if (sock_to_client == NULL)
+            return;
+
+        client_t* new_client = new client_t();
+        new_client->sock_to_client = sock_to_client;
+
+        SDLNet_SimulateStreamPacketLoss(new_client->sock_to_client, bridge_link_packet_loss.get());
+
+        SDLNet_Address* client_addr = SDLNet_GetStreamSocketAddress(new_client->sock_to_client);
+        LOG("New Socket: %s:%u", SDLNet_GetAddressString(client_addr), SDLNet_GetStreamSocketPort(new_client->sock_to_client));
+        SDLNet_UnrefAddress(client_addr);
+
+        new_client->sock_to_server = SDLNet_CreateClient(dat->addr_real_server, 25565);
+        if (new_client->sock_to_server)
+            SDLNet_SimulateStreamPacketLoss(new_client->sock_to_server, bridge_link_packet_loss.get());
+
+        new_client->time_last_read = SDL_GetTicks();
+        new_client->time_init = new_client->time_last_read;
+        new_client->io_time_last_read = new_client->time_last_read;
+        new_client->passthrough = bridge_passthrough.get();
+        new_client->world_diag.can_send_chat = !new_client->passthrough;
+
+        if (!new_client->sock_to_server)
+        {
+            LOG("Failed to connect to server!");
+            new_client->destroy();
+            delete new_client;
+            continue;
+        }
+
+        SDL_LockMutex(clients_lock);
+        const std::string capture_path = new_capture_path(clients.size());
+        if (!new_client->capture.create(capture_path))
+        {
+            new_client->capture_error = std::string("Unable to create \"") + capture_path + "\": " + SDL_GetError();
+            LOG("Not recording connection: %s", new_client->capture_error.c_str());
+        }
+        clients.push_back(new_client);
+        SDL_UnlockMutex(clients_lock);
+
+        live.push_back(new_client);
+    }
+}
+
+/**
+ * Accepts connections and forwards data as soon as any socket becomes readable, independent of the GUI frame rate
+ */
+static int SDLCALL io_thread_func(void* userdata)
+{
+    io_thread_dat_t* dat = (io_thread_dat_t*)userdata;
+
+    std::vector<client_t*> live;
+    std::vector<void*> wait_list;
+    bool writes_pending = false;
+    Uint64 time_to_next_release = SDL_MAX_UINT64;
+
+    while (!SDL_GetAtomicInt(&io_shutdown))
+    {
+        wait_list.clear();
+        wait_list.push_back(dat->server);
+        for (client_t* c : live)
+        {
+            wait_list.push_back(c->sock_to_client);
+            wait_list.push_back(c->sock_to_server);
+        }
+
+        /* Writes are only pushed out when SDL_net is called, so don't sleep long while any are queued */
+        Sint32 timeout = writes_pending ? 1 : 50;
+        /* Wake up in time for the emulated links to release data (rounding up to avoid spinning) */
+        if (time_to_next_release != SDL_MAX_UINT64)
+            timeout = SDL_min(timeout, Sint32((time_to_next_release + 999999) / 1000000));
+
+        if (SDLNet_WaitUntilInputAvailable(wait_list.data(), wait_list.size(), timeout) < 0)
+            SDL_Delay(1);
+
+        accept_clients(dat, live);
+
+        const Uint64 sdl_tick_cur = SDL_GetTicks();
+        bool bytes_queued = false;
+        writes_pending = false;
+        time_to_next_release = SDL_MAX_UINT64;
+        for (client_t* c : live)
+        {
+            if (sdl_tick_cur - c->io_time_last_read > 60000)
+            {
+                c->disconnect("Timed out", !c->passthrough);
+                continue;
+            }
+
+            if (c->passthrough)
+                bytes_queued |= c->forward_passthrough(sdl_tick_cur);
+            else
+                bytes_queued |= c->forward_reserialize(sdl_tick_cur);
+
+            if (!c->skip && !c->pump_links(time_to_next_release))
+                continue;
+
+            if (!c->skip)
+                writes_pending |= SDLNet_GetStreamSocketPendingWrites(c->sock_to_client) > 0 || SDLNet_GetStreamSocketPendingWrites(c->sock_to_server) > 0;
+        }
+
+        live.erase(std::remove_if(live.begin(), live.end(), [](client_t* c) { return c->skip; }), live.end());
+
+        if (bytes_queued)
+            SDL_SignalSemaphore(analysis_sem);
+    }
+
+    return 0;
+}
+
 int main(int argc, const char** argv)
 {
     /* KDevelop fully buffers the output and will not display anything */
@@ -1432,11 +2334,15 @@ int main(int argc, const char** argv)
     SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_TYPE_STRING, "game");
 
     tetra::init("icrashstuff", "mcs_b181", "mcs_b181_bridge", argc, argv);
+
+#ifndef MCS_B181_BRIDGE_HEADLESS
     tetra::init_gui("mcs_b181_bridge");
+#endif
 
     LOG("Hello");
 
-    if (!SDL_Init(0))
+    /* The events subsystem turns SIGINT/SIGTERM into SDL_EVENT_QUIT */
+    if (!SDL_Init(SDL_INIT_EVENTS))
     {
         LOG("SDL_Init: %s", SDL_GetError());
         exit(1);
@@ -1468,16 +2374,17 @@ int main(int argc, const char** argv)
         exit(1);
     }
 
+#ifndef MCS_B181_BRIDGE_HEADLESS
     char imgui_win_title[128];
 
     snprintf(imgui_win_title, 128, "Client Inspector Window (\"%s\" -> \"%s\")", address_listen.get().c_str(), address_server.get().c_str());
+#endif
 
     LOG("Bridging: %s -> %s", SDLNet_GetAddressString(addr), SDLNet_GetAddressString(addr_real_server));
 
     LOG("Creating server");
 
     SDLNet_Server* server = SDLNet_CreateServer(addr, 25565);
-    std::vector<client_t> clients;
 
     if (!server)
     {
@@ -1487,166 +2394,121 @@ int main(int argc, const char** argv)
 
     SDLNet_UnrefAddress(addr);
 
+    clients_lock = SDL_CreateMutex();
+    analysis_sem = SDL_CreateSemaphore(0);
+    SDL_Thread* analysis_thread = SDL_CreateThread(analysis_thread_func, "Bridge analysis", NULL);
+
+    io_thread_dat_t io_thread_dat;
+    io_thread_dat.server = server;
+    io_thread_dat.addr_real_server = addr_real_server;
+    SDL_Thread* io_thread = SDL_CreateThread(io_thread_func, "Bridge I/O", &io_thread_dat);
+
+    std::vector<client_t*> clients_copy;
+    Uint64 tick_last_stats = SDL_GetTicks();
+
     while (!done)
     {
+#ifdef MCS_B181_BRIDGE_HEADLESS
+        SDL_Event event;
+        while (SDL_WaitEventTimeout(&event, 100))
+        {
+            if (event.type == SDL_EVENT_QUIT || event.type == SDL_EVENT_TERMINATING)
+                done = true;
+        }
+#else
         if (tetra::start_frame() == 0)
             done = true;
-        int done_client_searching = false;
-        while (!done_client_searching)
-        {
-            client_t new_client;
-            if (!SDLNet_AcceptClient(server, &new_client.sock_to_client))
-            {
-                LOG("SDLNet_AcceptClient: %s", SDL_GetError());
-                exit(1);
-            }
-            if (new_client.sock_to_client == NULL)
-            {
-                done_client_searching = true;
-                continue;
-            }
-
-            SDLNet_SimulateStreamPacketLoss(new_client.sock_to_client, 0);
-
-            SDLNet_Address* client_addr = SDLNet_GetStreamSocketAddress(new_client.sock_to_client);
-            LOG("New Socket: %s:%u", SDLNet_GetAddressString(client_addr), SDLNet_GetStreamSocketPort(new_client.sock_to_client));
-            SDLNet_UnrefAddress(client_addr);
-
-            new_client.sock_to_server = SDLNet_CreateClient(addr_real_server, 25565);
-
-            new_client.time_last_read = SDL_GetTicks();
-            new_client.time_init = new_client.time_last_read;
+#endif
+        if (SDL_GetAtomicInt(&stop_requested))
+            done = true;
 
-            if (new_client.sock_to_server)
-                clients.push_back(new_client);
-            else
-            {
-                LOG("Failed to connect to server!");
-                if (new_client.sock_to_client)
-                    SDLNet_DestroyStreamSocket(new_client.sock_to_client);
-            }
-        }
+        SDL_LockMutex(clients_lock);
+        clients_copy = clients;
+        SDL_UnlockMutex(clients_lock);
 
-        for (size_t i = 0; i < clients.size() * 3; i++)
+        const Uint64 sdl_tick_cur = SDL_GetTicks();
+        if (bridge_stats_interval.get() && (sdl_tick_cur - tick_last_stats >= Uint64(bridge_stats_interval.get()) || done))
         {
-            int sdl_tick_cur = SDL_GetTicks();
-            client_t* c = &clients.data()[i % clients.size()];
-            if (c->skip)
-                continue;
-            c->change_happened = true;
-            for (size_t j = 0; j < 25; j++)
-            {
-                if (c->skip || !c->change_happened)
-                    continue;
-
-                if (sdl_tick_cur - c->time_last_read > 60000)
-                {
-                    c->skip = true;
-                    continue;
-                }
-
-                c->change_happened = false;
-
-                if (c->world_diag.send_chat)
-                {
-                    packet_chat_message_t cmsg;
-                    cmsg.msg = c->world_diag.chat_buf;
-                    send_buffer(c->sock_to_server, cmsg.assemble());
-                    c->world_diag.chat_buf[0] = 0;
-                    c->world_diag.send_chat = false;
-                }
-
-                packet_t* pack_from_client = c->pack_handler_client.get_next_packet(c->sock_to_client);
-                packet_t* pack_from_server = c->pack_handler_server.get_next_packet(c->sock_to_server);
-
-                if (pack_from_client)
-                {
-                    c->change_happened++;
-                    c->time_last_read = sdl_tick_cur;
-                    TRACE("Got packet from client[%zu]: 0x%02x", i, pack_from_client->id);
-                    if (pack_from_client->id == PACKET_ID_CHAT_MSG)
-                    {
-                        packet_chat_message_t* p = (packet_chat_message_t*)pack_from_client;
-
-                        if (p->msg == "/stop_bridge")
-                            done = true;
-                        else
-                            send_buffer(c->sock_to_server, pack_from_client->assemble());
-                    }
-                    else
-                        send_buffer(c->sock_to_server, pack_from_client->assemble());
-
-                    c->world_diag.feed_packet_from_client(pack_from_client);
-                    c->packets_mem_footprint += pack_from_client->mem_size();
-                    c->packs_from_client.push_back(pack_from_client);
-                    c->packets.push_back(pack_from_client);
-                }
-                else if (c->pack_handler_client.get_error().length())
-                {
-                    c->skip = true;
-                    char buf[100];
-                    snprintf(buf, ARR_SIZE(buf), "Error parsing packet from client[%zu]: %s", i, c->pack_handler_client.get_error().c_str());
-                    c->kick(buf);
-                }
-
-                if (pack_from_server)
-                {
-                    c->change_happened++;
-                    c->time_last_read = sdl_tick_cur;
-                    TRACE("Got packet from server: 0x%02x", pack_from_server->id);
-                    send_buffer(c->sock_to_client, pack_from_server->assemble());
-
-                    c->world_diag.feed_packet_from_server(pack_from_server);
-                    c->packets_mem_footprint += pack_from_server->mem_size();
-                    c->packs_from_server.push_back(pack_from_server);
-                    c->packets.push_back(pack_from_server);
-                }
-                else if (c->pack_handler_server.get_error().length() && !c->skip)
-                {
-                    c->skip = true;
-                    char buf[100];
-                    snprintf(buf, ARR_SIZE(buf), "Error parsing packet from server: %s", c->pack_handler_server.get_error().c_str());
-                    c->kick(buf);
-                }
-            }
+            dump_stats(clients_copy, sdl_tick_cur - tick_last_stats);
+            tick_last_stats = sdl_tick_cur;
         }
 
+#ifndef MCS_B181_BRIDGE_HEADLESS
+
         ImGui::SetNextWindowPos(ImGui::GetMainViewport()->WorkPos);
         ImGui::SetNextWindowSize(ImGui::GetMainViewport()->WorkSize);
         Uint32 window_flags = ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize;
         if (ImGui::Begin(imgui_win_title, NULL, window_flags))
         {
-            for (size_t i = 0; i < clients.size(); i++)
+            static char open_capture_path[1024] = "";
+            bool open_pressed = ImGui::InputTextWithHint(
+                "##capture path", "Capture path (without extension)", open_capture_path, ARR_SIZE(open_capture_path), ImGuiInputTextFlags_EnterReturnsTrue);
+            ImGui::SameLine();
+            open_pressed |= ImGui::Button("Open capture");
+            if (open_pressed && open_capture_path[0])
+                open_capture(open_capture_path);
+
+            for (size_t i = 0; i < clients_copy.size(); i++)
             {
+                client_t* c = clients_copy[i];
+                SDL_LockMutex(c->lock);
                 ImGui::PushID(i);
-                const char* txt_active = clients[i].skip ? "" : "(Active)";
+                const char* txt_active = c->kick_reason.length() ? "" : "(Active)";
                 bool open = false;
-                if (clients[i].world_diag.username.length())
-                    open = ImGui::TreeNode("client", "Clients[%zu] (%s) %s", i, clients[i].world_diag.username.c_str(), txt_active);
+                if (c->world_diag.username.length())
+                    open = ImGui::TreeNode("client", "Clients[%zu] (%s) %s", i, c->world_diag.username.c_str(), txt_active);
                 else
                     open = ImGui::TreeNode("client", "Clients[%zu] %s", i, txt_active);
 
                 if (open)
                 {
-                    clients[i].draw_imgui();
+                    c->draw_imgui();
                     ImGui::TreePop();
                 }
                 ImGui::PopID();
+
+                if (c->world_diag.send_chat)
+                {
+                    SDL_LockMutex(c->raw_lock);
+                    c->pending_chat.push_back(c->world_diag.chat_buf);
+                    SDL_UnlockMutex(c->raw_lock);
+                    c->world_diag.chat_buf[0] = 0;
+                    c->world_diag.send_chat = false;
+                }
+
+                SDL_UnlockMutex(c->lock);
             }
         }
         ImGui::End();
         tetra::end_frame();
+#endif
     }
 
     LOG("Destroying server");
 
+    SDL_SetAtomicInt(&io_shutdown, 1);
+    SDL_WaitThread(io_thread, NULL);
+
+    SDL_SetAtomicInt(&analysis_shutdown, 1);
+    SDL_SignalSemaphore(analysis_sem);
+    SDL_WaitThread(analysis_thread, NULL);
+    SDL_DestroySemaphore(analysis_sem);
+
     for (size_t i = 0; i < clients.size(); i++)
-        clients[i].destroy();
+    {
+        clients[i]->destroy();
+        delete clients[i];
+    }
+    clients.clear();
+
+    SDL_DestroyMutex(clients_lock);
 
     SDLNet_DestroyServer(server);
 
     SDLNet_Quit();
+#ifndef MCS_B181_BRIDGE_HEADLESS
     tetra::deinit_gui();
+#endif
     tetra::deinit();
 
     return 0;
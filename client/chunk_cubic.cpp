@@ -21,7 +21,8 @@
  * DEALINGS IN THE SOFTWARE.
  */
 #include "chunk_cubic.h"
-#include "state.h"
+
+#include <SDL3/SDL_intrin.h>
 
 #ifndef IM_ARRAYSIZE
 #define IM_ARRAYSIZE(X) (int(SDL_arraysize(X)))
@@ -34,12 +35,16 @@ void chunk_cubic_t::free_renderer_resources(const chunk_cubic_t::dirty_level_t n
     quad_count_overlay = 0;
     quad_count_translucent = 0;
 
+    mesh_generation = 0;
+
+#ifndef MCS_B181_CLIENT_HEADLESS
     if (mesh_handle)
     {
         mesh_handle->release();
         delete mesh_handle;
         mesh_handle = nullptr;
     }
+#endif
 
     dirty_level = new_dirty_level;
 }
@@ -47,10 +52,7 @@ void chunk_cubic_t::free_renderer_resources(const chunk_cubic_t::dirty_level_t n
 /* There is no special reason that this function uses |= instead of +=, other than if one happens to be faster (which is unlikely) it would probably be |= */
 void chunk_cubic_t::update_renderer_hints()
 {
-    bool is_trans[256];
-
-    for (size_t i = 0; i < SDL_arraysize(is_trans); i++)
-        is_trans[i] = mc_id::is_transparent(i);
+    const mc_id::block_bitset_t& is_trans = mc_id::block_properties.transparent;
 
     memset(&renderer_hints, 0, sizeof(renderer_hints));
 
@@ -75,9 +77,13 @@ void chunk_cubic_t::update_renderer_hints()
         renderer_hints.opaque_face_neg_x = 0;
         renderer_hints.opaque_face_neg_y = 0;
         renderer_hints.opaque_face_neg_z = 0;
+        renderer_hints.face_connections = FACE_CONNECTIONS_ALL;
         return;
     }
 
+    /* Done before the light based checks below, blocks like stairs stop light but can still be seen past */
+    renderer_hints.face_connections = find_face_connections();
+
     /* Check for a uniform chunk of opaque to light blocks */
     Uint32 total_trans = 0;
     for (int i = 0; i < SUBCHUNK_SIZE_VOLUME; i++)
@@ -128,12 +134,88 @@ void chunk_cubic_t::update_renderer_hints()
         renderer_hints.opaque_sides = 1;
 }
 
-void chunk_cubic_t::light_pass_block_setup()
+Uint16 chunk_cubic_t::find_face_connections() const
 {
-    Uint8 light_levels[256];
+    static_assert(SUBCHUNK_SIZE_X == 16 && SUBCHUNK_SIZE_Y == 16 && SUBCHUNK_SIZE_Z == 16, "Index decomposition below assumes 16^3 chunks");
+
+    const mc_id::block_bitset_t& is_cube = mc_id::block_properties.opaque_cube;
+
+    /* Opaque cubes are marked as visited up front so the fill never enters them (Anything else can be seen past, even if it blocks light) */
+    Uint64 visited[SUBCHUNK_SIZE_VOLUME / 64];
+    for (int i = 0; i < SUBCHUNK_SIZE_VOLUME / 64; i++)
+    {
+        Uint64 bits = 0;
+        for (int j = 0; j < 64; j++)
+            bits |= Uint64(is_cube[data_block[i * 64 + j]]) << j;
+        visited[i] = bits;
+    }
+
+#define VISITED_TEST(IDX) ((visited[(IDX) >> 6] >> ((IDX) & 63)) & 1)
+#define VISITED_SET(IDX) (visited[(IDX) >> 6] |= Uint64(1) << ((IDX) & 63))
+
+    Uint16 stack[SUBCHUNK_SIZE_VOLUME];
+    Uint16 connections = 0;
 
-    for (int i = 0; i < IM_ARRAYSIZE(light_levels); i++)
-        light_levels[i] = mc_id::get_light_level(i);
+    for (int start = 0; start < SUBCHUNK_SIZE_VOLUME; start++)
+    {
+        const int start_y = start & 0x0F;
+        const int start_z = (start >> 4) & 0x0F;
+        const int start_x = (start >> 8) & 0x0F;
+
+        /* Volumes that never reach a face do not connect anything, so fills are only started from blocks on a face */
+        if (VISITED_TEST(start) || (start_x % 15 != 0 && start_y % 15 != 0 && start_z % 15 != 0))
+            continue;
+
+        int stack_len = 0;
+        stack[stack_len++] = start;
+        VISITED_SET(start);
+
+        Uint8 touched = 0;
+        while (stack_len)
+        {
+            const int idx = stack[--stack_len];
+            const int y = idx & 0x0F;
+            const int z = (idx >> 4) & 0x0F;
+            const int x = (idx >> 8) & 0x0F;
+
+#define FILL_STEP(COND_EDGE, FACE, OFFSET)     \
+    do                                         \
+    {                                          \
+        if (COND_EDGE)                         \
+            touched |= 1 << (FACE);            \
+        else if (!VISITED_TEST(idx + OFFSET))  \
+        {                                      \
+            VISITED_SET(idx + OFFSET);         \
+            stack[stack_len++] = idx + OFFSET; \
+        }                                      \
+    } while (0)
+
+            FILL_STEP(x == SUBCHUNK_SIZE_X - 1, FACE_POS_X, SUBCHUNK_INDEX(1, 0, 0));
+            FILL_STEP(y == SUBCHUNK_SIZE_Y - 1, FACE_POS_Y, SUBCHUNK_INDEX(0, 1, 0));
+            FILL_STEP(z == SUBCHUNK_SIZE_Z - 1, FACE_POS_Z, SUBCHUNK_INDEX(0, 0, 1));
+            FILL_STEP(x == 0, FACE_NEG_X, -SUBCHUNK_INDEX(1, 0, 0));
+            FILL_STEP(y == 0, FACE_NEG_Y, -SUBCHUNK_INDEX(0, 1, 0));
+            FILL_STEP(z == 0, FACE_NEG_Z, -SUBCHUNK_INDEX(0, 0, 1));
+#undef FILL_STEP
+        }
+
+        for (int a = 0; a < FACE_COUNT; a++)
+            for (int b = a + 1; b < FACE_COUNT; b++)
+                if ((touched >> a) & (touched >> b) & 1)
+                    connections |= face_pair_bit(face_t(a), face_t(b));
+
+        if (connections == FACE_CONNECTIONS_ALL)
+            break;
+    }
+#undef VISITED_TEST
+#undef VISITED_SET
+
+    return connections;
+}
+
+void chunk_cubic_t::light_pass_block_setup()
+{
+    const Uint8* const light_levels = mc_id::block_properties.light_level;
 
     clear_light_block();
 
@@ -150,9 +232,7 @@ void chunk_cubic_t::light_pass_block_setup()
 /* TODO: Grab from 3x3x3 */
 void chunk_cubic_t::light_pass_block_grab_from_neighbors()
 {
-    bool is_transparent[256];
-    for (int i = 0; i < IM_ARRAYSIZE(is_transparent); i++)
-        is_transparent[i] = mc_id::is_transparent(i);
+    const mc_id::block_bitset_t& is_transparent = mc_id::block_properties.transparent;
 
     /* Get block light from face neighbors */
     /* <x0,y0,z0> refers to an internal block, <x1,y1,z1> refers to it's neighbor in a different chunk */
@@ -219,12 +299,9 @@ void chunk_cubic_t::light_pass_block_grab_from_neighbors()
             }
 }
 
-void chunk_cubic_t::light_pass_block_propagate_internals()
+void chunk_cubic_t::light_pass_block_propagate_internals_scalar()
 {
-    bool is_transparent[256];
-
-    for (int i = 0; i < IM_ARRAYSIZE(is_transparent); i++)
-        is_transparent[i] = mc_id::is_transparent(i);
+    const mc_id::block_bitset_t& is_transparent = mc_id::block_properties.transparent;
 
     /* Propagate light (Block) (Backwards, then forwards) */
     for (int dat_it = SUBCHUNK_SIZE_VOLUME - 1; dat_it > -SUBCHUNK_SIZE_VOLUME; dat_it--)
@@ -311,17 +388,10 @@ void chunk_cubic_t::light_pass_block_propagate_internals()
 /* TODO: Grab from 3x3x3 */
 void chunk_cubic_t::light_pass_sky_grab_from_neighbors()
 {
-    Uint8 decaying_types[256];
-    memset(decaying_types, 0, sizeof(decaying_types));
-
-    /* Move this out to something like mc_id::get_sky_light_attenuation() */
-    decaying_types[BLOCK_ID_LEAVES] = 1;
-    decaying_types[BLOCK_ID_WATER_FLOWING] = 1;
-    decaying_types[BLOCK_ID_WATER_SOURCE] = 1;
+    /* Only read for transparent blocks, so this is the extra attenuation of sky light traveling downwards */
+    const Uint8* const decaying_types = mc_id::block_properties.light_opacity;
 
-    bool is_transparent[256];
-    for (int i = 0; i < IM_ARRAYSIZE(is_transparent); i++)
-        is_transparent[i] = mc_id::is_transparent(i);
+    const mc_id::block_bitset_t& is_transparent = mc_id::block_properties.transparent;
 
     /* Get block light from face neighbors */
     /* <x0,y0,z0> refers to an internal block, <x1,y1,z1> refers to it's neighbor in a different chunk */
@@ -401,19 +471,12 @@ void chunk_cubic_t::light_pass_sky_grab_from_neighbors()
             }
 }
 
-void chunk_cubic_t::light_pass_sky_propagate_internals()
+void chunk_cubic_t::light_pass_sky_propagate_internals_scalar()
 {
-    Uint8 non_decaying_types[256];
-    memset(non_decaying_types, 1, sizeof(non_decaying_types));
+    /* Only read for transparent blocks, so this is the extra attenuation of sky light traveling downwards */
+    const Uint8* const decaying_types = mc_id::block_properties.light_opacity;
 
-    /* Move this out to something like mc_id::get_sky_light_attenuation() */
-    non_decaying_types[BLOCK_ID_LEAVES] = 0;
-    non_decaying_types[BLOCK_ID_WATER_FLOWING] = 0;
-    non_decaying_types[BLOCK_ID_WATER_SOURCE] = 0;
-
-    bool is_transparent[256];
-    for (int i = 0; i < IM_ARRAYSIZE(is_transparent); i++)
-        is_transparent[i] = mc_id::is_transparent(i);
+    const mc_id::block_bitset_t& is_transparent = mc_id::block_properties.transparent;
 
     /* Propagate light (Block) (Backwards, then forwards) */
     for (int dat_it = SUBCHUNK_SIZE_VOLUME - 1; dat_it > -SUBCHUNK_SIZE_VOLUME; dat_it--)
@@ -492,7 +555,7 @@ void chunk_cubic_t::light_pass_sky_propagate_internals()
         lvl = SDL_max(lvl, sur_levels[5]);
 
         /* Sky light does not decay downward through air */
-        lvl = SDL_max(lvl, sur_levels[1] + non_decaying_types[type]);
+        lvl = SDL_max(lvl, sur_levels[1] + 1 - decaying_types[type]);
 
         /* Move lvl from range [1,16] to [0,15] */
         lvl--;
@@ -500,3 +563,176 @@ void chunk_cubic_t::light_pass_sky_propagate_internals()
         set_light_sky(x, y, z, lvl);
     }
 }
+
+#ifdef SDL_SSE2_INTRINSICS
+/* Rows are the 16 voxels of constant x and z, which are contiguous in memory (See SUBCHUNK_INDEX) */
+static_assert(SUBCHUNK_SIZE_Y == 16, "Light row kernels assume a row fits exactly in one 128-bit register");
+static_assert(SUBCHUNK_INDEX(0, 1, 0) == 1, "Light row kernels assume rows are contiguous");
+
+/**
+ * Unpacks the 8 bytes of nibbles of a row into 16 bytes
+ */
+SDL_FORCE_INLINE __m128i light_row_load(const Uint8* const data, const int row)
+{
+    const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + row * SUBCHUNK_SIZE_Y / 2));
+    const __m128i mask = _mm_set1_epi8(0x0F);
+
+    /* Even indices live in the low nibble */
+    const __m128i lo = _mm_and_si128(packed, mask);
+    const __m128i hi = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+    return _mm_unpacklo_epi8(lo, hi);
+}
+
+/**
+ * Packs 16 bytes (all in the range [0, 15]) back into the 8 bytes of nibbles of a row
+ */
+SDL_FORCE_INLINE void light_row_store(Uint8* const data, const int row, const __m128i levels)
+{
+    const __m128i merged = _mm_and_si128(_mm_or_si128(levels, _mm_srli_epi16(levels, 4)), _mm_set1_epi16(0x00FF));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(data + row * SUBCHUNK_SIZE_Y / 2), _mm_packus_epi16(merged, _mm_setzero_si128()));
+}
+
+/**
+ * Vectorized equivalent of chunk_cubic_t::light_pass_*_propagate_internals_scalar()
+ *
+ * The scalar sweeps visit voxels backwards, then forwards, in memory order. Walking the rows in the same order means every
+ * row sees its x and z neighbors exactly as the scalar sweep would. Within a row the sweep is a running maximum that loses
+ * some light every step (and stops at opaque blocks), which is computed with a log-step scan instead of 16 dependent steps.
+ *
+ * Opaque blocks keep their value, but still pass it on to their transparent neighbors.
+ *
+ * @param light Nibble array to propagate (chunk_cubic_t::data_light_block or chunk_cubic_t::data_light_sky)
+ * @param types Block types of the chunk (chunk_cubic_t::data_block)
+ * @param sky Use the sky light rules (Light traveling downwards is attenuated by light_opacity instead of 1)
+ *
+ * @returns true if any transparent block was visited
+ */
+static bool light_propagate_internals_sse2(Uint8* const light, const Uint8* const types, const bool sky)
+{
+    const mc_id::block_bitset_t& is_transparent = mc_id::block_properties.transparent;
+    const Uint8* const decaying_types = mc_id::block_properties.light_opacity;
+
+    /* 0xFF for transparent blocks, and the attenuation of light traveling downwards into each block */
+    alignas(16) Uint8 gates[SUBCHUNK_SIZE_VOLUME];
+    alignas(16) Uint8 decays_down[SUBCHUNK_SIZE_VOLUME];
+
+    Uint8 any_transparent = 0;
+    for (int i = 0; i < SUBCHUNK_SIZE_VOLUME; i++)
+    {
+        gates[i] = is_transparent[types[i]] ? 0xFF : 0x00;
+        decays_down[i] = sky ? decaying_types[types[i]] : 1;
+        any_transparent |= gates[i];
+    }
+
+    if (!any_transparent)
+        return false;
+
+    const __m128i one = _mm_set1_epi8(1);
+    constexpr int NUM_ROWS = SUBCHUNK_SIZE_X * SUBCHUNK_SIZE_Z;
+
+    for (int sweep = 0; sweep < 2; sweep++)
+    {
+        const bool backwards = (sweep == 0);
+        for (int it = 0; it < NUM_ROWS; it++)
+        {
+            const int row = backwards ? (NUM_ROWS - 1 - it) : it;
+            const int z = row % SUBCHUNK_SIZE_Z;
+            const int x = row / SUBCHUNK_SIZE_Z;
+
+            __m128i gate = _mm_load_si128(reinterpret_cast<const __m128i*>(gates + row * SUBCHUNK_SIZE_Y));
+            const __m128i decay_down = _mm_load_si128(reinterpret_cast<const __m128i*>(decays_down + row * SUBCHUNK_SIZE_Y));
+            const __m128i cur = light_row_load(light, row);
+
+            /* Light from the x and z neighbors */
+            __m128i sur = _mm_setzero_si128();
+            if (x < SUBCHUNK_SIZE_X - 1)
+                sur = _mm_max_epu8(sur, light_row_load(light, row + SUBCHUNK_SIZE_Z));
+            if (x > 0)
+                sur = _mm_max_epu8(sur, light_row_load(light, row - SUBCHUNK_SIZE_Z));
+            if (z < SUBCHUNK_SIZE_Z - 1)
+                sur = _mm_max_epu8(sur, light_row_load(light, row + 1));
+            if (z > 0)
+                sur = _mm_max_epu8(sur, light_row_load(light, row - 1));
+
+            __m128i base = _mm_max_epu8(cur, _mm_subs_epu8(sur, one));
+
+            /* The neighbor within the row that has not been visited yet contributes it's old value, and the visited
+             * neighbor is folded in by the scan below. Byte shifts move values between neighboring y levels. */
+            __m128i decay;
+            if (backwards)
+            {
+                base = _mm_max_epu8(base, _mm_subs_epu8(_mm_slli_si128(cur, 1), one));
+                decay = sky ? decay_down : one;
+            }
+            else
+            {
+                base = _mm_max_epu8(base, _mm_subs_epu8(_mm_srli_si128(cur, 1), sky ? decay_down : one));
+                decay = one;
+            }
+
+            /* Opaque blocks are left untouched */
+            __m128i levels = _mm_or_si128(_mm_and_si128(gate, base), _mm_andnot_si128(gate, cur));
+
+/* After step s each voxel holds the best light from the s * 2 nearest voxels in the direction the sweep comes from,
+ * with gate/decay describing the span of s voxels starting at (and including) the voxel */
+#define LIGHT_SCAN_STEP(SHIFT, S)                                                                             \
+    do                                                                                                        \
+    {                                                                                                         \
+        const __m128i from = _mm_subs_epu8(SHIFT(levels, S), decay);                                          \
+        levels = _mm_max_epu8(levels, _mm_and_si128(gate, from));                                             \
+        decay = _mm_adds_epu8(decay, SHIFT(decay, S));                                                        \
+        gate = _mm_and_si128(gate, SHIFT(gate, S));                                                           \
+    } while (0)
+
+            if (backwards)
+            {
+                LIGHT_SCAN_STEP(_mm_srli_si128, 1);
+                LIGHT_SCAN_STEP(_mm_srli_si128, 2);
+                LIGHT_SCAN_STEP(_mm_srli_si128, 4);
+                LIGHT_SCAN_STEP(_mm_srli_si128, 8);
+            }
+            else
+            {
+                LIGHT_SCAN_STEP(_mm_slli_si128, 1);
+                LIGHT_SCAN_STEP(_mm_slli_si128, 2);
+                LIGHT_SCAN_STEP(_mm_slli_si128, 4);
+                LIGHT_SCAN_STEP(_mm_slli_si128, 8);
+            }
+#undef LIGHT_SCAN_STEP
+
+            light_row_store(light, row, levels);
+        }
+    }
+
+    return true;
+}
+#endif
+
+bool chunk_cubic_t::light_pass_is_vectorized()
+{
+#ifdef SDL_SSE2_INTRINSICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void chunk_cubic_t::light_pass_block_propagate_internals()
+{
+#ifdef SDL_SSE2_INTRINSICS
+    if (light_propagate_internals_sse2(data_light_block, data_block, false))
+        dirty_level = DIRTY_LEVEL_LIGHT_PASS_INTERNAL;
+#else
+    light_pass_block_propagate_internals_scalar();
+#endif
+}
+
+void chunk_cubic_t::light_pass_sky_propagate_internals()
+{
+#ifdef SDL_SSE2_INTRINSICS
+    if (light_propagate_internals_sse2(data_light_sky, data_block, true))
+        dirty_level = DIRTY_LEVEL_LIGHT_PASS_INTERNAL;
+#else
+    light_pass_sky_propagate_internals_scalar();
+#endif
+}
@@ -62,11 +62,58 @@ struct chunk_cubic_t
     };
     dirty_level_t dirty_level = DIRTY_LEVEL_LIGHT_PASS_INTERNAL;
 
+    /**
+     * Faces of a chunk, the first three point towards +XYZ, and the last three towards -XYZ
+     */
+    enum face_t
+    {
+        FACE_POS_X,
+        FACE_POS_Y,
+        FACE_POS_Z,
+        FACE_NEG_X,
+        FACE_NEG_Y,
+        FACE_NEG_Z,
+        FACE_COUNT,
+    };
+
+    static constexpr face_t face_opposite(const face_t face) { return face_t((face + 3) % 6); }
+
+    /** Offset in chunk coordinates to the neighbor on the other side of a face */
+    static constexpr int face_offsets[FACE_COUNT][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 }, { -1, 0, 0 }, { 0, -1, 0 }, { 0, 0, -1 } };
+
+    /**
+     * Bit in renderer_hints.face_connections representing a pair of (different) faces
+     */
+    static constexpr Uint16 face_pair_bit(const face_t a, const face_t b)
+    {
+        const int lo = (a < b) ? a : b;
+        const int hi = (a < b) ? b : a;
+        return Uint16(1) << (lo * (11 - lo) / 2 + hi - lo - 1);
+    }
+
+    /** Value of renderer_hints.face_connections when every face is connected to every other face */
+    static const Uint16 FACE_CONNECTIONS_ALL = 0x7FFF;
+
     /**
      * To be filled in by a culling pass
      */
     bool visible = 1;
 
+    /**
+     * Scratch flag for level_t::cave_cull()
+     */
+    bool cave_cull_reached = 0;
+
+    /**
+     * Set while the chunk is in a dirty list (See: level_t::mark_dirty() and level_t::propagate_dirty_levels())
+     */
+    bool dirty_queued = 0;
+
+    /**
+     * Scratch flag for level_t::propagate_dirty_levels()
+     */
+    bool dirty_spread = 0;
+
     struct
     {
         /**
@@ -122,7 +169,14 @@ struct chunk_cubic_t
 
         /** Face of blocks where (z = 0) is opaque */
         bool opaque_face_neg_z : 1;
-    } renderer_hints = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+        /**
+         * Pairs of faces that can see each other through a connected volume of transparent blocks (See: face_pair_bit())
+         *
+         * To be filled in by a renderer hint pass
+         */
+        Uint16 face_connections : 15;
+    } renderer_hints = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
     struct
     {
@@ -134,8 +188,22 @@ struct chunk_cubic_t
         chunk_cubic_t* neg_z = NULL;
     } neighbors;
 
+    /**
+     * All 26 neighbors, and self at [1][1][1], maintained by level_t::add_chunk() and level_t::remove_chunk()
+     *
+     * Index: [x + 1][y + 1][z + 1]
+     */
+    chunk_cubic_t* neighborhood[3][3][3] = {};
+
     gpu::subdiv_buffer_allocation_t* mesh_handle = nullptr;
 
+    /**
+     * Set every time a mesh build is started for this chunk, cleared by free_renderer_resources()
+     *
+     * Mesh results built for any other generation are stale and must be discarded
+     */
+    Uint64 mesh_generation = 0;
+
     Uint64 last_mesh_update_time = 0;
 
     Uint32 quad_count_opaque = 0;
@@ -170,6 +238,13 @@ struct chunk_cubic_t
      */
     void update_renderer_hints();
 
+    /**
+     * Flood fill everything but the opaque cubes of the chunk to find which faces can see each other
+     *
+     * @returns Value for renderer_hints.face_connections
+     */
+    Uint16 find_face_connections() const;
+
     /**
      * Sets block light levels according to block type
      *
@@ -185,9 +260,17 @@ struct chunk_cubic_t
 
     /**
      * Internally propagate block light
+     *
+     * Uses the row kernel when available (See light_pass_is_vectorized()), which produces exactly the same result as
+     * light_pass_block_propagate_internals_scalar()
      */
     void light_pass_block_propagate_internals();
 
+    /**
+     * Scalar reference implementation of light_pass_block_propagate_internals()
+     */
+    void light_pass_block_propagate_internals_scalar();
+
     /**
      * Grab block light from neighbors
      */
@@ -208,9 +291,22 @@ struct chunk_cubic_t
 
     /**
      * Internally propagate sky light
+     *
+     * Uses the row kernel when available (See light_pass_is_vectorized()), which produces exactly the same result as
+     * light_pass_sky_propagate_internals_scalar()
      */
     void light_pass_sky_propagate_internals();
 
+    /**
+     * Scalar reference implementation of light_pass_sky_propagate_internals()
+     */
+    void light_pass_sky_propagate_internals_scalar();
+
+    /**
+     * @returns true if light_pass_*_propagate_internals() use SIMD row kernels instead of the scalar reference implementations
+     */
+    static bool light_pass_is_vectorized();
+
     /**
      * Check if light can propagate from this chunk to others
      *
@@ -244,7 +340,7 @@ struct chunk_cubic_t
     }
 
     /**
-     * Free renderer resources (duh..)
+     * Free renderer resources (duh..), this also invalidates any mesh builds in flight
      *
      * In the past this function reset the dirty_level to DIRTY_LEVEL_LIGHT_PASS_INTERNAL,
      * however that caused problems when this function was used under the assumption that it would not change the dirty_level
@@ -256,6 +352,8 @@ struct chunk_cubic_t
     /**
      * Finds a chunk by recursively searching from the origin
      *
+     * Targets within the 3x3x3 neighborhood of the origin are a single load from chunk_cubic_t::neighborhood
+     *
      * @param origin Chunk to start from
      * @param target Coordinates of target chunk
      *
@@ -271,6 +369,9 @@ struct chunk_cubic_t
         if (diff == decltype(chunk_cubic_t::pos)(0))
             return origin;
 
+        if (Uint32(diff.x + 1) < 3 && Uint32(diff.y + 1) < 3 && Uint32(diff.z + 1) < 3)
+            return origin->neighborhood[diff.x + 1][diff.y + 1][diff.z + 1];
+
         if (origin->neighbors.pos_x && diff.x > 0 && (t = find_chunk(origin->neighbors.pos_x, target)) && t->pos == target)
             return t;
         if (origin->neighbors.pos_y && diff.y > 0 && (t = find_chunk(origin->neighbors.pos_y, target)) && t->pos == target)
@@ -0,0 +1,392 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "chunk_decompress.h"
+
+#include "tetra/log.h"
+
+#include <zlib.h>
+
+#pragma GCC push_options
+#pragma GCC optimize("O3")
+
+/**
+ * Copy a row of block ids, while replacing invalid ids with air
+ *
+ * @returns All copied ids OR'd together
+ */
+static Uint8 copy_block_row(Uint8* const dst, const Uint8* const src, const int len)
+{
+    Uint8 total = 0;
+    for (int i = 0; i < len; i++)
+    {
+        /* We don't assert because this function may process uninitialized data */
+        const Uint8 type = (src[i] < BLOCK_ID_NUM_USED) ? src[i] : 0;
+        dst[i] = type;
+        total |= type;
+    }
+    return total;
+}
+
+/**
+ * Copy a row of nibbles between two nibble arrays (Even indices in the low nibble, odd indices in the high nibble)
+ *
+ * @param dst Destination nibble array
+ * @param dst_idx Nibble index of the start of the row in dst
+ * @param src Source nibble array
+ * @param src_idx Nibble index of the start of the row in src
+ * @param len Number of nibbles to copy
+ */
+static void copy_nibble_row(Uint8* const dst, size_t dst_idx, const Uint8* const src, size_t src_idx, int len)
+{
+#define GET_NIBBLE(ARR, IDX) (((IDX) % 2 == 1) ? (((ARR)[(IDX) / 2] >> 4) & 0x0F) : ((ARR)[(IDX) / 2] & 0x0F))
+#define SET_NIBBLE(ARR, IDX, VAL)                                                       \
+    do                                                                                  \
+    {                                                                                   \
+        if ((IDX) % 2 == 1)                                                             \
+            (ARR)[(IDX) / 2] = (((VAL) & 0x0F) << 4) | ((ARR)[(IDX) / 2] & 0x0F);       \
+        else                                                                            \
+            (ARR)[(IDX) / 2] = ((VAL) & 0x0F) | ((ARR)[(IDX) / 2] & 0xF0);              \
+    } while (0)
+
+    /* Mismatched parity means every nibble has to be shifted */
+    if (dst_idx % 2 != src_idx % 2)
+    {
+        for (int i = 0; i < len; i++, dst_idx++, src_idx++)
+            SET_NIBBLE(dst, dst_idx, GET_NIBBLE(src, src_idx));
+        return;
+    }
+
+    /* Matching parity allows copying whole bytes, with at most a lone nibble on each end */
+    if (len > 0 && dst_idx % 2 == 1)
+    {
+        SET_NIBBLE(dst, dst_idx, GET_NIBBLE(src, src_idx));
+        dst_idx++, src_idx++, len--;
+    }
+
+    memcpy(dst + dst_idx / 2, src + src_idx / 2, len / 2);
+
+    if (len % 2 == 1)
+    {
+        dst_idx += len - 1, src_idx += len - 1;
+        SET_NIBBLE(dst, dst_idx, GET_NIBBLE(src, src_idx));
+    }
+#undef GET_NIBBLE
+#undef SET_NIBBLE
+}
+
+void decoded_chunk_packet_t::release()
+{
+    for (piece_t& piece : pieces)
+    {
+        delete piece.data;
+        piece.data = NULL;
+    }
+    pieces.clear();
+}
+
+bool decode_chunk_packet(const packet_chunk_t* const p, std::vector<Uint8>& buffer, decoded_chunk_packet_t& out)
+{
+    out.pieces.clear();
+    out.ok = 0;
+
+    if (p->size_x < 0 || p->size_y < 0 || p->size_z < 0)
+    {
+        dc_log_error("Chunk packet with invalid size of <%d, %d, %d>", p->size_x, p->size_y, p->size_z);
+        return false;
+    }
+
+    out.block_min = glm::ivec3(p->block_x, p->block_y, p->block_z);
+    out.block_max = out.block_min + glm::ivec3(p->size_x, p->size_y, p->size_z);
+    out.chunk_min = out.block_min >> 4;
+    out.chunk_max = out.block_max >> 4;
+
+    const int real_size_x = p->size_x + 1;
+    const int real_size_y = p->size_y + 1;
+    const int real_size_z = p->size_z + 1;
+    const int real_volume = (real_size_x * real_size_y * real_size_z);
+
+    /* Oversize the buffer a small amount in case weirdness occurs  */
+    long unsigned int uncompressed_size = real_size_x * real_size_y * real_size_z * 41 / 16 + 1;
+    if (uncompressed_size > buffer.size())
+    {
+        dc_log("Resizing decompression buffer to %zu", uncompressed_size);
+        buffer.resize(uncompressed_size, 0);
+    }
+    Uint8* uncompressed = buffer.data();
+    memset(uncompressed + uncompressed_size, 0, buffer.size() - uncompressed_size);
+
+    int decompress_result = uncompress(uncompressed, &uncompressed_size, p->compressed_data.data(), p->compressed_data.size());
+
+    TRACE("%d %d %d | %d %d %d", out.chunk_min.x, out.chunk_min.y, out.chunk_min.z, out.chunk_max.x, out.chunk_max.y, out.chunk_max.z);
+
+    if (decompress_result != Z_OK)
+    {
+        const char* err_str = "Unknown error";
+        switch (decompress_result)
+        {
+            ENUM_SWITCH_CASE(err_str, Z_OK);
+            ENUM_SWITCH_CASE(err_str, Z_STREAM_END);
+            ENUM_SWITCH_CASE(err_str, Z_NEED_DICT);
+            ENUM_SWITCH_CASE(err_str, Z_ERRNO);
+            ENUM_SWITCH_CASE(err_str, Z_STREAM_ERROR);
+            ENUM_SWITCH_CASE(err_str, Z_DATA_ERROR);
+            ENUM_SWITCH_CASE(err_str, Z_MEM_ERROR);
+            ENUM_SWITCH_CASE(err_str, Z_BUF_ERROR);
+            ENUM_SWITCH_CASE(err_str, Z_VERSION_ERROR);
+        default:
+            break;
+        }
+        dc_log_error("Error %d (%s) decompressing chunk data!", decompress_result, err_str);
+    }
+
+    /* The packet is laid out as 4 arrays (Block ids, metadata, block light, sky light) in XZY order, which matches the order within
+     * a chunk, so every (x, z) column is a contiguous row in both and can be copied in one go instead of voxel by voxel */
+    const size_t nibble_base_metadata = size_t(real_volume) * 2;
+    const size_t nibble_base_light_block = size_t(real_volume) * 3;
+    const size_t nibble_base_light_sky = size_t(real_volume) * 4;
+
+    for (int chunk_x = out.chunk_min.x; chunk_x <= out.chunk_max.x; chunk_x++)
+        for (int chunk_z = out.chunk_min.z; chunk_z <= out.chunk_max.z; chunk_z++)
+            for (int chunk_y = out.chunk_min.y; chunk_y <= out.chunk_max.y; chunk_y++)
+            {
+                const glm::ivec3 chunk_pos(chunk_x, chunk_y, chunk_z);
+                const glm::ivec3 chunk_origin = chunk_pos << 4;
+
+                decoded_chunk_packet_t::piece_t piece;
+                piece.min = glm::max(out.block_min - chunk_origin, glm::ivec3(0));
+                piece.max = glm::min(out.block_max - chunk_origin, glm::ivec3(SUBCHUNK_SIZE_X - 1, SUBCHUNK_SIZE_Y - 1, SUBCHUNK_SIZE_Z - 1));
+                piece.data = new chunk_cubic_t();
+                piece.data->pos = chunk_pos;
+
+                chunk_cubic_t* const c = piece.data;
+                const int row_len = piece.max.y - piece.min.y + 1;
+                Uint8 total_block = 0;
+
+                for (int x = piece.min.x; x <= piece.max.x; x++)
+                {
+                    const int uncompressed_x = chunk_origin.x + x - out.block_min.x;
+                    for (int z = piece.min.z; z <= piece.max.z; z++)
+                    {
+                        const int uncompressed_z = chunk_origin.z + z - out.block_min.z;
+                        const int uncompressed_y = chunk_origin.y + piece.min.y - out.block_min.y;
+
+                        const size_t index = uncompressed_y + (uncompressed_z * (real_size_y)) + (uncompressed_x * (real_size_y) * (real_size_z));
+                        const size_t index_chunk = SUBCHUNK_INDEX(x, piece.min.y, z);
+
+                        total_block |= copy_block_row(c->data_block + index_chunk, uncompressed + index, row_len);
+                        copy_nibble_row(c->data_metadata, index_chunk, uncompressed, nibble_base_metadata + index, row_len);
+                        copy_nibble_row(c->data_light_block, index_chunk, uncompressed, nibble_base_light_block + index, row_len);
+                        copy_nibble_row(c->data_light_sky, index_chunk, uncompressed, nibble_base_light_sky + index, row_len);
+                    }
+                }
+
+                piece.uniform_air = (total_block == 0);
+                out.pieces.push_back(piece);
+            }
+
+    out.ok = (decompress_result == Z_OK);
+    return out.ok;
+}
+
+void apply_decoded_chunk_packet(decoded_chunk_packet_t& decoded, const chunk_lookup_func_t& lookup)
+{
+    for (decoded_chunk_packet_t::piece_t& piece : decoded.pieces)
+    {
+        /* Find chunk or create new a one */
+        chunk_cubic_t* c = lookup(piece.data->pos, true);
+        if (!c)
+        {
+            dc_log_error("Chunk is null at <%d, %d, %d>", piece.data->pos.x, piece.data->pos.y, piece.data->pos.z);
+            continue;
+        }
+
+        if (piece.is_full())
+        {
+            memcpy(c->data_block, piece.data->data_block, sizeof(c->data_block));
+            memcpy(c->data_metadata, piece.data->data_metadata, sizeof(c->data_metadata));
+            memcpy(c->data_light_block, piece.data->data_light_block, sizeof(c->data_light_block));
+            memcpy(c->data_light_sky, piece.data->data_light_sky, sizeof(c->data_light_sky));
+        }
+        else
+        {
+            const int row_len = piece.max.y - piece.min.y + 1;
+            for (int x = piece.min.x; x <= piece.max.x; x++)
+                for (int z = piece.min.z; z <= piece.max.z; z++)
+                {
+                    const size_t index = SUBCHUNK_INDEX(x, piece.min.y, z);
+                    memcpy(c->data_block + index, piece.data->data_block + index, row_len);
+                    copy_nibble_row(c->data_metadata, index, piece.data->data_metadata, index, row_len);
+                    copy_nibble_row(c->data_light_block, index, piece.data->data_light_block, index, row_len);
+                    copy_nibble_row(c->data_light_sky, index, piece.data->data_light_sky, index, row_len);
+                }
+        }
+
+        /* A chunk that is entirely air has trivial hints, so the renderer hint pass can skip it */
+        memset(&c->renderer_hints, 0, sizeof(c->renderer_hints));
+        if (piece.is_full() && piece.uniform_air)
+        {
+            c->renderer_hints.uniform_air = 1;
+            c->renderer_hints.face_connections = chunk_cubic_t::FACE_CONNECTIONS_ALL;
+            c->renderer_hints.hints_set = 1;
+        }
+
+        c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
+    }
+
+    /* Mark surrounding chunks for re-meshing */
+    for (int x = decoded.chunk_min.x - 1; x <= decoded.chunk_max.x + 1; x++)
+    {
+        for (int y = decoded.chunk_min.y - 1; y <= decoded.chunk_max.y + 1; y++)
+        {
+            for (int z = decoded.chunk_min.z - 1; z <= decoded.chunk_max.z + 1; z++)
+            {
+                if (BETWEEN_INCL(x, decoded.chunk_min.x, decoded.chunk_max.x) && BETWEEN_INCL(y, decoded.chunk_min.y, decoded.chunk_max.y)
+                    && BETWEEN_INCL(z, decoded.chunk_min.z, decoded.chunk_max.z))
+                    continue;
+
+                chunk_cubic_t* c = lookup(glm::ivec3(x, y, z), false);
+                if (c && c->dirty_level < chunk_cubic_t::DIRTY_LEVEL_MESH)
+                    c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
+            }
+        }
+    }
+
+    decoded.release();
+}
+#pragma GCC pop_options
+
+bool decompress_chunk_packet(const packet_chunk_t* const p, std::vector<Uint8>& buffer, const chunk_lookup_func_t& lookup)
+{
+    decoded_chunk_packet_t decoded;
+    const bool ret = decode_chunk_packet(p, buffer, decoded);
+    apply_decoded_chunk_packet(decoded, lookup);
+    return ret;
+}
+
+int chunk_decompress_worker_t::thread_func(void* userdata)
+{
+    chunk_decompress_worker_t* worker = (chunk_decompress_worker_t*)userdata;
+
+    SDL_LockMutex(worker->lock);
+    while (!worker->quit)
+    {
+        if (worker->jobs.empty())
+        {
+            SDL_WaitCondition(worker->cond_jobs, worker->lock);
+            continue;
+        }
+
+        packet_chunk_t* p = worker->jobs.front();
+        worker->jobs.pop_front();
+        SDL_UnlockMutex(worker->lock);
+
+        decoded_chunk_packet_t decoded;
+        decode_chunk_packet(p, worker->buffer, decoded);
+        delete p;
+
+        SDL_LockMutex(worker->lock);
+        worker->done.push_back(decoded);
+        SDL_BroadcastCondition(worker->cond_done);
+    }
+    SDL_UnlockMutex(worker->lock);
+
+    return 0;
+}
+
+chunk_decompress_worker_t::chunk_decompress_worker_t()
+{
+    lock = SDL_CreateMutex();
+    cond_jobs = SDL_CreateCondition();
+    cond_done = SDL_CreateCondition();
+}
+
+void chunk_decompress_worker_t::submit(packet_chunk_t* const p)
+{
+    if (!thread && !thread_failed)
+    {
+        thread = SDL_CreateThread(thread_func, "Chunk decompression", this);
+
+        if (!thread)
+        {
+            dc_log_error("Unable to create chunk decompression thread: %s", SDL_GetError());
+            thread_failed = true;
+        }
+    }
+
+    /* Fall back to decoding on the calling thread */
+    if (!thread)
+    {
+        decoded_chunk_packet_t decoded;
+        decode_chunk_packet(p, buffer, decoded);
+        delete p;
+
+        SDL_LockMutex(lock);
+        done.push_back(decoded);
+        SDL_UnlockMutex(lock);
+        in_flight++;
+        return;
+    }
+
+    SDL_LockMutex(lock);
+    jobs.push_back(p);
+    SDL_SignalCondition(cond_jobs);
+    SDL_UnlockMutex(lock);
+    in_flight++;
+}
+
+void chunk_decompress_worker_t::collect(std::vector<decoded_chunk_packet_t>& out, const bool wait)
+{
+    if (!in_flight)
+        return;
+
+    SDL_LockMutex(lock);
+    while (wait && done.size() < in_flight)
+        SDL_WaitCondition(cond_done, lock);
+
+    in_flight -= done.size();
+    for (decoded_chunk_packet_t& it : done)
+        out.push_back(it);
+    done.clear();
+    SDL_UnlockMutex(lock);
+}
+
+chunk_decompress_worker_t::~chunk_decompress_worker_t()
+{
+    if (thread)
+    {
+        SDL_LockMutex(lock);
+        quit = true;
+        SDL_BroadcastCondition(cond_jobs);
+        SDL_UnlockMutex(lock);
+        SDL_WaitThread(thread, NULL);
+    }
+
+    for (packet_chunk_t* p : jobs)
+        delete p;
+    for (decoded_chunk_packet_t& it : done)
+        it.release();
+
+    SDL_DestroyCondition(cond_done);
+    SDL_DestroyCondition(cond_jobs);
+    SDL_DestroyMutex(lock);
+}
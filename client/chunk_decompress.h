@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "chunk_cubic.h"
+#include "shared/packet.h"
+
+/**
+ * Chunk lookup function used by decompress_chunk_packet()
+ *
+ * @param pos Position of the chunk in chunk coordinates
+ * @param create Create the chunk if it does not already exist
+ *
+ * @returns Chunk at pos, or NULL if it does not exist (or could not be created)
+ */
+typedef std::function<chunk_cubic_t*(const glm::ivec3 pos, const bool create)> chunk_lookup_func_t;
+
+/**
+ * Contents of a chunk packet transposed into chunk_cubic_t storage, but not yet written to any live chunks
+ */
+struct decoded_chunk_packet_t
+{
+    /** Block volume covered by the packet (Inclusive) */
+    glm::ivec3 block_min = { 0, 0, 0 };
+    glm::ivec3 block_max = { 0, 0, 0 };
+
+    /** Chunk volume covered by the packet (Inclusive) */
+    glm::ivec3 chunk_min = { 0, 0, 0 };
+    glm::ivec3 chunk_max = { 0, 0, 0 };
+
+    struct piece_t
+    {
+        /** Staging chunk, only the voxels inside [min, max] hold data from the packet */
+        chunk_cubic_t* data = NULL;
+
+        /** Region of the chunk covered by the packet in chunk local block coordinates (Inclusive) */
+        glm::ivec3 min = { 0, 0, 0 };
+        glm::ivec3 max = { 0, 0, 0 };
+
+        /** True if the covered region is made entirely of air */
+        bool uniform_air = 0;
+
+        inline bool is_full() const { return min == glm::ivec3(0) && max == glm::ivec3(SUBCHUNK_SIZE_X - 1, SUBCHUNK_SIZE_Y - 1, SUBCHUNK_SIZE_Z - 1); }
+    };
+
+    std::vector<piece_t> pieces;
+
+    /** False if the packet was malformed or the data could not be decompressed */
+    bool ok = 0;
+
+    /**
+     * Deletes the staging chunks
+     */
+    void release();
+};
+
+/**
+ * Parse/Decompress a chunk packet into staging chunks
+ *
+ * NOTE: This does not touch any live chunks, so it is safe to call from any thread
+ *
+ * @param p Chunk packet to parse and decompress
+ * @param buffer Buffer used for temporarily storing data, the intent is to reduce allocations \n
+ *               by allowing the same buffer to be reused over the life of the connection
+ * @param out Output, previous contents are discarded (but not released)
+ *
+ * @returns true if the packet was decompressed without errors, false otherwise
+ */
+bool decode_chunk_packet(const packet_chunk_t* const p, std::vector<Uint8>& buffer, decoded_chunk_packet_t& out);
+
+/**
+ * Write a decoded chunk packet to the chunks returned by lookup, and release the staging chunks
+ *
+ * Chunks written to and existing chunks adjacent to the packet volume will have their dirty level raised to chunk_cubic_t::DIRTY_LEVEL_MESH
+ *
+ * @param decoded Decoded packet
+ * @param lookup Function to find (and optionally create) chunks
+ */
+void apply_decoded_chunk_packet(decoded_chunk_packet_t& decoded, const chunk_lookup_func_t& lookup);
+
+/**
+ * Parse/Decompress a chunk packet and write the changes to the chunks returned by lookup
+ *
+ * Wrapper around decode_chunk_packet() and apply_decoded_chunk_packet()
+ *
+ * @param p Chunk packet to parse and decompress
+ * @param buffer Buffer used for temporarily storing data, the intent is to reduce allocations \n
+ *               by allowing the same buffer to be reused over the life of the connection
+ * @param lookup Function to find (and optionally create) chunks
+ *
+ * @returns true if the packet was decompressed without errors, false otherwise
+ */
+bool decompress_chunk_packet(const packet_chunk_t* const p, std::vector<Uint8>& buffer, const chunk_lookup_func_t& lookup);
+
+/**
+ * Decodes chunk packets on a background thread, packets are decoded and returned in the order they were submitted
+ *
+ * Thread-Safety
+ * It is not safe to access an instance of chunk_decompress_worker_t from multiple threads at once
+ */
+struct chunk_decompress_worker_t
+{
+    chunk_decompress_worker_t();
+    ~chunk_decompress_worker_t();
+
+    /**
+     * Queue a packet for decoding (The thread is started on the first call, if that fails packets are decoded on the calling thread)
+     *
+     * @param p Packet to decode, ownership is transferred to the worker
+     */
+    void submit(packet_chunk_t* const p);
+
+    /**
+     * Moves decoded packets to out (in submission order)
+     *
+     * @param out Output, packets are appended
+     * @param wait Block until every submitted packet has been decoded
+     */
+    void collect(std::vector<decoded_chunk_packet_t>& out, const bool wait);
+
+    /**
+     * Returns the number of packets submitted but not yet collected
+     */
+    inline size_t get_in_flight() const { return in_flight; }
+
+private:
+    static int thread_func(void* userdata);
+
+    SDL_Thread* thread = nullptr;
+
+    /** Set once creating the thread failed, so that it is not attempted again */
+    bool thread_failed = false;
+
+    /** Guards jobs, done, and quit */
+    SDL_Mutex* lock = nullptr;
+    SDL_Condition* cond_jobs = nullptr;
+    SDL_Condition* cond_done = nullptr;
+    std::deque<packet_chunk_t*> jobs;
+    std::deque<decoded_chunk_packet_t> done;
+    bool quit = false;
+
+    /** Only accessed by the owning thread */
+    size_t in_flight = 0;
+
+    /** Only accessed by the worker thread */
+    std::vector<Uint8> buffer;
+};
@@ -0,0 +1,194 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "chunk_grid.h"
+
+size_t chunk_grid_t::ivec3_hash_t::operator()(const glm::ivec3& pos) const
+{
+    /* FNV-1a over the fields */
+    Uint64 hash = 0xcbf29ce484222325;
+    for (int i = 0; i < 3; i++)
+        hash = (hash ^ Uint64(Uint32(pos[i]))) * 0x100000001b3;
+    return size_t(hash);
+}
+
+chunk_grid_t::chunk_grid_t()
+{
+    slots.resize(size_t(1) << (extent_log2.x + extent_log2.y + extent_log2.z), NULL);
+    origin = -(glm::ivec3(1) << extent_log2) / 2;
+}
+
+bool chunk_grid_t::insert(chunk_cubic_t* const c)
+{
+    if (find(c->pos))
+        return false;
+
+    if (in_window(c->pos))
+        slots[slot_index(c->pos)] = c;
+    else
+        outside[c->pos] = c;
+
+    count++;
+    return true;
+}
+
+chunk_cubic_t* chunk_grid_t::erase(const glm::ivec3 pos)
+{
+    chunk_cubic_t* c = NULL;
+
+    if (in_window(pos))
+        std::swap(c, slots[slot_index(pos)]);
+    else
+    {
+        auto it = outside.find(pos);
+        if (it != outside.end())
+        {
+            c = it->second;
+            outside.erase(it);
+        }
+    }
+
+    if (c)
+        count--;
+
+    return c;
+}
+
+void chunk_grid_t::link_neighbors(chunk_cubic_t* const c) const
+{
+    /* Assign neighbors (and self as neighbor to neighbors) */
+    for (int i = 0; i < 27; i++)
+    {
+        const int ix = (i / 9) % 3 - 1;
+        const int iy = (i / 3) % 3 - 1;
+        const int iz = i % 3 - 1;
+
+        chunk_cubic_t* n = find(c->pos + glm::ivec3(ix, iy, iz));
+        c->neighborhood[ix + 1][iy + 1][iz + 1] = n;
+        if (n)
+            n->neighborhood[1 - ix][1 - iy][1 - iz] = c;
+    }
+
+    c->neighbors.pos_x = c->neighborhood[2][1][1];
+    c->neighbors.neg_x = c->neighborhood[0][1][1];
+    c->neighbors.pos_y = c->neighborhood[1][2][1];
+    c->neighbors.neg_y = c->neighborhood[1][0][1];
+    c->neighbors.pos_z = c->neighborhood[1][1][2];
+    c->neighbors.neg_z = c->neighborhood[1][1][0];
+
+    /* Assign self as neighbor to neighbors */
+    // clang-format off
+    if (c->neighbors.pos_x != NULL) c->neighbors.pos_x->neighbors.neg_x = c;
+    if (c->neighbors.neg_x != NULL) c->neighbors.neg_x->neighbors.pos_x = c;
+    if (c->neighbors.pos_y != NULL) c->neighbors.pos_y->neighbors.neg_y = c;
+    if (c->neighbors.neg_y != NULL) c->neighbors.neg_y->neighbors.pos_y = c;
+    if (c->neighbors.pos_z != NULL) c->neighbors.pos_z->neighbors.neg_z = c;
+    if (c->neighbors.neg_z != NULL) c->neighbors.neg_z->neighbors.pos_z = c;
+    // clang-format on
+}
+
+void chunk_grid_t::unlink_neighbors(chunk_cubic_t* const c)
+{
+    /* Remove self as neighbor from neighbors */
+    for (int i = 0; i < 27; i++)
+    {
+        const int ix = (i / 9) % 3 - 1;
+        const int iy = (i / 3) % 3 - 1;
+        const int iz = i % 3 - 1;
+
+        chunk_cubic_t* n = c->neighborhood[ix + 1][iy + 1][iz + 1];
+        if (n && n != c)
+            n->neighborhood[1 - ix][1 - iy][1 - iz] = NULL;
+    }
+
+    // clang-format off
+    if (c->neighbors.pos_x) c->neighbors.pos_x->neighbors.neg_x = NULL;
+    if (c->neighbors.neg_x) c->neighbors.neg_x->neighbors.pos_x = NULL;
+    if (c->neighbors.pos_y) c->neighbors.pos_y->neighbors.neg_y = NULL;
+    if (c->neighbors.neg_y) c->neighbors.neg_y->neighbors.pos_y = NULL;
+    if (c->neighbors.pos_z) c->neighbors.pos_z->neighbors.neg_z = NULL;
+    if (c->neighbors.neg_z) c->neighbors.neg_z->neighbors.pos_z = NULL;
+    // clang-format on
+}
+
+void chunk_grid_t::clear()
+{
+    for (chunk_cubic_t*& c : slots)
+        c = NULL;
+    outside.clear();
+    count = 0;
+}
+
+void chunk_grid_t::recenter(const glm::ivec3 center, const int radius)
+{
+    /* One extra chunk so that the 3x3x3 neighborhood of every chunk within the radius is also inside the window */
+    const int reach = radius + 1;
+
+    /* The window is sized with room for the center to drift this far before everything within reach has to be moved */
+    const int margin = SDL_max(reach / 4, 1);
+
+    const int diameter = (reach + margin) * 2 + 1;
+    int log2 = EXTENT_LOG2_MIN;
+    while ((1 << log2) < diameter && log2 < EXTENT_LOG2_MAX_XZ)
+        log2++;
+
+    const glm::ivec3 new_extent_log2(log2, SDL_min(log2, int(EXTENT_LOG2_MAX_Y)), log2);
+    const glm::ivec3 new_extent = glm::ivec3(1) << new_extent_log2;
+
+    if (new_extent_log2 == extent_log2)
+    {
+        bool fits = true;
+        for (int i = 0; i < 3; i++)
+        {
+            const int min = center[i] - reach - origin[i];
+            const int max = center[i] + reach - origin[i];
+
+            /* A capped window cannot hold everything within reach, so the center is only kept within a quarter of the window of the middle */
+            if (new_extent[i] < reach * 2 + 1)
+                fits = fits && SDL_abs(center[i] - (origin[i] + new_extent[i] / 2)) <= new_extent[i] / 4;
+            else
+                fits = fits && min >= 0 && max < new_extent[i];
+        }
+        if (fits)
+            return;
+    }
+
+    std::vector<chunk_cubic_t*> chunks;
+    chunks.reserve(count);
+    for (chunk_cubic_t* c : slots)
+        if (c)
+            chunks.push_back(c);
+    for (auto it : outside)
+        chunks.push_back(it.second);
+
+    if (new_extent_log2 != extent_log2)
+    {
+        extent_log2 = new_extent_log2;
+        slots.assign(size_t(1) << (extent_log2.x + extent_log2.y + extent_log2.z), NULL);
+    }
+
+    clear();
+    origin = center - new_extent / 2;
+
+    for (chunk_cubic_t* c : chunks)
+        insert(c);
+}
@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <glm/glm.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+#include "chunk_cubic.h"
+
+/**
+ * Chunk index made of a dense toroidal window of slots around a center, plus a hash map for everything outside of the window
+ *
+ * A chunk inside the window lives in the slot selected by the low bits of its coordinates, so a lookup is a bounds check and a load
+ *
+ * NOTE: This does not own the chunks
+ */
+struct chunk_grid_t
+{
+    /** Log2 of the smallest allowed window extent */
+    static const int EXTENT_LOG2_MIN = 3;
+
+    /** Log2 of the largest allowed horizontal window extent */
+    static const int EXTENT_LOG2_MAX_XZ = 7;
+
+    /** Log2 of the largest allowed vertical window extent */
+    static const int EXTENT_LOG2_MAX_Y = 5;
+
+    chunk_grid_t();
+
+    /**
+     * Finds a chunk
+     *
+     * @returns Chunk at pos if found, NULL otherwise
+     */
+    inline chunk_cubic_t* find(const glm::ivec3 pos) const
+    {
+        if (in_window(pos))
+            return slots[slot_index(pos)];
+
+        if (outside.empty())
+            return NULL;
+
+        auto it = outside.find(pos);
+        return (it == outside.end()) ? NULL : it->second;
+    }
+
+    /**
+     * Inserts a chunk at c->pos
+     *
+     * @returns false if a chunk is already present at c->pos
+     */
+    bool insert(chunk_cubic_t* const c);
+
+    /**
+     * Removes a chunk (without deleting it)
+     *
+     * @returns The removed chunk, or NULL if there was no chunk at pos
+     */
+    chunk_cubic_t* erase(const glm::ivec3 pos);
+
+    /**
+     * Fills c->neighborhood and c->neighbors from the grid, and adds c to the neighbor tables of the chunks around it
+     *
+     * NOTE: c should already be in the grid
+     */
+    void link_neighbors(chunk_cubic_t* const c) const;
+
+    /**
+     * Removes c from the neighbor tables of the chunks around it
+     */
+    static void unlink_neighbors(chunk_cubic_t* const c);
+
+    /**
+     * Removes all chunks (without deleting them)
+     */
+    void clear();
+
+    /**
+     * Moves and/or resizes the window, chunks are shuffled between the window and the hash map as needed
+     *
+     * The window is sized with a margin around the radius and only moved once something within the radius would leave it, so this is cheap to call every frame
+     *
+     * @param center Chunk coordinates the window should be centered around
+     * @param radius Distance (in chunks) from the center that should fit inside the window
+     */
+    void recenter(const glm::ivec3 center, const int radius);
+
+    /** @returns Number of chunks in the grid */
+    inline size_t size() const { return count; }
+
+    /** @returns Number of chunks outside of the window */
+    inline size_t size_outside() const { return outside.size(); }
+
+private:
+    struct ivec3_hash_t
+    {
+        size_t operator()(const glm::ivec3& pos) const;
+    };
+
+    inline bool in_window(const glm::ivec3 pos) const
+    {
+        const glm::ivec3 rel = pos - origin;
+        return Uint32(rel.x) < Uint32(1 << extent_log2.x) && Uint32(rel.y) < Uint32(1 << extent_log2.y) && Uint32(rel.z) < Uint32(1 << extent_log2.z);
+    }
+
+    /** Index of the slot a position inside the window maps to, Index: [x][z][y] */
+    inline size_t slot_index(const glm::ivec3 pos) const
+    {
+        const glm::ivec3 wrapped = pos & ((glm::ivec3(1) << extent_log2) - 1);
+        return size_t(wrapped.y) | (size_t(wrapped.z) << extent_log2.y) | (size_t(wrapped.x) << (extent_log2.y + extent_log2.z));
+    }
+
+    /** Lowest corner of the window (Inclusive) */
+    glm::ivec3 origin = { 0, 0, 0 };
+    glm::ivec3 extent_log2 = { EXTENT_LOG2_MIN, EXTENT_LOG2_MIN, EXTENT_LOG2_MIN };
+
+    std::vector<chunk_cubic_t*> slots;
+    std::unordered_map<glm::ivec3, chunk_cubic_t*, ivec3_hash_t> outside;
+
+    size_t count = 0;
+};
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "climate_cache.h"
+
+climate_cache_t::climate_cache_t() { lock = SDL_CreateMutex(); }
+
+climate_cache_t::~climate_cache_t()
+{
+    clear();
+    SDL_DestroyMutex(lock);
+}
+
+size_t climate_cache_t::key_hash_t::operator()(const key_t& k) const
+{
+    /* FNV-1a over the fields */
+    Uint64 hash = 0xcbf29ce484222325;
+    const Sint64 fields[] = { k.x, k.z, k.seed, k.dimension, k.blend };
+    for (const Sint64 f : fields)
+        hash = (hash ^ Uint64(f)) * 0x100000001b3;
+    return size_t(hash);
+}
+
+bool climate_cache_t::get(const key_t& key, climate_column_t& out)
+{
+    SDL_LockMutex(lock);
+    auto it = columns.find(key);
+    const bool found = it != columns.end();
+    if (found)
+    {
+        /* Move to the front of the line */
+        lru.splice(lru.begin(), lru, it->second);
+        out = it->second->second;
+        hits++;
+    }
+    else
+        misses++;
+    SDL_UnlockMutex(lock);
+
+    return found;
+}
+
+void climate_cache_t::put(const key_t& key, const climate_column_t& column, const size_t capacity)
+{
+    SDL_LockMutex(lock);
+    auto it = columns.find(key);
+    if (it != columns.end())
+    {
+        lru.splice(lru.begin(), lru, it->second);
+        it->second->second = column;
+    }
+    else if (capacity)
+    {
+        lru.emplace_front(key, column);
+        columns[key] = lru.begin();
+    }
+    evict(capacity);
+    SDL_UnlockMutex(lock);
+}
+
+void climate_cache_t::evict(const size_t capacity)
+{
+    while (lru.size() > capacity)
+    {
+        columns.erase(lru.back().first);
+        lru.pop_back();
+    }
+}
+
+void climate_cache_t::clear()
+{
+    SDL_LockMutex(lock);
+    columns.clear();
+    lru.clear();
+    SDL_UnlockMutex(lock);
+}
+
+size_t climate_cache_t::size()
+{
+    SDL_LockMutex(lock);
+    const size_t ret = lru.size();
+    SDL_UnlockMutex(lock);
+    return ret;
+}
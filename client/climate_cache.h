@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_stdinc.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+/**
+ * Climate values and colors of one chunk column, including the one block border used for blending
+ *
+ * Index: [x + 1][z + 1]
+ */
+struct climate_column_t
+{
+    glm::vec3 colors[18][18];
+    float temperature[18][18];
+    float humidity[18][18];
+};
+
+/**
+ * Bounded least recently used cache of climate columns
+ *
+ * Biome generation for this version only depends on the x and z coordinates, so every chunk in a column shares one entry
+ *
+ * All functions are safe to call from any thread
+ */
+struct climate_cache_t
+{
+    struct key_t
+    {
+        int x = 0;
+        int z = 0;
+        Sint64 seed = 0;
+        int dimension = 0;
+        /** Biome blend setting (r_biome_blend_limit) the column was generated with */
+        int blend = 0;
+
+        inline bool operator==(const key_t& rh) const
+        {
+            return x == rh.x && z == rh.z && seed == rh.seed && dimension == rh.dimension && blend == rh.blend;
+        }
+    };
+
+    climate_cache_t();
+    ~climate_cache_t();
+
+    /**
+     * Copies a column out of the cache
+     *
+     * @param key Column to look for
+     * @param out Output for the column
+     *
+     * @returns true on hit, false on miss
+     */
+    bool get(const key_t& key, climate_column_t& out);
+
+    /**
+     * Inserts (or replaces) a column, evicting the least recently used columns if the cache is over capacity
+     *
+     * @param key Column to insert
+     * @param column Column data
+     * @param capacity Maximum number of columns to keep, 0 disables caching (and empties the cache)
+     */
+    void put(const key_t& key, const climate_column_t& column, const size_t capacity);
+
+    /**
+     * Removes all columns
+     */
+    void clear();
+
+    /** @returns Number of columns in the cache */
+    size_t size();
+
+    /** Lookup counters, not reset by clear() */
+    std::atomic<Uint64> hits = { 0 };
+    std::atomic<Uint64> misses = { 0 };
+
+private:
+    struct key_hash_t
+    {
+        size_t operator()(const key_t& k) const;
+    };
+
+    typedef std::list<std::pair<key_t, climate_column_t>> lru_t;
+
+    void evict(const size_t capacity);
+
+    SDL_Mutex* lock = NULL;
+
+    /** Most recently used first */
+    lru_t lru;
+    std::unordered_map<key_t, lru_t::iterator, key_hash_t> columns;
+};
@@ -23,207 +23,12 @@
 
 #include "connection.h"
 
-#include <zlib.h>
+#include "chunk_decompress.h"
 
-#pragma GCC push_options
-#pragma GCC optimize("O3")
-/**
- * Parse/Decompress a chunk packet and write the changes to the level
- *
- * @param level Level to modify
- * @param p Chunk packet to parse and decompress
- * @param buffer Buffer used for temporarily storing data, the intent is to reduce allocations \n
- *               by allowing the same buffer to be reused over the life of the connection
- */
-static void decompress_chunk_packet(level_t* const level, const packet_chunk_t* const p, std::vector<Uint8>& buffer)
-{
-    if (p->size_x < 0 || p->size_y < 0 || p->size_z < 0)
-    {
-        dc_log_error("Chunk packet with invalid size of <%d, %d, %d>", p->size_x, p->size_y, p->size_z);
-        return;
-    }
-
-    const int min_block_x = p->block_x;
-    const int min_block_y = p->block_y;
-    const int min_block_z = p->block_z;
-    const int max_block_x = min_block_x + p->size_x;
-    const int max_block_y = min_block_y + p->size_y;
-    const int max_block_z = min_block_z + p->size_z;
-
-    const int min_chunk_x = min_block_x >> 4;
-    const int min_chunk_y = min_block_y >> 4;
-    const int min_chunk_z = min_block_z >> 4;
-    const int max_chunk_x = max_block_x >> 4;
-    const int max_chunk_y = max_block_y >> 4;
-    const int max_chunk_z = max_block_z >> 4;
-
-    const int dimension_chunk_x = max_chunk_x - min_chunk_x + 1;
-    const int dimension_chunk_y = max_chunk_y - min_chunk_y + 1;
-    const int dimension_chunk_z = max_chunk_z - min_chunk_z + 1;
-
-    const int real_size_x = p->size_x + 1;
-    const int real_size_y = p->size_y + 1;
-    const int real_size_z = p->size_z + 1;
-    const int real_volume = (real_size_x * real_size_y * real_size_z);
-
-    /* Oversize the buffer a small amount in case weirdness occurs  */
-    long unsigned int uncompressed_size = real_size_x * real_size_y * real_size_z * 41 / 16;
-    if (uncompressed_size > buffer.size())
-    {
-        dc_log("Resizing decompression buffer to %zu", uncompressed_size);
-        buffer.resize(uncompressed_size, 0);
-    }
-    Uint8* uncompressed = buffer.data();
-    memset(uncompressed + uncompressed_size, 0, buffer.size() - uncompressed_size);
-
-    int decompress_result = uncompress(uncompressed, &uncompressed_size, p->compressed_data.data(), p->compressed_data.size());
-
-    TRACE("%d %d %d | %d %d %d", min_chunk_x, min_chunk_y, min_chunk_z, max_chunk_x, max_chunk_y, max_chunk_z);
-
-    if (decompress_result != Z_OK)
-    {
-        const char* err_str = "Unknown error";
-        switch (decompress_result)
-        {
-            ENUM_SWITCH_CASE(err_str, Z_OK);
-            ENUM_SWITCH_CASE(err_str, Z_STREAM_END);
-            ENUM_SWITCH_CASE(err_str, Z_NEED_DICT);
-            ENUM_SWITCH_CASE(err_str, Z_ERRNO);
-            ENUM_SWITCH_CASE(err_str, Z_STREAM_ERROR);
-            ENUM_SWITCH_CASE(err_str, Z_DATA_ERROR);
-            ENUM_SWITCH_CASE(err_str, Z_MEM_ERROR);
-            ENUM_SWITCH_CASE(err_str, Z_BUF_ERROR);
-            ENUM_SWITCH_CASE(err_str, Z_VERSION_ERROR);
-        default:
-            break;
-        }
-        dc_log_error("Error %d (%s) decompressing chunk data!", decompress_result, err_str);
-    }
-
-    auto map = level->get_chunk_map();
-
-    /* Copy data */
-    const int cvol_it_size = dimension_chunk_x * dimension_chunk_y;
-    for (int cvol_it = 0, cvol_it_x = 0, cvol_it_y = 0, cvol_it_z = 0; cvol_it < cvol_it_size; cvol_it++)
-    {
-        const int chunk_x = cvol_it_x + min_chunk_x;
-        const int chunk_y = cvol_it_y + min_chunk_y;
-        const int chunk_z = cvol_it_z + min_chunk_z;
-
-        SDL_assert(BETWEEN_INCL(chunk_x, min_chunk_x, max_chunk_x));
-        SDL_assert(BETWEEN_INCL(chunk_y, min_chunk_y, max_chunk_y));
-        SDL_assert(BETWEEN_INCL(chunk_z, min_chunk_z, max_chunk_z));
-
-        cvol_it_x++;
-        if (cvol_it_x >= dimension_chunk_x)
-        {
-            cvol_it_x = 0;
-            cvol_it_y++;
-        }
-        if (cvol_it_y >= dimension_chunk_y)
-        {
-            cvol_it_y = 0;
-            cvol_it_z++;
-        }
-        SDL_assert(cvol_it_x < dimension_chunk_x);
-        SDL_assert(cvol_it_y < dimension_chunk_y);
-        SDL_assert(cvol_it_z < dimension_chunk_z || cvol_it + 1 == cvol_it_size);
-
-        /* Find chunk or create new a one */
-        chunk_cubic_t* c = NULL;
-        {
-            const glm::ivec3 cpos(chunk_x, chunk_y, chunk_z);
-            auto it = map->find(cpos);
-            if (it == map->end())
-            {
-                c = new chunk_cubic_t();
-                c->pos = cpos;
-                level->add_chunk(c);
-            }
-            else
-                c = it->second;
-
-            if (!c)
-            {
-                dc_log_error("Chunk is null at <%d, %d, %d>", cpos.x, cpos.y, cpos.z);
-                continue;
-            }
-        }
-
-        for (int x = 0; x < SUBCHUNK_SIZE_X; x++)
-        {
-            const int block_x = x + ((c->pos.x) << 4);
-            if (!BETWEEN_INCL(block_x, min_block_x, max_block_x))
-                continue;
-            const int uncompressed_x = block_x - min_block_x;
-
-            for (int z = 0; z < SUBCHUNK_SIZE_Z; z++)
-            {
-                const int block_z = z + ((c->pos.z) << 4);
-                if (!BETWEEN_INCL(block_z, min_block_z, max_block_z))
-                    continue;
-                const int uncompressed_z = block_z - min_block_z;
-
-                for (int y = 0; y < SUBCHUNK_SIZE_Y; y++)
-                {
-                    const int block_y = y + ((c->pos.y) << 4);
-                    if (!BETWEEN_INCL(block_y, min_block_y, max_block_y))
-                        continue;
-                    const int uncompressed_y = block_y - min_block_y;
-
-                    size_t index = uncompressed_y + (uncompressed_z * (real_size_y)) + (uncompressed_x * (real_size_y) * (real_size_z));
-                    Uint8 type = uncompressed[index];
-
-                    index += real_volume * 2;
-                    Uint8 meta;
-                    if (index % 2 == 1)
-                        meta = (uncompressed[index / 2] >> 4) & 0x0F;
-                    else
-                        meta = uncompressed[index / 2] & 0x0F;
-
-                    index += real_volume;
-                    Uint8 light_block;
-                    if (index % 2 == 1)
-                        light_block = (uncompressed[index / 2] >> 4) & 0x0F;
-                    else
-                        light_block = uncompressed[index / 2] & 0x0F;
-
-                    index += real_volume;
-                    Uint8 light_sky;
-                    if (index % 2 == 1)
-                        light_sky = (uncompressed[index / 2] >> 4) & 0x0F;
-                    else
-                        light_sky = uncompressed[index / 2] & 0x0F;
-
-                    c->set_type(x, y, z, type);
-                    c->set_metadata(x, y, z, meta);
-                    c->set_light_block(x, y, z, light_block);
-                    c->set_light_sky(x, y, z, light_sky);
-                }
-            }
-        }
-
-        c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
-    }
+#include "tetra/util/convar.h"
 
-    /* Mark surrounding chunks for re-meshing */
-    for (int x = min_chunk_x - 1; x <= max_chunk_x + 1; x++)
-    {
-        for (int y = min_chunk_y - 1; y <= max_chunk_y + 1; y++)
-        {
-            for (int z = min_chunk_z - 1; z <= max_chunk_z + 1; z++)
-            {
-                if (BETWEEN_INCL(x, min_chunk_x, max_chunk_x) && BETWEEN_INCL(y, min_chunk_y, max_chunk_y) && BETWEEN_INCL(z, min_chunk_z, max_chunk_z))
-                    continue;
-
-                auto it = map->find(glm::ivec3(x, y, z));
-                if (it != map->end() && it->second->dirty_level < chunk_cubic_t::DIRTY_LEVEL_MESH)
-                    it->second->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
-            }
-        }
-    }
-}
-#pragma GCC pop_options
+static convar_int_t cvr_net_chunk_decompress_thread("net_chunk_decompress_thread", 1, 0, 1, "Decompress chunk packets on a background thread",
+    CONVAR_FLAG_SAVE | CONVAR_FLAG_INT_IS_BOOL);
 
 void connection_t::handle_inactive()
 {
@@ -363,6 +168,8 @@ void connection_t::run(level_t* const level)
             {
                 CAST_PACK_TO_P(packet_login_request_s2c_t);
 
+                apply_decoded_chunks(level, true);
+
                 const level_t::dimension_switch_result switch_result = level->dimension_switch(p->dimension);
 
                 switch (switch_result)
@@ -467,6 +274,8 @@ void connection_t::run(level_t* const level)
             {
                 CAST_PACK_TO_P(packet_respawn_t);
 
+                apply_decoded_chunks(level, true);
+
                 const level_t::dimension_switch_result switch_result = level->dimension_switch(p->dimension);
 
                 switch (switch_result)
@@ -578,6 +387,8 @@ void connection_t::run(level_t* const level)
             {
                 CAST_PACK_TO_P(packet_chunk_cache_t);
 
+                apply_decoded_chunks(level, true);
+
                 const int max_cy = (level->world_height + SUBCHUNK_SIZE_Y - 1) / SUBCHUNK_SIZE_Y;
 
                 if (!p->mode)
@@ -587,11 +398,9 @@ void connection_t::run(level_t* const level)
                 }
                 else
                 {
-                    decltype(level->get_chunk_map()) cmap = level->get_chunk_map();
-
                     for (int i = 0; i < max_cy; i++)
                     {
-                        if (cmap->find(glm::ivec3(p->chunk_x, i, p->chunk_z)) == cmap->end())
+                        if (!level->get_chunk(glm::ivec3(p->chunk_x, i, p->chunk_z)))
                             continue;
                         chunk_cubic_t* c = new chunk_cubic_t();
                         c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_NONE;
@@ -607,6 +416,8 @@ void connection_t::run(level_t* const level)
             {
                 CAST_PACK_TO_P(packet_block_change_t);
 
+                apply_decoded_chunks(level, true);
+
                 glm::ivec3 block_pos = { p->block_x, p->block_y, p->block_z };
                 level->set_block(block_pos, p->type, p->metadata);
 
@@ -625,6 +436,8 @@ void connection_t::run(level_t* const level)
             {
                 CAST_PACK_TO_P(packet_block_change_multi_t);
 
+                apply_decoded_chunks(level, true);
+
                 for (block_change_dat_t b : p->payload)
                 {
                     glm::ivec3 block_pos = { p->chunk_x * CHUNK_SIZE_X + b.x, b.y, p->chunk_z * CHUNK_SIZE_Z + b.z };
@@ -643,22 +456,20 @@ void connection_t::run(level_t* const level)
             case PACKET_ID_CHUNK_MAP:
             {
                 CAST_PACK_TO_P(packet_chunk_t);
-                decompress_chunk_packet(level, p, chunk_decompression_buffer);
 
-                /* Mark as fulfilled to delay erasing until after packet handling is finished */
-                for (tentative_block_t& it : tentative_blocks)
+                if (!cvr_net_chunk_decompress_thread.get())
                 {
-                    if (it.fulfilled)
-                        continue;
-                    if (!BETWEEN_INCL(it.pos.x, p->block_x, p->block_x + p->size_x))
-                        continue;
-                    if (!BETWEEN_INCL(it.pos.y, p->block_y, p->block_y + p->size_y))
-                        continue;
-                    if (!BETWEEN_INCL(it.pos.z, p->block_z, p->block_z + p->size_z))
-                        continue;
-                    it.fulfilled = 1;
+                    apply_decoded_chunks(level, true);
+
+                    decoded_chunk_packet_t decoded;
+                    decode_chunk_packet(p, chunk_decompression_buffer, decoded);
+                    apply_decoded_chunk(level, decoded);
+                    break;
                 }
 
+                /* The packet handler frees the packet after this, so the worker gets its own copy (without copying the compressed data) */
+                chunk_worker.submit(new packet_chunk_t(std::move(*p)));
+
                 break;
             }
 
@@ -1034,6 +845,8 @@ void connection_t::run(level_t* const level)
             pack_handler_client.free_packet(pack_from_server);
         }
 
+        apply_decoded_chunks(level, false);
+
         if (in_world)
         {
             if (SDL_GetTicks() - last_update_tick_camera > 50)
@@ -1055,6 +868,16 @@ void connection_t::run(level_t* const level)
 
     /* Remove tentative blocks if they have been fulfilled or their timeout has expired */
     const Uint64 time_tentative = SDL_GetTicks();
+
+    /* A chunk packet still being decoded may fulfill an expired block, so it has to be applied before anything is reverted */
+    for (const tentative_block_t& it : tentative_blocks)
+    {
+        if (it.fulfilled || time_tentative - it.timestamp < 5000)
+            continue;
+        apply_decoded_chunks(level, true);
+        break;
+    }
+
     for (std::vector<tentative_block_t>::iterator it = tentative_blocks.begin(); it != tentative_blocks.end();)
     {
         if (time_tentative - it->timestamp < 5000)
@@ -1071,6 +894,51 @@ void connection_t::run(level_t* const level)
         loading_button = LOADING_BUTTON_BACK_TO_MENU;
 }
 
+void connection_t::apply_decoded_chunk(level_t* const level, decoded_chunk_packet_t& decoded)
+{
+    apply_decoded_chunk_packet(decoded, [&](const glm::ivec3 cpos, const bool create) -> chunk_cubic_t* {
+        chunk_cubic_t* existing = level->get_chunk(cpos);
+        /* Chunks written to need their renderer hints refreshed */
+        if (existing && create)
+            level->mark_dirty(existing, chunk_cubic_t::DIRTY_LEVEL_NONE);
+        if (existing)
+            return existing;
+        if (!create)
+            return NULL;
+
+        chunk_cubic_t* c = new chunk_cubic_t();
+        c->pos = cpos;
+        level->add_chunk(c);
+        return c;
+    });
+
+    /* Mark as fulfilled to delay erasing until after packet handling is finished */
+    for (tentative_block_t& it : tentative_blocks)
+    {
+        if (it.fulfilled)
+            continue;
+        if (!BETWEEN_INCL(it.pos.x, decoded.block_min.x, decoded.block_max.x))
+            continue;
+        if (!BETWEEN_INCL(it.pos.y, decoded.block_min.y, decoded.block_max.y))
+            continue;
+        if (!BETWEEN_INCL(it.pos.z, decoded.block_min.z, decoded.block_max.z))
+            continue;
+        it.fulfilled = 1;
+    }
+}
+
+void connection_t::apply_decoded_chunks(level_t* const level, const bool wait)
+{
+    if (!chunk_worker.get_in_flight())
+        return;
+
+    std::vector<decoded_chunk_packet_t> decoded;
+    chunk_worker.collect(decoded, wait);
+
+    for (decoded_chunk_packet_t& it : decoded)
+        apply_decoded_chunk(level, it);
+}
+
 void connection_t::set_status_msg(const std::string& _status, const std::string& _sub_status)
 {
     status_msg = _status;
@@ -23,6 +23,7 @@
 #ifndef MCS_B181_CLIENT_CONNECTION_H
 #define MCS_B181_CLIENT_CONNECTION_H
 
+#include "chunk_decompress.h"
 #include "level.h"
 
 #include "shared/packet.h"
@@ -216,6 +217,26 @@ private:
 
     std::vector<Uint8> chunk_decompression_buffer;
 
+    /**
+     * Decodes chunk packets off of the main thread, results are applied by apply_decoded_chunks()
+     */
+    chunk_decompress_worker_t chunk_worker;
+
+    /**
+     * Write a decoded chunk packet to the level and mark any tentative blocks inside of it as fulfilled
+     */
+    void apply_decoded_chunk(level_t* const level, decoded_chunk_packet_t& decoded);
+
+    /**
+     * Write decoded chunk packets to the level (in the order they were received)
+     *
+     * NOTE: This must be called with wait=true before handling any packet that reads or modifies chunks, to preserve packet order
+     *
+     * @param level Level to write the chunks to
+     * @param wait Block until all in flight chunk packets have been decoded
+     */
+    void apply_decoded_chunks(level_t* const level, const bool wait);
+
     /**
      * Stores blocks that the client placed/destroyed that the server will hopefully honor,
      */
@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "frame_budget.h"
+
+/** Weight of new measurements, low enough that a single slow frame does not throw the estimates off */
+#define COST_SMOOTHING 0.25
+
+void frame_budget_t::begin_frame(const Uint64 _budget_ns)
+{
+    budget_ns = _budget_ns;
+    spent_ns = 0;
+}
+
+Uint64 frame_budget_t::get_remaining() const
+{
+    if (!is_limited())
+        return SDL_MAX_UINT64;
+    return (spent_ns < budget_ns) ? budget_ns - spent_ns : 0;
+}
+
+size_t frame_budget_t::fit(const cost_t& cost, const size_t min_items, const Uint64 reserve_ns) const
+{
+    if (!is_limited())
+        return SIZE_MAX;
+
+    const Uint64 remaining = get_remaining();
+    const double items = double(remaining > reserve_ns ? remaining - reserve_ns : 0) / SDL_max(cost.ns_per_item, 1.0);
+    if (items < double(min_items))
+        return min_items;
+
+    return size_t(SDL_min(items, double(SDL_MAX_SINT32)));
+}
+
+void frame_budget_t::spend(cost_t& cost, const Uint64 elapsed_ns, const size_t items)
+{
+    spent_ns += elapsed_ns;
+
+    if (!items)
+        return;
+
+    const double ns_per_item = double(elapsed_ns) / double(items);
+    cost.ns_per_item += (ns_per_item - cost.ns_per_item) * COST_SMOOTHING;
+}
@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <SDL3/SDL.h>
+
+/**
+ * Per-frame time budget for work that can be carried over to later frames (Lighting, meshing, and mesh uploads)
+ *
+ * The cost of each kind of work is predicted from how long it took in previous frames
+ */
+struct frame_budget_t
+{
+    /**
+     * Running estimate of what a single item of one kind of work costs
+     */
+    struct cost_t
+    {
+        /** Exponential moving average of the time per item (Nanoseconds) */
+        double ns_per_item = 0.0;
+
+        /**
+         * @param initial_ns_per_item Estimate to use until the first measurement comes in
+         */
+        cost_t(const double initial_ns_per_item) { ns_per_item = initial_ns_per_item; }
+    };
+
+    /**
+     * Start a new frame
+     *
+     * @param _budget_ns Time available for this frame (Nanoseconds), 0 for unlimited
+     */
+    void begin_frame(const Uint64 _budget_ns);
+
+    /**
+     * Returns true if this frame has a limited budget
+     */
+    inline bool is_limited() const { return budget_ns != 0; }
+
+    /**
+     * Returns the time left in this frame (Nanoseconds)
+     */
+    Uint64 get_remaining() const;
+
+    /**
+     * Returns the number of items predicted to fit in the remaining budget (SIZE_MAX if the budget is unlimited)
+     *
+     * NOTE: At least min_items is always returned so that work cannot stall, even when one item costs more than the whole budget
+     *
+     * @param cost Estimate of the work
+     * @param min_items Minimum number of items to return
+     * @param reserve_ns Time to leave for work done later in the frame (Nanoseconds)
+     */
+    size_t fit(const cost_t& cost, const size_t min_items = 1, const Uint64 reserve_ns = 0) const;
+
+    /**
+     * Deducts time spent from the budget, and folds the measurement into the cost estimate
+     *
+     * @param cost Estimate to update
+     * @param elapsed_ns Time spent (Nanoseconds)
+     * @param items Number of items processed in that time
+     */
+    void spend(cost_t& cost, const Uint64 elapsed_ns, const size_t items);
+
+    Uint64 budget_ns = 0;
+    Uint64 spent_ns = 0;
+};
@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "frustum.h"
+
+#include <SDL3/SDL.h>
+
+frustum_t::frustum_t(const glm::mat4& m)
+{
+    /* GLM matrices are column major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i]) */
+    const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    /* -w <= x <= w, -w <= y <= w, 0 <= z <= w */
+    planes[PLANE_LEFT] = row3 + row0;
+    planes[PLANE_RIGHT] = row3 - row0;
+    planes[PLANE_BOTTOM] = row3 + row1;
+    planes[PLANE_TOP] = row3 - row1;
+    planes[PLANE_NEAR] = row2;
+    planes[PLANE_FAR] = row3 - row2;
+
+    for (glm::vec4& p : planes)
+    {
+        const float len = SDL_sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+        if (len > 0.0f)
+            p /= len;
+    }
+}
+
+bool frustum_t::test_aabb(const glm::vec3 min, const glm::vec3 max) const
+{
+    for (const glm::vec4& p : planes)
+    {
+        /* Corner of the box furthest along the plane normal */
+        const glm::vec3 corner(p.x >= 0.0f ? max.x : min.x, p.y >= 0.0f ? max.y : min.y, p.z >= 0.0f ? max.z : min.z);
+
+        if (p.x * corner.x + p.y * corner.y + p.z * corner.z + p.w < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+void frustum_t::test_cubes(const float* const x, const float* const y, const float* const z, const float size, const size_t count, Uint8* const out) const
+{
+    /* For a cube the furthest corner along a normal is always the minimum corner plus a constant offset, so it can be folded into the distance */
+    float dist[PLANE_COUNT];
+    for (int i = 0; i < PLANE_COUNT; i++)
+    {
+        const glm::vec4& p = planes[i];
+        dist[i] = p.w + size * (SDL_max(p.x, 0.0f) + SDL_max(p.y, 0.0f) + SDL_max(p.z, 0.0f));
+    }
+
+    size_t it = 0;
+
+#ifdef SDL_SSE2_INTRINSICS
+    __m128 nx[PLANE_COUNT], ny[PLANE_COUNT], nz[PLANE_COUNT], nw[PLANE_COUNT];
+    for (int i = 0; i < PLANE_COUNT; i++)
+    {
+        nx[i] = _mm_set1_ps(planes[i].x);
+        ny[i] = _mm_set1_ps(planes[i].y);
+        nz[i] = _mm_set1_ps(planes[i].z);
+        nw[i] = _mm_set1_ps(dist[i]);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    for (; it + 4 <= count; it += 4)
+    {
+        const __m128 px = _mm_loadu_ps(x + it);
+        const __m128 py = _mm_loadu_ps(y + it);
+        const __m128 pz = _mm_loadu_ps(z + it);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int i = 0; i < PLANE_COUNT; i++)
+        {
+            const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[i], px), _mm_mul_ps(ny[i], py)), _mm_add_ps(_mm_mul_ps(nz[i], pz), nw[i]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+        out[it + 0] = (mask >> 0) & 1;
+        out[it + 1] = (mask >> 1) & 1;
+        out[it + 2] = (mask >> 2) & 1;
+        out[it + 3] = (mask >> 3) & 1;
+    }
+#endif
+
+    for (; it < count; it++)
+    {
+        bool inside = 1;
+        for (int i = 0; i < PLANE_COUNT; i++)
+            inside &= (planes[i].x * x[it] + planes[i].y * y[it]) + (planes[i].z * z[it] + dist[i]) >= 0.0f;
+        out[it] = inside;
+    }
+}
@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <glm/glm.hpp>
+
+/**
+ * View frustum made of six planes, extracted from a (projection * view) matrix with the Gribb/Hartmann method
+ *
+ * Expects clip space depth to be in the range [0, w] (See: GLM_FORCE_DEPTH_ZERO_TO_ONE), reversed depth is fine
+ */
+struct frustum_t
+{
+    enum plane_t
+    {
+        PLANE_LEFT,
+        PLANE_RIGHT,
+        PLANE_BOTTOM,
+        PLANE_TOP,
+        /** With reversed depth this is the far plane */
+        PLANE_NEAR,
+        /** With reversed depth this is the near plane */
+        PLANE_FAR,
+        PLANE_COUNT,
+    };
+
+    /**
+     * xyz: Normal (pointing inwards, normalized), w: Distance
+     *
+     * A point p is on the inner side of a plane when dot(plane.xyz, p) + plane.w >= 0
+     */
+    glm::vec4 planes[PLANE_COUNT];
+
+    frustum_t() { }
+
+    /**
+     * @param mat_proj_view Projection matrix multiplied by view matrix
+     */
+    frustum_t(const glm::mat4& mat_proj_view);
+
+    /**
+     * Reference test for an axis aligned bounding box
+     *
+     * @returns false if the box is entirely outside of at least one plane, true otherwise
+     */
+    bool test_aabb(const glm::vec3 min, const glm::vec3 max) const;
+
+    /**
+     * Test a batch of equally sized cubes (Equivalent to test_aabb(min, min + size) for each cube)
+     *
+     * Uses SSE2 to test 4 cubes at a time when available
+     *
+     * @param x X coordinates of the minimum corners of the cubes
+     * @param y Y coordinates of the minimum corners of the cubes
+     * @param z Z coordinates of the minimum corners of the cubes
+     * @param size Side length of the cubes
+     * @param count Number of cubes
+     * @param out Output, 1 if the corresponding cube may be visible, 0 otherwise
+     */
+    void test_cubes(const float* const x, const float* const y, const float* const z, const float size, const size_t count, Uint8* const out) const;
+};
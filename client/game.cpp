@@ -25,6 +25,7 @@
 
 #include "connection.h"
 #include "level.h"
+#include "light_test_worlds.h"
 #include "sound/sound_resources.h"
 #include "texture_terrain.h"
 
@@ -275,94 +276,13 @@ void game_t::create_testworld()
 void game_t::create_light_test_decorated_simplex(const glm::ivec3 world_size)
 {
     level->clear();
-    const int world_volume = world_size.x * world_size.y * world_size.z;
-
-    std::vector<chunk_cubic_t*> chunks;
-    chunks.resize(world_volume);
-    std::atomic<size_t> off = 0;
-    std::atomic<Uint64> elapsed_ns = 0;
-
-    util::parallel_for(0, world_size.x * world_size.z, [&](const int _start, const int _end) {
-        Uint64 start_tick = SDL_GetTicksNS();
-        chunk_t c_old;
-        for (int it = _start; it < _end; it++)
-        {
-            /* Nothing special about this seed */
-            Uint64 r_state_chunk = 0x2e17d7f27f825d7f + (it << 10);
-
-            int cx = it % world_size.x;
-            int cz = it / world_size.x;
-
-            /* Nothing special about this seed */
-            /* Coordinates fed to the generator are offset to coincide with the dev chunks */
-            c_old.generate_from_seed_over(0xc4891e8c5ee07c5d, cx - world_size.x / 2, cz - world_size.z / 2);
-            for (int cy = 0; cy < world_size.y; cy++)
-            {
-                chunk_cubic_t* c = new chunk_cubic_t();
-                c->pos = glm::ivec3 { cx, cy, cz };
-                for (int x = 0; x < 16; x++)
-                    for (int z = 0; z < 16; z++)
-                        for (int y = 0; y < 16; y++)
-                        {
-                            c->set_type(x, y, z, c_old.get_type(x, y + (cy % 8) * 16, z));
-                            c->set_metadata(x, y, z, c_old.get_metadata(x, y + (cy % 8) * 16, z));
-                            c->set_light_block(x, y, z, c_old.get_light_block(x, y + (cy % 8) * 16, z));
-                            c->set_light_sky(x, y, z, c_old.get_light_sky(x, y + (cy % 8) * 16, z));
-                        }
-
-                for (int decoration_it = 0; decoration_it < 20; decoration_it++)
-                {
-                    Uint32 rand_data = SDL_rand_bits_r(&r_state_chunk);
-                    const int y = (rand_data) & 0x0F;
-                    const int z = (rand_data >> 4) & 0x0F;
-                    const int x = (rand_data >> 8) & 0x0F;
-                    rand_data = SDL_rand_bits_r(&r_state_chunk);
-                    c->set_type(x, y, z, rand_data % BLOCK_ID_NUM_USED);
-                }
-
-                chunks[off++] = c;
-            }
-        }
-        elapsed_ns += SDL_GetTicksNS() - start_tick;
-    });
-
-    assert(size_t(off) == chunks.size());
-
-    for (chunk_cubic_t* c : chunks)
+    for (chunk_cubic_t* c : ::create_light_test_decorated_simplex(world_size))
         level->add_chunk(c);
-
-    double elapsed_ms = double(elapsed_ns) / 1000.0 / 1000.0;
-    dc_log("Construction time: %.2f ms (%.3f ms per)", elapsed_ms, elapsed_ms / double(world_volume));
 }
 
 void game_t::create_light_test_sdl_rand(const glm::ivec3 world_size, Uint64* r_state)
 {
     level->clear();
-    const int world_volume = world_size.x * world_size.y * world_size.z;
-
-    /* Nothing special about this seed */
-    Uint64 r_state_if_null = 0x8c5ee07d7f257c5d;
-    if (!r_state)
-        r_state = &r_state_if_null;
-
-    Uint64 tstart = SDL_GetTicksNS();
-    for (int cx = 0; cx < world_size.x; cx++)
-        for (int cz = 0; cz < world_size.z; cz++)
-            for (int cy = 0; cy < world_size.y; cy++)
-            {
-                chunk_cubic_t* c = new chunk_cubic_t();
-                c->pos = glm::ivec3 { cx, cy, cz };
-                for (int pos_it = 0; pos_it < SUBCHUNK_SIZE_VOLUME; pos_it++)
-                {
-                    const int y = (pos_it) & 0x0F;
-                    const int z = (pos_it >> 4) & 0x0F;
-                    const int x = (pos_it >> 8) & 0x0F;
-                    Uint32 rand_data = SDL_rand_bits_r(r_state);
-                    if (rand_data % (rand_data % 15 + 1) < 5)
-                        c->set_type(x, y, z, rand_data % BLOCK_ID_NUM_USED);
-                }
-                level->add_chunk(c);
-            }
-    double elapsed_ms = double(SDL_GetTicksNS() - tstart) / 1000.0 / 1000.0;
-    dc_log("Construction time: %.2f ms (%.3f ms per)", elapsed_ms, elapsed_ms / double(world_volume));
+    for (chunk_cubic_t* c : ::create_light_test_sdl_rand(world_size, r_state))
+        level->add_chunk(c);
 }
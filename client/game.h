@@ -52,6 +52,12 @@ struct game_resources_t
      */
     [[nodiscard]] SDL_GPUFence* reload();
 
+    /**
+     * Free game resources
+     *
+     * NOTE: Every game using these resources must be detached first (See: game_t::reload_resources()),
+     * otherwise mesh workers may still be reading the terrain atlas
+     */
     void destroy();
 
     ~game_resources_t();
@@ -98,8 +98,8 @@ void do_debug_screen(mc_gui::mc_gui_ctx* ctx, game_t* game, ImDrawList* drawlist
         }
         mem_chunk = num_total * sizeof(chunk_cubic_t);
 
-        add_text(ctx, drawlist, 0, cursor_l, "C: %zu/%zu, M: %zu, D: %zu/%zu, Q: %zu", num_visible, num_total, num_meshed, num_dirty_visible, num_dirty,
-            game->level->get_mesh_queue_size());
+        add_text(ctx, drawlist, 0, cursor_l, "C: %zu/%zu, M: %zu, D: %zu/%zu, Q: %zu, J: %d", num_visible, num_total, num_meshed, num_dirty_visible, num_dirty,
+            game->level->get_mesh_queue_size(), game->level->get_mesh_jobs_in_flight());
     }
 
     /* Entity stats */
@@ -322,7 +322,7 @@ void do_debug_screen(mc_gui::mc_gui_ctx* ctx, game_t* game, ImDrawList* drawlist
 
         frametime_avg /= double(IM_ARRAYSIZE(frametimes));
 
-        static convar_int_t* r_fps_limiter = (convar_int_t*)convar_t::get_convar("r_fps_limiter");
+        static convar_int_t* r_fps_limiter = convar_t::get_convar_int("r_fps_limiter");
         assert(r_fps_limiter);
 
         double target = frametime_avg;
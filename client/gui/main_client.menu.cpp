@@ -1330,8 +1330,8 @@ static client_menu_return_t do_menu_options(mc_gui::mc_gui_ctx* ctx)
 
 static void cvr_button_multi(mc_gui::widget_size_t size, const char* cvr_name, const char* translation_id, std::vector<std::pair<int, const char*>>& id_alts)
 {
-    convar_int_t* cvr = (convar_int_t*)convar_t::get_convar(cvr_name);
-    assert(cvr->get_convar_type() == convar_t::CONVAR_TYPE::CONVAR_TYPE_INT);
+    convar_int_t* cvr = convar_t::get_convar_int(cvr_name);
+    assert(cvr);
     std::string buf = mc_gui::get_translation(translation_id);
     buf += ": ";
 
@@ -1432,7 +1432,7 @@ static client_menu_return_t do_menu_options_video(mc_gui::mc_gui_ctx* ctx)
     ImGui::Begin("menu.options.video", NULL, ctx->default_win_flags);
 
     {
-        static convar_int_t* cvr = (convar_int_t*)convar_t::get_convar("r_render_distance");
+        static convar_int_t* cvr = convar_t::get_convar_int("r_render_distance");
         int cvr_val = cvr->get();
         std::string buf = mc_gui::get_translation("options.renderDistance");
         buf += ": %d";
@@ -1484,15 +1484,15 @@ static client_menu_return_t do_menu_options_sound(mc_gui::mc_gui_ctx* ctx)
     ImGui::SetNextWindowPos(get_viewport_centered_title_bar(), ImGuiCond_Always, ImVec2(0.5, 0.0));
     ImGui::Begin("menu.options.sound", NULL, ctx->default_win_flags);
 
-    static convar_int_t* cvr_a_volume_master = (convar_int_t*)convar_t::get_convar("a_volume_master");
-    static convar_int_t* cvr_a_volume_music = (convar_int_t*)convar_t::get_convar("a_volume_music");
-    static convar_int_t* cvr_a_volume_weather = (convar_int_t*)convar_t::get_convar("a_volume_weather");
-    static convar_int_t* cvr_a_volume_hostile = (convar_int_t*)convar_t::get_convar("a_volume_hostile");
-    static convar_int_t* cvr_a_volume_player = (convar_int_t*)convar_t::get_convar("a_volume_player");
-    static convar_int_t* cvr_a_volume_record = (convar_int_t*)convar_t::get_convar("a_volume_record");
-    static convar_int_t* cvr_a_volume_blocks = (convar_int_t*)convar_t::get_convar("a_volume_blocks");
-    static convar_int_t* cvr_a_volume_neutral = (convar_int_t*)convar_t::get_convar("a_volume_neutral");
-    static convar_int_t* cvr_a_volume_ambient = (convar_int_t*)convar_t::get_convar("a_volume_ambient");
+    static convar_int_t* cvr_a_volume_master = convar_t::get_convar_int("a_volume_master");
+    static convar_int_t* cvr_a_volume_music = convar_t::get_convar_int("a_volume_music");
+    static convar_int_t* cvr_a_volume_weather = convar_t::get_convar_int("a_volume_weather");
+    static convar_int_t* cvr_a_volume_hostile = convar_t::get_convar_int("a_volume_hostile");
+    static convar_int_t* cvr_a_volume_player = convar_t::get_convar_int("a_volume_player");
+    static convar_int_t* cvr_a_volume_record = convar_t::get_convar_int("a_volume_record");
+    static convar_int_t* cvr_a_volume_blocks = convar_t::get_convar_int("a_volume_blocks");
+    static convar_int_t* cvr_a_volume_neutral = convar_t::get_convar_int("a_volume_neutral");
+    static convar_int_t* cvr_a_volume_ambient = convar_t::get_convar_int("a_volume_ambient");
 
     im_cvr_slider(ctx, cvr_a_volume_master, "soundCategory.master", -1);
 
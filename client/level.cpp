@@ -53,8 +53,57 @@
             dc_log(fmt, ##__VA_ARGS__);          \
     } while (0)
 
-static convar_int_t r_mesh_throttle("r_mesh_throttle", 1, 1, 64, "Maximum number of chunks that can be meshed per frame", CONVAR_FLAG_SAVE);
+static convar_int_t r_mesh_throttle(
+    "r_mesh_throttle", 1, 1, 64, "Maximum number of chunks that can be meshed per frame (Only used if r_chunk_budget_ms is 0)", CONVAR_FLAG_SAVE);
+static convar_float_t r_chunk_budget_ms {
+    "r_chunk_budget_ms",
+    4.0f,
+    0.0f,
+    100.0f,
+    "Time per frame to spend lighting, meshing, and uploading chunks, anything that does not fit is carried over (0: Unlimited light, r_mesh_throttle)",
+    CONVAR_FLAG_SAVE,
+};
+static convar_int_t r_cave_culling {
+    "r_cave_culling",
+    1,
+    0,
+    1,
+    "Cull chunks that cannot be seen from the camera chunk through transparent blocks (See: level_t::cave_cull())",
+    CONVAR_FLAG_SAVE | CONVAR_FLAG_INT_IS_BOOL,
+};
+static convar_int_t r_render_order_exact {
+    "r_render_order_exact",
+    0,
+    0,
+    1,
+    "Sort visible chunks at the same chunk distance by their exact distance to the camera (See: level_t::refine_render_order())",
+    CONVAR_FLAG_SAVE | CONVAR_FLAG_INT_IS_BOOL,
+};
+static convar_int_t dev_verify_dirty_list {
+    "dev_verify_dirty_list",
+    0,
+    0,
+    1,
+    "Check every chunk for changes that were not added to the dirty list (See: level_t::mark_dirty())",
+    CONVAR_FLAG_INT_IS_BOOL | CONVAR_FLAG_DEV_ONLY,
+};
 static convar_int_t r_render_distance("r_render_distance", 8, 1, 64, "Maximum chunk distance that can be viewed at once", CONVAR_FLAG_SAVE);
+static convar_int_t r_light_threads {
+    "r_light_threads",
+    -1,
+    -1,
+    64,
+    "Number of threads to propagate light on (-1: All but one logical core, 0: Main thread only)",
+    CONVAR_FLAG_SAVE,
+};
+static convar_int_t r_mesh_threads {
+    "r_mesh_threads",
+    -1,
+    -1,
+    32,
+    "Number of threads to build meshes on (-1: Half of the logical cores, 0: Build meshes on the main thread)",
+    CONVAR_FLAG_SAVE,
+};
 
 void level_t::clear_mesh(const bool free_gpu)
 {
@@ -62,12 +111,10 @@ void level_t::clear_mesh(const bool free_gpu)
     {
         if (free_gpu)
             c->free_renderer_resources(chunk_cubic_t::DIRTY_LEVEL_MESH);
-        if (c->dirty_level < chunk_cubic_t::DIRTY_LEVEL_MESH)
-            c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
+        mark_dirty(c, chunk_cubic_t::DIRTY_LEVEL_MESH);
     }
 }
 
-/* Ideally this would use the Gribb/Hartmann method to extract the planes from a projection/camera matrix to get the plane normals */
 void level_t::cull_chunks(const glm::ivec2 win_size, const int render_distance)
 {
     auto timer_scoped = timer_cull_chunks.start_scoped();
@@ -77,57 +124,224 @@ void level_t::cull_chunks(const glm::ivec2 win_size, const int render_distance)
     camera_direction.z = SDL_sinf(glm::radians(yaw)) * SDL_cosf(glm::radians(pitch));
     camera_direction = glm::normalize(camera_direction);
 
-    const float half_v = tanf(glm::radians(fov) * .5f);
-    const float half_h = half_v * float(win_size.x) / float(win_size.y);
-    const glm::vec3 cam_right = glm::normalize(glm::cross(glm::vec3(0.0f, -1.0f, 0.0f), camera_direction));
-    const glm::vec3 cam_up = glm::normalize(glm::cross(camera_direction, cam_right));
+    const glm::vec3 camera_pos = get_camera_pos();
+    const glm::ivec3 camera_chunk_pos = glm::ivec3(glm::floor(camera_pos)) >> 4;
+    sort_render_order(camera_chunk_pos);
 
-    glm::vec3 fov_normals[4];
-
-    /* Horizontal Normals */
-    fov_normals[0] = glm::normalize(glm::cross(-camera_direction + cam_right * half_h, cam_up));
-    fov_normals[1] = glm::normalize(glm::cross(+camera_direction + cam_right * half_h, cam_up));
+    if (render_order_corners_dirty)
+    {
+        render_order_corners.x.resize(chunks_render_order.size());
+        render_order_corners.y.resize(chunks_render_order.size());
+        render_order_corners.z.resize(chunks_render_order.size());
+        for (size_t i = 0; i < chunks_render_order.size(); i++)
+        {
+            const glm::vec3 corner = glm::vec3(chunks_render_order[i]->pos << 4);
+            render_order_corners.x[i] = corner.x;
+            render_order_corners.y[i] = corner.y;
+            render_order_corners.z[i] = corner.z;
+        }
+        render_order_corners_dirty = 0;
+    }
 
-    /* Vertical Normals */
-    fov_normals[2] = glm::normalize(glm::cross(cam_right, -camera_direction + cam_up * half_v));
-    fov_normals[3] = glm::normalize(glm::cross(cam_right, +camera_direction + cam_up * half_v));
+    const size_t num_chunks = chunks_render_order.size();
+    cull_results.resize(num_chunks);
 
-    /* Convert camera position to 1/2 chunk coords and translate it to center chunk positions */
-    const glm::ivec3 camera_half_chunk_pos = (glm::ivec3(get_camera_pos()) >> 3) - glm::ivec3(1, 1, 1);
-    const float render_distance_half_chunk_squared = render_distance * 2.0f * render_distance * 2.0f;
-    const float min_dist = -4.0f;
+    /* Chunks are tested as whole 16^3 boxes, so unlike testing centers there is no need for any slack */
+    const frustum_t frustum(get_mat_proj(win_size, render_distance) * get_mat_cam());
+    frustum.test_cubes(
+        render_order_corners.x.data(), render_order_corners.y.data(), render_order_corners.z.data(), SUBCHUNK_SIZE_X, num_chunks, cull_results.data());
 
-#define CULL_REJECT_IF(condition) \
-    if (condition)                \
-    {                             \
-        c->visible = 0;           \
-        continue;                 \
+    /* Beyond render distance culling (Measured horizontally between the camera and the chunk center) */
+    const float center_x = camera_pos.x - SUBCHUNK_SIZE_X / 2;
+    const float center_z = camera_pos.z - SUBCHUNK_SIZE_Z / 2;
+    const float render_distance_blocks_squared = float(render_distance * SUBCHUNK_SIZE_X) * float(render_distance * SUBCHUNK_SIZE_X);
+    for (size_t i = 0; i < num_chunks; i++)
+    {
+        const float dx = render_order_corners.x[i] - center_x;
+        const float dz = render_order_corners.z[i] - center_z;
+        chunks_render_order[i]->visible = cull_results[i] && (dx * dx + dz * dz) <= render_distance_blocks_squared;
     }
+
+    /* Air chunks are only rejected after cave culling, because the flood fill has to pass through them */
+    chunk_cubic_t* const camera_chunk = get_chunk(camera_chunk_pos);
+    if (r_cave_culling.get() && camera_chunk)
+        cave_cull(chunks_render_order, camera_chunk);
+
     for (chunk_cubic_t* c : chunks_render_order)
+        if (c->renderer_hints.uniform_air)
+            c->visible = 0;
+
+    if (r_render_order_exact.get())
+        refine_render_order(camera_pos);
+}
+
+/**
+ * Sort key for level_t::chunks_render_order
+ *
+ * Component differences are clamped so that the squared distance always fits in 16 bits,
+ * which bounds the histogram used by level_t::sort_render_order()
+ */
+static inline Uint32 render_order_key(const glm::ivec3 pos, const glm::ivec3 center)
+{
+    const glm::ivec3 d = glm::clamp(pos - center, glm::ivec3(-147), glm::ivec3(147));
+    return Uint32(d.x * d.x + d.y * d.y + d.z * d.z);
+}
+
+void level_t::sort_render_order(const glm::ivec3 center)
+{
+    const size_t num_chunks = chunks_render_order.size();
+
+    if (request_render_order_sort)
+        TRACE("Render order sort requested @ %ld", SDL_GetTicks());
+
+    /* Every key changes when the camera crosses into another chunk */
+    if (request_render_order_sort || center != last_render_order_cpos)
+        render_order_num_sorted = 0;
+    request_render_order_sort = 0;
+    last_render_order_cpos = center;
+
+    if (render_order_num_sorted == num_chunks)
+        return;
+
+    std::vector<Uint32>& keys = render_order_keys;
+    SDL_assert(keys.size() == render_order_num_sorted);
+    keys.resize(num_chunks);
+    for (size_t i = render_order_num_sorted; i < num_chunks; i++)
+        keys[i] = render_order_key(chunks_render_order[i]->pos, center);
+
+    std::vector<Uint32>& scratch_keys = render_order_scratch.keys;
+    std::vector<chunk_cubic_t*>& scratch_chunks = render_order_scratch.chunks;
+    scratch_keys.resize(num_chunks);
+    scratch_chunks.resize(num_chunks);
+
+    if (render_order_num_sorted == 0)
+    {
+        /* Full resort, the keys are small integers so a counting sort beats a comparison sort */
+        Uint32 key_max = 0;
+        for (const Uint32 key : keys)
+            key_max = SDL_max(key_max, key);
+
+        std::vector<Uint32>& histogram = render_order_scratch.histogram;
+        histogram.assign(key_max + 1, 0);
+        for (const Uint32 key : keys)
+            histogram[key]++;
+
+        Uint32 offset = 0;
+        for (Uint32& bucket : histogram)
+        {
+            const Uint32 count = bucket;
+            bucket = offset;
+            offset += count;
+        }
+
+        for (size_t i = 0; i < num_chunks; i++)
+        {
+            const Uint32 dst = histogram[keys[i]]++;
+            scratch_keys[dst] = keys[i];
+            scratch_chunks[dst] = chunks_render_order[i];
+        }
+    }
+    else
     {
-        CULL_REJECT_IF(c->renderer_hints.uniform_air);
+        /* Chunks added since the last sort (usually only a few) are sorted on their own, and then merged in */
+        std::vector<size_t> tail(num_chunks - render_order_num_sorted);
+        for (size_t i = 0; i < tail.size(); i++)
+            tail[i] = render_order_num_sorted + i;
+        std::sort(tail.begin(), tail.end(), [&keys](const size_t a, const size_t b) { return keys[a] < keys[b]; });
+
+        size_t it_head = 0, it_tail = 0;
+        for (size_t dst = 0; dst < num_chunks; dst++)
+        {
+            size_t src;
+            if (it_tail == tail.size() || (it_head < render_order_num_sorted && keys[it_head] <= keys[tail[it_tail]]))
+                src = it_head++;
+            else
+                src = tail[it_tail++];
+            scratch_keys[dst] = keys[src];
+            scratch_chunks[dst] = chunks_render_order[src];
+        }
+    }
 
-        const glm::vec3 chunk_center = glm::vec3((c->pos << 1) - camera_half_chunk_pos);
+    keys.swap(scratch_keys);
+    chunks_render_order.swap(scratch_chunks);
 
-        /* Beyond render distance culling */
-        CULL_REJECT_IF((chunk_center.x * chunk_center.x + chunk_center.z * chunk_center.z) > render_distance_half_chunk_squared);
+    render_order_num_sorted = num_chunks;
+    render_order_corners_dirty = 1;
+    render_order_refined = 0;
+}
 
-        /* Behind the camera culling */
-        CULL_REJECT_IF(glm::dot(camera_direction, chunk_center) < min_dist);
+void level_t::refine_render_order(const glm::vec3 camera_pos)
+{
+    const size_t num_chunks = chunks_render_order.size();
 
-        /* FOV Culling */
-        CULL_REJECT_IF(glm::dot(fov_normals[0], chunk_center) < min_dist);
-        CULL_REJECT_IF(glm::dot(fov_normals[1], chunk_center) < min_dist);
-        CULL_REJECT_IF(glm::dot(fov_normals[2], chunk_center) < min_dist);
-        CULL_REJECT_IF(glm::dot(fov_normals[3], chunk_center) < min_dist);
-        c->visible = 1;
+    if (render_order_corners_dirty || render_order_num_sorted != num_chunks)
+        return;
+
+    /* Within a bucket the exact order only shifts a little as the camera moves around inside its chunk */
+    const glm::vec3 moved = camera_pos - last_render_order_refine_pos;
+    if (render_order_refined && glm::dot(moved, moved) < 4.0f)
+        return;
+
+    render_order_refined = 1;
+    last_render_order_refine_pos = camera_pos;
+
+    /* Distance is measured to chunk centers */
+    const glm::vec3 center = camera_pos - glm::vec3(SUBCHUNK_SIZE_X, SUBCHUNK_SIZE_Y, SUBCHUNK_SIZE_Z) / 2.0f;
+
+    struct slot_t
+    {
+        float dist;
+        size_t idx;
+    };
+    std::vector<slot_t> slots;
+    std::vector<chunk_cubic_t*> run_chunks;
+    std::vector<glm::vec3> run_corners;
+
+    for (size_t start = 0, end = 0; start < num_chunks; start = end)
+    {
+        slots.clear();
+        for (end = start; end < num_chunks && render_order_keys[end] == render_order_keys[start]; end++)
+        {
+            if (!chunks_render_order[end]->visible)
+                continue;
+            const float dx = render_order_corners.x[end] - center.x;
+            const float dy = render_order_corners.y[end] - center.y;
+            const float dz = render_order_corners.z[end] - center.z;
+            slots.push_back({ dx * dx + dy * dy + dz * dz, end });
+        }
+
+        if (slots.size() < 2)
+            continue;
+
+        /* Only the visible slots are permuted amongst themselves, everything else in the bucket stays put */
+        run_chunks.clear();
+        run_corners.clear();
+        for (const slot_t& slot : slots)
+        {
+            run_chunks.push_back(chunks_render_order[slot.idx]);
+            run_corners.push_back(glm::vec3(render_order_corners.x[slot.idx], render_order_corners.y[slot.idx], render_order_corners.z[slot.idx]));
+        }
+
+        std::vector<size_t> order(slots.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&slots](const size_t a, const size_t b) { return slots[a].dist < slots[b].dist; });
+
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            const size_t dst = slots[i].idx;
+            chunks_render_order[dst] = run_chunks[order[i]];
+            render_order_corners.x[dst] = run_corners[order[i]].x;
+            render_order_corners.y[dst] = run_corners[order[i]].y;
+            render_order_corners.z[dst] = run_corners[order[i]].z;
+        }
     }
-#undef CULL_REJECT_IF
 }
 
 void level_t::update_chunk_renderer_hints()
 {
-    for (chunk_cubic_t* c : chunks_light_order)
+    /* Changing the blocks of a chunk resets the hints, and anything that changes blocks also queues the chunk */
+    for (chunk_cubic_t* c : chunks_dirty)
     {
         if (c->renderer_hints.hints_set)
             continue;
@@ -135,6 +349,18 @@ void level_t::update_chunk_renderer_hints()
     }
 }
 
+void level_t::mark_dirty(chunk_cubic_t* const c, const chunk_cubic_t::dirty_level_t lvl)
+{
+    if (c->dirty_level < lvl)
+        c->dirty_level = lvl;
+
+    if (c->dirty_queued)
+        return;
+
+    c->dirty_queued = 1;
+    chunks_dirty.push_back(c);
+}
+
 void level_t::build_dirty_meshes(const int render_distance)
 {
     auto timer_scoped_full = timer_build_dirty_meshes.start_scoped();
@@ -146,21 +372,10 @@ void level_t::build_dirty_meshes(const int render_distance)
     Uint64 tick_start;
     const Uint64 tick_func_start_ms = SDL_GetTicks();
 
-    if (request_light_order_sort || tick_func_start_ms - last_light_order_sort_time > 5000)
-    {
-        std::sort(chunks_light_order.begin(), chunks_light_order.end(), [](const chunk_cubic_t* const a, const chunk_cubic_t* const b) {
-            if (a->pos.x > b->pos.x)
-                return true;
-            if (a->pos.x < b->pos.x)
-                return false;
-            if (a->pos.z > b->pos.z)
-                return true;
-            if (a->pos.z < b->pos.z)
-                return false;
-            return a->pos.y > b->pos.y;
-        });
-        last_light_order_sort_time = SDL_GetTicks();
-        request_light_order_sort = 0;
+    if (light_order_num_sorted != chunks_light_order.size())
+    {
+        sort_light_order(chunks_light_order, light_order_num_sorted);
+        light_order_num_sorted = chunks_light_order.size();
     }
     else if (tick_func_start_ms - last_out_of_range_mesh_clear_time > 50)
     {
@@ -185,152 +400,265 @@ void level_t::build_dirty_meshes(const int render_distance)
         last_out_of_range_mesh_clear_time = SDL_GetTicks();
     }
 
-    timer_prep.finish();
-    auto timer_dirty = timer_build_dirty_meshes_dirty_prop.start_scoped();
-
-    /* Dirty level propagation pass (Backwards and forwards, twice just to be sure) */
-    PASS_TIMER_START();
-    for (int i = chunks_light_order.size() * 2 - 1, vec_size = chunks_light_order.size(), i_min = -vec_size * 2; i > i_min; i--)
+    /* Catch anything that changed a dirty level without going through level_t::mark_dirty() */
+    if (dev_verify_dirty_list.get())
     {
-        chunk_cubic_t* c = chunks_light_order[abs(i) % vec_size];
-        if (c->dirty_level <= chunk_cubic_t::DIRTY_LEVEL_MESH)
-            continue;
+        for (chunk_cubic_t* c : chunks_light_order)
+        {
+            if (c->dirty_queued || (c->dirty_level <= chunk_cubic_t::DIRTY_LEVEL_MESH && c->renderer_hints.hints_set))
+                continue;
+            dc_log_warn("Chunk <%d, %d, %d> was not in the dirty list!", c->pos.x, c->pos.y, c->pos.z);
+            mark_dirty(c, chunk_cubic_t::DIRTY_LEVEL_NONE);
+            if (!c->renderer_hints.hints_set)
+                c->update_renderer_hints();
+        }
+    }
 
-        chunk_cubic_t::dirty_level_t adj_dirt_level = chunk_cubic_t::dirty_level_t(c->dirty_level - 1);
+    chunk_budget.begin_frame(Uint64(r_chunk_budget_ms.get() * 1000000.0f));
 
-        assert(adj_dirt_level != chunk_cubic_t::DIRTY_LEVEL_NONE);
+    /* Visible chunks first, then nearest first, so that whatever gets carried over is what matters the least */
+    if (chunk_budget.is_limited())
+    {
+        const glm::ivec3 camera_chunk_pos = glm::ivec3(glm::floor(get_camera_pos())) >> 4;
+        std::sort(chunks_dirty.begin(), chunks_dirty.end(), [&camera_chunk_pos](const chunk_cubic_t* const a, const chunk_cubic_t* const b) {
+            if (a->visible != b->visible)
+                return a->visible > b->visible;
+            return render_order_key(a->pos, camera_chunk_pos) < render_order_key(b->pos, camera_chunk_pos);
+        });
+    }
 
-#define ASSIGN_DIRT_LVL_IF(WHO, LVL, COND)             \
-    if ((WHO) && (COND) && (WHO)->dirty_level < (LVL)) \
-    (WHO)->dirty_level = (LVL)
-        ASSIGN_DIRT_LVL_IF(c->neighbors.pos_x, adj_dirt_level, !c->renderer_hints.opaque_face_pos_x);
-        ASSIGN_DIRT_LVL_IF(c->neighbors.pos_y, adj_dirt_level, !c->renderer_hints.opaque_face_pos_y);
-        ASSIGN_DIRT_LVL_IF(c->neighbors.pos_z, adj_dirt_level, !c->renderer_hints.opaque_face_pos_z);
-        ASSIGN_DIRT_LVL_IF(c->neighbors.neg_x, adj_dirt_level, !c->renderer_hints.opaque_face_neg_x);
-        ASSIGN_DIRT_LVL_IF(c->neighbors.neg_y, c->dirty_level, !c->renderer_hints.opaque_face_neg_y);
-        ASSIGN_DIRT_LVL_IF(c->neighbors.neg_z, adj_dirt_level, !c->renderer_hints.opaque_face_neg_z);
-#undef ASSIGN_DIRT_LVL_IF
+    timer_prep.finish();
+    auto timer_dirty = timer_build_dirty_meshes_dirty_prop.start_scoped();
+    const Uint64 tick_light_start = SDL_GetTicksNS();
 
-        built++;
-    }
+    /* Dirty level propagation pass */
+    PASS_TIMER_START();
+    std::vector<chunk_cubic_t*> chunks_taken;
+    /* Room is left for one mesh, which is always built, so that a frame with both kinds of work does not go over */
+    built = take_dirty_chunks(chunks_dirty, chunk_budget.fit(chunk_cost_light, 1, Uint64(chunk_cost_mesh.ns_per_item)), chunks_taken);
     PASS_TIMER_STOP(0, "Propagated dirty level for %zu chunks in %.2f ms (%.2f ms per)", built, elapsed / 1000000.0, elapsed / built / 1000000.0);
     timer_dirty.finish();
     auto timer_light_cull = timer_build_dirty_meshes_light_cull.start_scoped();
 
-    ImVector<chunk_cubic_t*> chunks_needing_light;
+    std::vector<chunk_cubic_t*> chunks_needing_light;
 
     /* Clear Light Pass and Fast-forward cull pass */
     PASS_TIMER_START();
-    for (chunk_cubic_t* c : chunks_light_order)
-    {
-        /* Fast-forward cull pass */
-        if (BETWEEN_INCL(c->dirty_level, chunk_cubic_t::DIRTY_LEVEL_MESH, chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_0))
-        {
-            bool light_can_leave = c->can_light_leave();
-            if (c->renderer_hints.opaque_sides || !light_can_leave)
-                c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
-            if (c->renderer_hints.uniform_opaque)
-            {
-                c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
-
-                if (!light_can_leave)
-                    c->free_renderer_resources(chunk_cubic_t::DIRTY_LEVEL_NONE);
-            }
-        }
-
-        if (c->dirty_level > chunk_cubic_t::DIRTY_LEVEL_MESH)
-            chunks_needing_light.push_back(c);
-
-        /* Clear Light Pass */
-        if (c->dirty_level != chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL)
-            continue;
-        c->clear_light_block(0);
-        c->light_pass_block_setup();
-        c->clear_light_sky(0);
-        built++;
-    }
+    built = light_clear_pass(chunks_taken, chunks_needing_light);
     PASS_TIMER_STOP(enable_timer_log_light, "Cleared %zu chunks in %.2f ms (%.2f ms per) (Pass 1)", built, elapsed / 1000000.0, elapsed / built / 1000000.0);
     timer_light_cull.finish();
     auto timer_light = timer_build_dirty_meshes_light.start_scoped();
 
+    int light_threads = light_threads_override > 0 ? light_threads_override : r_light_threads.get();
+    if (light_threads < 0)
+        light_threads = SDL_GetNumLogicalCPUCores() - 1;
+
+    const light_waves_t light_waves = build_light_waves(chunks_needing_light);
+
     /* First Light Pass */
     PASS_TIMER_START();
-    for (chunk_cubic_t* c : chunks_needing_light)
-    {
-        if (c->dirty_level != chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL)
-            continue;
-        c->light_pass_block_grab_from_neighbors();
-        c->light_pass_block_propagate_internals();
-        c->light_pass_sky_grab_from_neighbors();
-        c->light_pass_sky_propagate_internals();
-        c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_0;
-        built++;
-    }
+    built = light_pass(light_waves, chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL, light_threads);
     PASS_TIMER_STOP(enable_timer_log_light, "Lit %zu chunks in %.2f ms (%.2f ms per) (Pass 1)", built, elapsed / 1000000.0, elapsed / built / 1000000.0);
     last_perf_light_pass1.duration = elapsed;
     last_perf_light_pass1.built = built;
 
     /* Second Light Pass */
     PASS_TIMER_START();
-    for (chunk_cubic_t* c : chunks_needing_light)
-    {
-        if (c->dirty_level != chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_0)
-            continue;
-        c->light_pass_block_grab_from_neighbors();
-        c->light_pass_block_propagate_internals();
-        c->light_pass_sky_grab_from_neighbors();
-        c->light_pass_sky_propagate_internals();
-        c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_1;
-        built++;
-    }
+    built = light_pass(light_waves, chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_0, light_threads);
     PASS_TIMER_STOP(enable_timer_log_light, "Lit %zu chunks in %.2f ms (%.2f ms per) (Pass 2)", built, elapsed / 1000000.0, elapsed / built / 1000000.0);
     last_perf_light_pass2.duration = elapsed;
     last_perf_light_pass2.built = built;
 
     /* Third Light Pass */
     PASS_TIMER_START();
-    for (chunk_cubic_t* c : chunks_needing_light)
-    {
-        if (c->dirty_level != chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_1)
-            continue;
-        c->light_pass_block_grab_from_neighbors();
-        c->light_pass_block_propagate_internals();
-        c->light_pass_sky_grab_from_neighbors();
-        c->light_pass_sky_propagate_internals();
-        if (c->renderer_hints.uniform_air)
-            c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_NONE;
-        else
-            c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
-        built++;
-    }
+    built = light_pass(light_waves, chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_1, light_threads);
     PASS_TIMER_STOP(enable_timer_log_light, "Lit %zu chunks in %.2f ms (%.2f ms per) (Pass 3)", built, elapsed / 1000000.0, elapsed / built / 1000000.0);
     last_perf_light_pass3.duration = elapsed;
     last_perf_light_pass3.built = built;
+    chunk_budget.spend(chunk_cost_light, SDL_GetTicksNS() - tick_light_start, chunks_needing_light.size());
     timer_light.finish();
     auto timer_mesh = timer_build_dirty_meshes_mesh.start_scoped();
 
     /* Mesh Pass */
     PASS_TIMER_START();
-    int throttle = r_mesh_throttle.get();
+    const int num_workers = mesh_workers_update();
+    mesh_workers_collect();
+
+    /* With workers the throttle only limits how many snapshots are taken on the main thread per frame */
+    int throttle = r_mesh_throttle.get() * SDL_max(num_workers, 1);
+    if (chunk_budget.is_limited())
+        throttle = int(chunk_budget.fit(chunk_cost_mesh));
+    /* Keeping the job queue short keeps the snapshots fresh, and the nearest chunks at the front of the line */
+    const int max_jobs_in_flight = num_workers * 4;
+    std::vector<mesh_snapshot_t*> jobs;
     glm::ivec3 pos_cam(glm::ivec3(glm::round(get_camera_pos())) >> 4);
     for (chunk_cubic_t* c : chunks_render_order)
     {
         if (c->dirty_level != chunk_cubic_t::DIRTY_LEVEL_MESH || !c->visible)
             continue;
         /* Bypass mesh throttle for nearby chunks (To stop holes from being punched in the world) */
-        if (throttle <= 0 && (abs(c->pos.x - pos_cam.x) > 1 || abs(c->pos.y - pos_cam.y) > 1 || abs(c->pos.z - pos_cam.z) > 1))
+        const bool nearby = abs(c->pos.x - pos_cam.x) <= 1 && abs(c->pos.y - pos_cam.y) <= 1 && abs(c->pos.z - pos_cam.z) <= 1;
+        if (!nearby && (throttle <= 0 || (num_workers && mesh_jobs_in_flight + int(jobs.size()) >= max_jobs_in_flight)))
             continue;
-        build_mesh(c);
+        if (num_workers && terrain)
+            jobs.push_back(create_mesh_snapshot(c, true));
+        else
+            build_mesh(c);
         c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_NONE;
         built++;
         throttle--;
     }
-    PASS_TIMER_STOP(enable_timer_log_mesh, "Built %zu meshes in %.2f ms (%.2f ms per)", built, elapsed / 1000000.0, elapsed / built / 1000000.0);
+
+    if (jobs.size())
+    {
+        SDL_LockMutex(mesh_jobs_lock);
+        for (mesh_snapshot_t* job : jobs)
+            mesh_jobs_pending.push_back(job);
+        SDL_BroadcastCondition(mesh_jobs_cond);
+        SDL_UnlockMutex(mesh_jobs_lock);
+        mesh_jobs_in_flight += jobs.size();
+    }
+    PASS_TIMER_STOP(enable_timer_log_mesh, "Built/Submitted %zu meshes in %.2f ms (%.2f ms per)", built, elapsed / 1000000.0, elapsed / built / 1000000.0);
     last_perf_mesh_pass.duration = elapsed;
     last_perf_mesh_pass.built = built;
+    chunk_budget.spend(chunk_cost_mesh, elapsed, built);
     timer_mesh.finish();
 }
 
+void level_t::apply_mesh_result(mesh_queue_info_t& result)
+{
+    chunk_cubic_t* c = get_chunk(result.pos);
+
+    if (!c || c->mesh_generation != result.generation)
+    {
+        result.release_data();
+        return;
+    }
+
+    /* Chunk meshed to nothing, the dirty level is left alone in case the chunk changed after the snapshot was taken */
+    if (!result.vertex_data)
+    {
+        c->free_renderer_resources(c->dirty_level);
+        return;
+    }
+
+    mesh_queue.push_back(result);
+}
+
+void level_t::mesh_result_lost(const glm::ivec3 pos, const Uint64 generation)
+{
+    chunk_cubic_t* c = get_chunk(pos);
+
+    if (c && c->mesh_generation == generation && c->dirty_level < chunk_cubic_t::DIRTY_LEVEL_MESH)
+        c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
+}
+
+int level_t::mesh_worker_func(void* userdata)
+{
+    level_t* const level = static_cast<level_t*>(userdata);
+
+    SDL_LockMutex(level->mesh_jobs_lock);
+    while (1)
+    {
+        while (!level->mesh_workers_quit && level->mesh_jobs_pending.empty())
+            SDL_WaitCondition(level->mesh_jobs_cond, level->mesh_jobs_lock);
+
+        if (level->mesh_workers_quit)
+            break;
+
+        mesh_snapshot_t* snapshot = level->mesh_jobs_pending.front();
+        level->mesh_jobs_pending.pop_front();
+        SDL_UnlockMutex(level->mesh_jobs_lock);
+
+        mesh_queue_info_t result = {};
+        build_mesh_from_snapshot(*snapshot, result);
+        delete snapshot;
+
+        SDL_LockMutex(level->mesh_jobs_lock);
+        level->mesh_jobs_done.push_back(result);
+    }
+    SDL_UnlockMutex(level->mesh_jobs_lock);
+
+    return 0;
+}
+
+int level_t::mesh_workers_update()
+{
+    int num_threads = r_mesh_threads.get();
+    if (num_threads < 0)
+        num_threads = SDL_clamp(SDL_GetNumLogicalCPUCores() / 2, 1, 8);
+
+    if (int(mesh_workers.size()) == num_threads)
+        return num_threads;
+
+    mesh_workers_stop();
+
+    for (int i = 0; i < num_threads; i++)
+    {
+        SDL_Thread* t = SDL_CreateThread(mesh_worker_func, "Mesh builder", this);
+        if (!t)
+        {
+            dc_log_error("Unable to create mesh worker: %s", SDL_GetError());
+            break;
+        }
+        mesh_workers.push_back(t);
+    }
+
+    if (mesh_workers.size())
+        dc_log("Started %zu mesh workers", mesh_workers.size());
+
+    /* On failure, this will result in a retry every frame, which is better than never meshing */
+    return mesh_workers.size();
+}
+
+void level_t::mesh_workers_stop()
+{
+    if (mesh_workers.empty())
+        return;
+
+    SDL_LockMutex(mesh_jobs_lock);
+    mesh_workers_quit = true;
+    SDL_BroadcastCondition(mesh_jobs_cond);
+    SDL_UnlockMutex(mesh_jobs_lock);
+
+    for (SDL_Thread* t : mesh_workers)
+        SDL_WaitThread(t, NULL);
+    mesh_workers.clear();
+    mesh_workers_quit = false;
+
+    /* With the workers gone nothing else touches the job queues */
+    for (mesh_snapshot_t* snapshot : mesh_jobs_pending)
+    {
+        mesh_result_lost(snapshot->pos, snapshot->generation);
+        delete snapshot;
+    }
+    mesh_jobs_pending.clear();
+
+    for (mesh_queue_info_t& result : mesh_jobs_done)
+    {
+        mesh_result_lost(result.pos, result.generation);
+        result.release_data();
+    }
+    mesh_jobs_done.clear();
+
+    mesh_jobs_in_flight = 0;
+}
+
+void level_t::mesh_workers_collect()
+{
+    std::vector<mesh_queue_info_t> done;
+
+    SDL_LockMutex(mesh_jobs_lock);
+    std::swap(done, mesh_jobs_done);
+    SDL_UnlockMutex(mesh_jobs_lock);
+
+    mesh_jobs_in_flight -= done.size();
+    assert(mesh_jobs_in_flight >= 0);
+
+    for (mesh_queue_info_t& result : done)
+        apply_mesh_result(result);
+}
+
 void level_t::set_block(const glm::ivec3 pos, const itemstack_t block, chunk_cubic_t*& cache)
 {
     const block_id_t type = block.id;
@@ -353,29 +681,32 @@ void level_t::set_block(const glm::ivec3 pos, const itemstack_t block, chunk_cub
     glm::ivec3 block_pos = pos & 0x0F;
     if (!cache || cache->pos != chunk_pos)
     {
-        auto it = cmap.find(chunk_pos);
-        if (it == cmap.end())
+        if (!(cache = chunk_grid.find(chunk_pos)))
         {
             TRACE("Unable to find chunk <%d, %d, %d>", chunk_pos.x, chunk_pos.y, chunk_pos.z);
             return;
         }
-
-        cache = it->second;
     }
 
     /* Get existing blocks data to help determine which chunks need rebuilding */
     block_id_t old_type = cache->get_type(block_pos.x, block_pos.y, block_pos.z);
+    const chunk_cubic_t::dirty_level_t old_dirty_level = cache->dirty_level;
 
     /* Set type */
     cache->set_type(block_pos.x, block_pos.y, block_pos.z, type);
     cache->set_metadata(block_pos.x, block_pos.y, block_pos.z, metadata);
+    mark_dirty(cache, chunk_cubic_t::DIRTY_LEVEL_NONE);
+
+    /* Chunks already waiting on a full relight would just overwrite the result */
+    if (old_dirty_level <= chunk_cubic_t::DIRTY_LEVEL_MESH && relight_block(cache, block_pos))
+        return;
 
     /* Surrounding chunks do not need updating if the replacement has an equal effect on lighting */
-    if (mc_id::is_transparent(old_type) == mc_id::is_transparent(type) && mc_id::get_light_level(old_type) == mc_id::get_light_level(type))
+    const mc_id::block_property_tables_t& props = mc_id::block_properties;
+    if (props.transparent[old_type] == props.transparent[type] && props.light_level[old_type] == props.light_level[type])
         return;
 
-    if (cache->dirty_level < chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL)
-        cache->dirty_level = chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL;
+    mark_dirty(cache);
 
     bool within_bounds_x = BETWEEN_INCL(block_pos.x, 1, SUBCHUNK_SIZE_X - 1);
     bool within_bounds_y = BETWEEN_INCL(block_pos.y, 1, SUBCHUNK_SIZE_Y - 1);
@@ -387,19 +718,12 @@ void level_t::set_block(const glm::ivec3 pos, const itemstack_t block, chunk_cub
     if (within_bounds && cache->renderer_hints.opaque_sides)
         return;
 
-    /* This isn't efficient, but it works the best, so */
     for (int i = 0; i < 27; i++)
     {
-        const int ix = (i / 9) % 3 - 1;
-        const int iy = (i / 3) % 3 - 1;
-        const int iz = i % 3 - 1;
-
-        chunk_cubic_t* c = cache->find_chunk(cache, chunk_pos + glm::ivec3(ix, iy, iz));
+        chunk_cubic_t* c = cache->neighborhood[i / 9][(i / 3) % 3][i % 3];
 
-        chunk_cubic_t::dirty_level_t dirt_face = chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL;
-
-        if (c && c->dirty_level < dirt_face)
-            c->dirty_level = dirt_face;
+        if (c)
+            mark_dirty(c);
     }
 }
 
@@ -408,15 +732,13 @@ bool level_t::get_block(const glm::ivec3 pos, block_id_t& type, Uint8& metadata)
     /* Attempt to find chunk */
     glm::ivec3 chunk_pos = pos >> 4;
     glm::ivec3 block_pos = pos & 0x0F;
-    auto it = cmap.find(chunk_pos);
-    if (it == cmap.end())
+    chunk_cubic_t* c = chunk_grid.find(chunk_pos);
+    if (!c)
     {
         TRACE("Unable to find chunk <%d, %d, %d>", chunk_pos.x, chunk_pos.y, chunk_pos.z);
         return false;
     }
 
-    chunk_cubic_t* c = it->second;
-
     type = c->get_type(block_pos.x, block_pos.y, block_pos.z);
     metadata = c->get_metadata(block_pos.x, block_pos.y, block_pos.z);
 
@@ -431,14 +753,11 @@ bool level_t::get_block(const glm::ivec3 pos, itemstack_t& item, chunk_cubic_t*&
     /* Attempt to find chunk, if cache doesn't match */
     if (!cache || cache->pos != chunk_pos)
     {
-        auto it = cmap.find(chunk_pos);
-        if (it == cmap.end())
+        if (!(cache = chunk_grid.find(chunk_pos)))
         {
             TRACE("Unable to find chunk <%d, %d, %d>", chunk_pos.x, chunk_pos.y, chunk_pos.z);
             return false;
         }
-
-        cache = it->second;
     }
 
     item.id = cache->get_type(block_pos.x, block_pos.y, block_pos.z);
@@ -449,6 +768,9 @@ bool level_t::get_block(const glm::ivec3 pos, itemstack_t& item, chunk_cubic_t*&
 
 void level_t::set_terrain(texture_terrain_t* const _terrain)
 {
+    /* The workers hold pointers to the old terrain (They will be restarted by the next level_t::build_dirty_meshes() call) */
+    mesh_workers_stop();
+
     terrain = _terrain;
     clear_mesh(false);
 
@@ -603,10 +925,28 @@ static convar_float_t cvr_r_damage_tilt_rate {
     CONVAR_FLAG_SAVE,
 };
 
+glm::mat4 level_t::get_mat_proj(const glm::ivec2 target_size, const int render_distance) const
+{
+    return glm::perspective(glm::radians(fov), (float)target_size.x / (float)target_size.y, render_distance * 32.0f, 1.f / 16.f);
+}
+
+glm::mat4 level_t::get_mat_cam() const
+{
+    float tilt = SDL_clamp(damage_tilt, 0.0f, 1.0f);
+    if (gamemode == mc_id::GAMEMODE_CREATIVE || gamemode == mc_id::GAMEMODE_SPECTATOR)
+        tilt = 0.0f;
+
+    const glm::mat4 mat_cam = glm::lookAt(get_camera_pos(), get_camera_pos() + camera_direction, camera_up);
+    return glm::rotate(glm::mat4(1.0f), -glm::radians(tilt * cvr_r_damage_tilt_magnitude.get()), glm::vec3(0.f, 0.f, 1.f)) * mat_cam;
+}
+
 void level_t::render_stage_prepare(const glm::ivec2 win_size, const float delta_time)
 {
     const int render_distance = (render_distance_override > 0) ? render_distance_override : r_render_distance.get();
 
+    /* Culling and meshing reach out to (render_distance * 2 + 2) chunks */
+    chunk_grid.recenter(glm::ivec3(glm::floor(get_camera_pos())) >> 4, render_distance * 2 + 2);
+
     cull_chunks(win_size, render_distance);
 
     build_dirty_meshes(render_distance);
@@ -650,8 +990,8 @@ bool level_t::mesh_queue_upload_item(SDL_GPUCommandBuffer* const command_buffer,
 {
     chunk_cubic_t* c = get_chunk(item.pos);
 
-    /* Mesh is for non-existent chunk, pop it */
-    if (!c)
+    /* Mesh is for non-existent chunk or was superseded while waiting for upload, pop it */
+    if (!c || c->mesh_generation != item.generation)
         return true;
 
     glm::ivec4 chunk_pos(c->pos.x, c->pos.y, c->pos.z, 0);
@@ -703,16 +1043,24 @@ void level_t::render_stage_copy(SDL_GPUCommandBuffer* const command_buffer, SDL_
     if (!missing_ent_ssbo || !missing_ent_num_instances)
         upload_missing_ent_mesh(copy_pass);
 
-    for (int i = 0; mesh_queue.size() && i < r_mesh_throttle.get() * 4; i++)
+    /* Uploads draw from whatever is left of the budget after lighting and meshing */
+    const size_t max_uploads = chunk_budget.is_limited() ? chunk_budget.fit(chunk_cost_upload) : size_t(r_mesh_throttle.get() * 4);
+    const Uint64 tick_upload_start = SDL_GetTicksNS();
+    size_t uploaded = 0;
+    for (size_t i = 0; mesh_queue.size() && i < max_uploads; i++)
     {
         mesh_queue_info_t item = mesh_queue.front();
         mesh_queue.pop_front();
 
         if (mesh_queue_upload_item(command_buffer, copy_pass, item))
+        {
             item.release_data();
+            uploaded++;
+        }
         else
             mesh_queue.push_back(item);
     }
+    chunk_budget.spend(chunk_cost_upload, SDL_GetTicksNS() - tick_upload_start, uploaded);
 
     ImVector<glm::ivec4> pos_data;
     ImVector<SDL_GPUIndirectDrawCommand> solid_commands;
@@ -877,39 +1225,14 @@ SDL_GPURenderPass* level_t::render_stage_render(
     SDL_PushGPUDebugGroup(command_buffer, "level_t::render_stage_render()");
     const int render_distance = (render_distance_override > 0) ? render_distance_override : r_render_distance.get();
 
-    glm::mat4 mat_proj = glm::perspective(glm::radians(fov), (float)target_size.x / (float)target_size.y, render_distance * 32.0f, 1.f / 16.f);
+    glm::mat4 mat_proj = get_mat_proj(target_size, render_distance);
 
-    glm::mat4 mat_cam = glm::lookAt(get_camera_pos(), get_camera_pos() + camera_direction, camera_up);
     damage_tilt = SDL_clamp(damage_tilt, 0.0f, 1.0f);
     if (gamemode == mc_id::GAMEMODE_CREATIVE || gamemode == mc_id::GAMEMODE_SPECTATOR)
         damage_tilt = 0.0f;
-    mat_cam = glm::rotate(glm::mat4(1.0f), -glm::radians(damage_tilt * cvr_r_damage_tilt_magnitude.get()), glm::vec3(0.f, 0.f, 1.f)) * mat_cam;
+    glm::mat4 mat_cam = get_mat_cam();
     damage_tilt -= delta_time / (cvr_r_damage_tilt_magnitude.get() * cvr_r_damage_tilt_rate.get() / 1000.0f);
 
-    {
-        const glm::i64vec3 cpos(glm::round(get_camera_pos() / 16.0f));
-        const glm::i64vec3 camera_pos_diff = cpos - last_render_order_cpos;
-        const glm::f64vec3 float_cpos(cpos);
-
-        if (camera_pos_diff != glm::i64vec3(0, 0, 0))
-            request_render_order_sort = 1;
-
-        if (request_render_order_sort)
-            TRACE("Render order sort requested @ %ld", SDL_GetTicks());
-
-        if (request_render_order_sort || SDL_GetTicks() - last_render_order_sort_time > 5000)
-        {
-            std::sort(chunks_render_order.begin(), chunks_render_order.end(), [&float_cpos](const chunk_cubic_t* const a, const chunk_cubic_t* const b) {
-                const float adist = glm::distance(glm::f64vec3(a->pos), float_cpos);
-                const float bdist = glm::distance(glm::f64vec3(b->pos), float_cpos);
-                return adist < bdist;
-            });
-            last_render_order_sort_time = SDL_GetTicks();
-            request_render_order_sort = 0;
-            last_render_order_cpos = cpos;
-        }
-    }
-
     /** Creation info for all depth targets */
     SDL_GPUTextureCreateInfo cinfo_depth_target = {};
     cinfo_depth_target.type = SDL_GPU_TEXTURETYPE_2D;
@@ -1158,30 +1481,20 @@ SDL_GPURenderPass* level_t::render_stage_render(
 
 void level_t::remove_chunk(const glm::ivec3 pos)
 {
-    auto it_map = cmap.find(pos);
+    chunk_cubic_t* mapped_del = chunk_grid.erase(pos);
 
-    chunk_cubic_t* mapped_del = NULL;
+    /* Erased before anything is deleted so that duplicates are caught as well */
+    chunks_dirty.erase(
+        std::remove_if(chunks_dirty.begin(), chunks_dirty.end(), [&pos](const chunk_cubic_t* const c) { return c->pos == pos; }), chunks_dirty.end());
 
-    if (it_map != cmap.end())
+    if (mapped_del)
     {
-        mapped_del = it_map->second;
-        delete it_map->second;
-        cmap.erase(it_map);
+        chunk_grid_t::unlink_neighbors(mapped_del);
+        delete mapped_del;
     }
 
     for (auto it_vec = chunks_render_order.begin(); it_vec != chunks_render_order.end();)
     {
-        /* Remove self as neighbor from neighbors */
-        /* It would more efficient to do this by traversing mapped_del's neighbors, but this is more thorough */
-        // clang-format off
-        if ((*it_vec)->neighbors.neg_x == mapped_del) (*it_vec)->neighbors.neg_x = NULL;
-        if ((*it_vec)->neighbors.pos_x == mapped_del) (*it_vec)->neighbors.pos_x = NULL;
-        if ((*it_vec)->neighbors.neg_y == mapped_del) (*it_vec)->neighbors.neg_y = NULL;
-        if ((*it_vec)->neighbors.pos_y == mapped_del) (*it_vec)->neighbors.pos_y = NULL;
-        if ((*it_vec)->neighbors.neg_z == mapped_del) (*it_vec)->neighbors.neg_z = NULL;
-        if ((*it_vec)->neighbors.pos_z == mapped_del) (*it_vec)->neighbors.pos_z = NULL;
-        // clang-format on
-
         if ((*it_vec)->pos != pos)
             it_vec++;
         else
@@ -1191,7 +1504,14 @@ void level_t::remove_chunk(const glm::ivec3 pos)
                 dc_log_warn("Duplicate chunk <%d, %d, %d> erased!", (*it_vec)->pos.x, (*it_vec)->pos.y, (*it_vec)->pos.z);
                 delete *it_vec;
             }
+            const size_t idx = it_vec - chunks_render_order.begin();
+            if (idx < render_order_num_sorted)
+            {
+                render_order_keys.erase(render_order_keys.begin() + idx);
+                render_order_num_sorted--;
+            }
             it_vec = chunks_render_order.erase(it_vec);
+            render_order_corners_dirty = 1;
         }
     }
 
@@ -1206,12 +1526,13 @@ void level_t::remove_chunk(const glm::ivec3 pos)
                 dc_log_warn("Duplicate chunk <%d, %d, %d> erased!", (*it_vec)->pos.x, (*it_vec)->pos.y, (*it_vec)->pos.z);
                 delete *it_vec;
             }
+            if (size_t(it_vec - chunks_light_order.begin()) < light_order_num_sorted)
+                light_order_num_sorted--;
             it_vec = chunks_light_order.erase(it_vec);
         }
     }
 
-    request_render_order_sort = 1;
-    request_light_order_sort = 1;
+    /* Erasing keeps both orders intact, so no resort is needed */
 }
 
 void level_t::add_chunk(chunk_cubic_t* const c)
@@ -1222,41 +1543,24 @@ void level_t::add_chunk(chunk_cubic_t* const c)
         return;
     }
 
-    decltype(cmap)::iterator it = cmap.find(c->pos);
-
-    if (it != cmap.end())
+    if (!chunk_grid.insert(c))
     {
         dc_log_error("Chunk is duplicate!");
         return;
     }
 
-    cmap[c->pos] = c;
-
     c->renderer_hints.hints_set = 0;
 
     chunks_light_order.push_back(c);
     chunks_render_order.push_back(c);
+    render_order_corners_dirty = 1;
+
+    chunk_grid.link_neighbors(c);
+
+    /* Renderer hints are only computed for queued chunks */
+    mark_dirty(c, chunk_cubic_t::DIRTY_LEVEL_NONE);
 
-    /* Assign neighbors */
-    c->neighbors.pos_x = (it = cmap.find(c->pos + glm::ivec3(+1, +0, +0))) != cmap.end() ? it->second : NULL;
-    c->neighbors.neg_x = (it = cmap.find(c->pos + glm::ivec3(-1, +0, +0))) != cmap.end() ? it->second : NULL;
-    c->neighbors.pos_y = (it = cmap.find(c->pos + glm::ivec3(+0, +1, +0))) != cmap.end() ? it->second : NULL;
-    c->neighbors.neg_y = (it = cmap.find(c->pos + glm::ivec3(+0, -1, +0))) != cmap.end() ? it->second : NULL;
-    c->neighbors.pos_z = (it = cmap.find(c->pos + glm::ivec3(+0, +0, +1))) != cmap.end() ? it->second : NULL;
-    c->neighbors.neg_z = (it = cmap.find(c->pos + glm::ivec3(+0, +0, -1))) != cmap.end() ? it->second : NULL;
-
-    /* Assign self as neighbor to neighbors */
-    // clang-format off
-    if (c->neighbors.pos_x != NULL) c->neighbors.pos_x->neighbors.neg_x = c;
-    if (c->neighbors.neg_x != NULL) c->neighbors.neg_x->neighbors.pos_x = c;
-    if (c->neighbors.pos_y != NULL) c->neighbors.pos_y->neighbors.neg_y = c;
-    if (c->neighbors.neg_y != NULL) c->neighbors.neg_y->neighbors.pos_y = c;
-    if (c->neighbors.pos_z != NULL) c->neighbors.pos_z->neighbors.neg_z = c;
-    if (c->neighbors.neg_z != NULL) c->neighbors.neg_z->neighbors.pos_z = c;
-    // clang-format on
-
-    request_render_order_sort = 1;
-    request_light_order_sort = 1;
+    /* The new chunk sits in the unsorted tail of both orders until the next sort merges it in */
 }
 
 level_t::level_t(texture_terrain_t* const _terrain)
@@ -1276,17 +1580,15 @@ level_t::level_t(texture_terrain_t* const _terrain)
     music = glm::mix(0.125f, 0.825f, SDL_randf());
 
     generator_create();
-}
 
-void level_t::mesh_queue_info_t::release_data()
-{
-    if (vertex_freefunc)
-    {
-        vertex_freefunc(vertex_data);
-        vertex_data = NULL;
-    }
+    /* Resort immediately and unmesh anything that fell out of range instead of waiting for the next periodic pass */
+    cvr_render_distance_callback_id = r_render_distance.add_change_callback([this]() {
+        request_render_order_sort = 1;
+        last_out_of_range_mesh_clear_time = 0;
+    });
 }
 
+
 void level_t::transient_indirect_buffers_t::release()
 {
     gpu::release_buffer(pos);
@@ -1305,6 +1607,12 @@ level_t::transient_indirect_buffers_t::~transient_indirect_buffers_t() { release
 
 level_t::~level_t()
 {
+    r_render_distance.remove_change_callback(cvr_render_distance_callback_id);
+
+    mesh_workers_stop();
+    SDL_DestroyCondition(mesh_jobs_cond);
+    SDL_DestroyMutex(mesh_jobs_lock);
+
     for (auto& it : mesh_queue)
         it.release_data();
 
@@ -1331,12 +1639,17 @@ bool level_t::gamemode_set(int x)
 
 void level_t::clear()
 {
-    for (auto it : cmap)
-        delete it.second;
+    for (chunk_cubic_t* c : chunks_render_order)
+        delete c;
 
     chunks_light_order.clear();
     chunks_render_order.clear();
-    cmap.clear();
+    render_order_keys.clear();
+    render_order_num_sorted = 0;
+    chunks_dirty.clear();
+    light_order_num_sorted = 0;
+    render_order_corners_dirty = 1;
+    chunk_grid.clear();
 
     // for(auto entity: ecs.view<entt::entity>(entt::exclude<T>)) { ... }
     for (auto entity : ecs.view<ent_id_t>())
@@ -1533,10 +1846,6 @@ void level_t::tick_real()
     if (!cvr_mc_enable_physics.get())
         return;
 
-    bool block_has_collision[256];
-    for (int i = 0; i < IM_ARRAYSIZE(block_has_collision); i++)
-        block_has_collision[i] = mc_id::block_has_collision(i);
-
     chunk_cubic_t* chunk_cache = NULL;
 
     ecs.patch<entity_transform_t>(player_eid, [=](entity_transform_t& transform) { transform.pos = foot_pos; });
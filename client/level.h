@@ -25,7 +25,11 @@
 #define MCS_B181__CLIENT__LEVEL_H_INCLUDED
 
 #include "chunk_cubic.h"
+#include "chunk_grid.h"
+#include "climate_cache.h"
 #include "entity/entity.h"
+#include "frame_budget.h"
+#include "frustum.h"
 #include "lightmap.h"
 #include "shared/inventory.h"
 #include "sound/sound_world.h"
@@ -47,24 +51,6 @@
  */
 struct level_t
 {
-    struct ivec3_comparator_t
-    {
-        bool operator()(const glm::ivec3& a, const glm::ivec3& b) const
-        {
-            if (a.x < b.x)
-                return true;
-            if (a.x > b.x)
-                return false;
-
-            if (a.y < b.y)
-                return true;
-            if (a.y > b.y)
-                return false;
-
-            return a.z < b.z;
-        }
-    };
-
     level_t(texture_terrain_t* const terrain = NULL);
 
     ~level_t();
@@ -75,9 +61,9 @@ struct level_t
     inline const std::vector<chunk_cubic_t*>& get_chunk_vec() { return chunks_render_order; }
 
     /**
-     * Returns the chunk vector for iteration
+     * Returns the chunk index
      */
-    inline const std::map<glm::ivec3, chunk_cubic_t*, ivec3_comparator_t>* get_chunk_map() const { return &cmap; }
+    inline const chunk_grid_t& get_chunk_grid() const { return chunk_grid; }
 
     /**
      * Removes chunk from chunk vector and map, and then deletes it
@@ -91,26 +77,26 @@ struct level_t
 
     /**
      * Updates the renderer hints for any chunks that need their hints reset
+     *
+     * NOTE: Only chunks in the dirty list are checked, see level_t::mark_dirty()
      */
     void update_chunk_renderer_hints();
 
     /**
-     * Get chunk
+     * Raise the dirty level of a chunk (if needed) and queue it for the next dirty level propagation and light passes
+     *
+     * Anything that raises a dirty level above chunk_cubic_t::DIRTY_LEVEL_MESH, or changes the blocks of a chunk, must go through this
+     * (or otherwise queue the chunk), as the light passes only visit queued chunks
+     *
+     * @param c Chunk to queue
+     * @param lvl Minimum dirty level
      */
-    inline chunk_cubic_t* get_chunk(const glm::ivec3 pos)
-    {
-        decltype(cmap)::iterator it = cmap.find(pos);
-        return (it == cmap.end()) ? NULL : it->second;
-    }
+    void mark_dirty(chunk_cubic_t* const c, const chunk_cubic_t::dirty_level_t lvl = chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL);
 
     /**
      * Get chunk
      */
-    inline chunk_cubic_t* get_chunk(const glm::ivec3 pos) const
-    {
-        auto it = cmap.find(pos);
-        return (it == cmap.end()) ? NULL : it->second;
-    }
+    inline chunk_cubic_t* get_chunk(const glm::ivec3 pos) const { return chunk_grid.find(pos); }
 
     entt::registry ecs;
 
@@ -201,6 +187,19 @@ struct level_t
      */
     void set_block(const glm::ivec3 pos, const itemstack_t block, chunk_cubic_t*& cache);
 
+    /**
+     * Incrementally updates block and sky light around a block that just changed, by removing the light that could have
+     * depended on it and flood filling back in from the remaining sources
+     *
+     * Only chunks whose light or surroundings actually changed are marked for a mesh rebuild
+     *
+     * @param c Chunk containing the block
+     * @param block_pos Position of the block within the chunk
+     *
+     * @returns false if incremental relighting is disabled (r_light_incremental), in which case the caller must mark chunks for a full relight
+     */
+    bool relight_block(chunk_cubic_t* const c, const glm::ivec3 block_pos);
+
     /**
      * Gets the block data at the provided position
      *
@@ -329,6 +328,11 @@ struct level_t
      */
     int render_distance_override = 0;
 
+    /**
+     * If the value is greater than zero, then it will be used instead of r_light_threads
+     */
+    int light_threads_override = 0;
+
     struct performance_timer_t
     {
         Uint64 duration = 0;
@@ -361,6 +365,183 @@ struct level_t
 
     size_t get_mesh_queue_size() { return mesh_queue.size(); }
 
+    /**
+     * Returns the number of meshes submitted to the mesh workers that have not been collected yet
+     */
+    int get_mesh_jobs_in_flight() { return mesh_jobs_in_flight; }
+
+    climate_cache_t& get_climate_cache() { return climate_cache; }
+
+    /**
+     * Snapshots and meshes every loaded chunk on the calling thread, then throws the meshes away (For benchmarking)
+     *
+     * NOTE: Bypasses dirty levels, throttling, and the mesh workers
+     *
+     * @param quad_count Output (optional), total number of quads built
+     * @param coverage_mismatches Output (optional), number of face groups where greedy merging changed the rasterized face coverage
+     */
+    performance_timer_t benchmark_mesh_pass(size_t* quad_count = nullptr, Uint64* coverage_mismatches = nullptr);
+
+    /**
+     * Sorts chunks into light order (Descending X, then Z, then Y)
+     *
+     * @param chunks Chunks to sort
+     * @param num_sorted Number of chunks at the start of chunks that are already in light order, the rest are sorted and merged in
+     */
+    static void sort_light_order(std::vector<chunk_cubic_t*>& chunks, const size_t num_sorted = 0);
+
+    /**
+     * Propagate dirty levels between chunks (Basically light propagation)
+     *
+     * Breadth first from the chunks in the list, so the cost scales with the number of changed chunks instead of the number of loaded chunks.
+     * Propagation is bounded by the dirty level dropping by one per step (except downwards, which is bounded by the column and opaque faces)
+     *
+     * @param chunks Dirty list (In priority order), neighbors raised above DIRTY_LEVEL_MESH are appended
+     *               (chunk_cubic_t::dirty_queued is set for every chunk in the list)
+     * @param max_chunks Stop taking chunks from the list once the number of chunks that spread (and need light) would grow beyond this
+     *                   (Ignored if deferred is NULL), seeds that a taken chunk spread into are always taken, so it may grow beyond this
+     * @param deferred Output (optional), chunks from the list that were not taken are moved here (See: max_chunks)
+     *
+     * @returns Number of chunks that spread their dirty level to their neighbors
+     */
+    static size_t propagate_dirty_levels(
+        std::vector<chunk_cubic_t*>& chunks, const size_t max_chunks = SIZE_MAX, std::vector<chunk_cubic_t*>* const deferred = NULL);
+
+    /**
+     * Takes chunks from the dirty list for lighting, the way level_t::build_dirty_meshes() does
+     *
+     * @param chunks_dirty Dirty list (In priority order), replaced with the chunks that did not fit (Still queued, in the same order)
+     * @param max_chunks See level_t::propagate_dirty_levels()
+     * @param chunks_taken Output, previous contents are discarded, taken chunks and every chunk they spread to (In light order)
+     *
+     * @returns Number of chunks that spread their dirty level to their neighbors
+     */
+    static size_t take_dirty_chunks(std::vector<chunk_cubic_t*>& chunks_dirty, const size_t max_chunks, std::vector<chunk_cubic_t*>& chunks_taken);
+
+    /**
+     * Fast-forwards chunks that light cannot enter or leave to DIRTY_LEVEL_MESH, and clears the light of chunks at DIRTY_LEVEL_LIGHT_PASS_INTERNAL
+     *
+     * chunk_cubic_t::dirty_queued is cleared for every chunk visited
+     *
+     * @param chunks Chunks in light order
+     * @param chunks_needing_light Output, chunks that still need to be lit (In light order)
+     *
+     * @returns Number of chunks cleared
+     */
+    static size_t light_clear_pass(const std::vector<chunk_cubic_t*>& chunks, std::vector<chunk_cubic_t*>& chunks_needing_light);
+
+    /**
+     * Chunks grouped into waves that can be lit in parallel, see level_t::build_light_waves()
+     */
+    struct light_waves_t
+    {
+        std::vector<chunk_cubic_t*> chunks;
+
+        /** Index of the chunk after the end of each wave */
+        std::vector<int> ends;
+    };
+
+    /**
+     * Groups chunks into waves of descending (x + y + z)
+     *
+     * @param chunks_needing_light Chunks in light order
+     */
+    static light_waves_t build_light_waves(const std::vector<chunk_cubic_t*>& chunks_needing_light);
+
+    /**
+     * Lights every chunk at dirty level lvl_in and moves them to the next dirty level
+     *
+     * @param waves Chunks to light
+     * @param lvl_in Dirty level to light
+     * @param threads Maximum number of threads to light each wave on
+     *
+     * @returns Number of chunks lit
+     */
+    static size_t light_pass(const light_waves_t& waves, const chunk_cubic_t::dirty_level_t lvl_in, const int threads);
+
+    /**
+     * Cave culling pass, flood fills outwards from origin through faces that can see each other (See chunk_cubic_t::find_face_connections())
+     *
+     * The fill never travels back against a direction it has already traveled in, so it cannot wrap around an occluder
+     *
+     * Only chunks with chunk_cubic_t::visible set are entered, afterwards chunk_cubic_t::visible is only set on chunks that were reached
+     *
+     * NOTE: Renderer hints must be up to date
+     *
+     * @param chunks Chunks to cull
+     * @param origin Chunk containing the camera
+     *
+     * @returns Number of chunks reached
+     */
+    static size_t cave_cull(const std::vector<chunk_cubic_t*>& chunks, chunk_cubic_t* const origin);
+
+    /**
+     * Everything level_t::build_mesh_from_snapshot() needs to build a mesh, gathered on the main thread
+     */
+    struct mesh_snapshot_t
+    {
+        glm::ivec3 pos = { 0, 0, 0 };
+
+        /** Value of chunk_cubic_t::mesh_generation when the snapshot was taken */
+        Uint64 generation = 0;
+
+        /** Center chunk and its neighbors (NULL if not loaded), Index: [x+1][y+1][z+1] */
+        chunk_cubic_t* rubik[3][3][3] = {};
+
+        /** If true then the chunks in rubik are copies owned by the snapshot */
+        bool owns_chunks = false;
+
+        /** Index: [x + 1][y + 1] */
+        glm::vec3 biome_colors[18][18];
+
+        texture_terrain_t* terrain = nullptr;
+
+        bool smooth_lighting = true;
+        bool biome_blend = false;
+        bool greedy_mesh = false;
+
+        ~mesh_snapshot_t();
+    };
+
+    struct mesh_queue_info_t
+    {
+        Uint32 quad_count_opaque = 0;
+        Uint32 quad_count_alpha_test = 0;
+        Uint32 quad_count_overlay = 0;
+        Uint32 quad_count_translucent = 0;
+
+        Uint32 vertex_data_size = 0;
+        void* vertex_data = nullptr;
+        void (*vertex_freefunc)(void*) = nullptr;
+
+        /** To be filled in by the upload pass */
+        SDL_GPUBuffer* vertex_buf = nullptr;
+
+        glm::ivec3 pos = { 0, 0, 0 };
+
+        /** Copied from mesh_snapshot_t::generation, the mesh is stale if this does not match chunk_cubic_t::mesh_generation */
+        Uint64 generation = 0;
+
+        void release_data();
+    };
+
+    /**
+     * Builds vertex data from a snapshot
+     *
+     * NOTE: This does not touch any level or chunk state, so it is safe to call from any thread
+     *
+     * @param snapshot Snapshot to mesh
+     * @param queue_info Output, vertex_data will be NULL if the mesh has no quads
+     */
+    static void build_mesh_from_snapshot(const mesh_snapshot_t& snapshot, mesh_queue_info_t& queue_info);
+
+    /**
+     * Returns the number of face groups (Since program start) where greedy merging changed the rasterized face coverage
+     *
+     * NOTE: Only face groups meshed with r_greedy_mesh_verify set are checked
+     */
+    static Uint64 get_greedy_mesh_mismatches();
+
     gpu::subdiv_buffer_t mesh_buffer = gpu::subdiv_buffer_t(SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ, sizeof(terrain_vertex_t) * 4, 0, 128);
 
 private:
@@ -386,75 +567,194 @@ private:
     void render_entities(SDL_GPUCommandBuffer* const command_buffer, SDL_GPURenderPass* const render_pass);
 
     /** For quick retrieval of chunks */
-    std::map<glm::ivec3, chunk_cubic_t*, ivec3_comparator_t> cmap;
+    chunk_grid_t chunk_grid;
 
     /* Render order chunks (sorted by distance to camera) (Closer first) */
     std::vector<chunk_cubic_t*> chunks_render_order;
 
+    /**
+     * Minimum corners (in blocks) of the chunks in chunks_render_order, packed for level_t::cull_chunks()
+     *
+     * Rebuilt when render_order_corners_dirty is set, which must be done whenever chunks_render_order is modified
+     */
+    struct
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+    } render_order_corners;
+    bool render_order_corners_dirty = 1;
+
+    /** Scratch space for level_t::cull_chunks() */
+    std::vector<Uint8> cull_results;
+
     /**
      * Light order chunks (Arranged in descending strips of chunks with the same XY coordinates)
      */
     std::vector<chunk_cubic_t*> chunks_light_order;
 
-    /** If set to true then level_t::chunks_render_order will be sorted, and then this bool will be cleared */
+    /** If set to true then level_t::chunks_render_order will be fully resorted, and then this bool will be cleared */
     bool request_render_order_sort = 1;
 
-    /** If set to true then level_t::chunks_light_order will be sorted, and then this bool will be cleared */
-    bool request_light_order_sort = 1;
+    /**
+     * Number of chunks at the start of chunks_render_order that are in order, anything after was added since the last sort
+     *
+     * NOTE: Removing a chunk keeps the order intact, so this only needs to be decremented when a chunk before it is removed
+     */
+    size_t render_order_num_sorted = 0;
+
+    /**
+     * Squared distance (in chunks) from last_render_order_cpos of the first render_order_num_sorted chunks in chunks_render_order
+     *
+     * See: level_t::sort_render_order()
+     */
+    std::vector<Uint32> render_order_keys;
+
+    /** Scratch space for level_t::sort_render_order() */
+    struct
+    {
+        std::vector<Uint32> histogram;
+        std::vector<Uint32> keys;
+        std::vector<chunk_cubic_t*> chunks;
+    } render_order_scratch;
+
+    /** Set by level_t::refine_render_order(), cleared whenever chunks_render_order is resorted */
+    bool render_order_refined = 0;
+    glm::vec3 last_render_order_refine_pos = { 0, 0, 0 };
+
+    /** Same as render_order_num_sorted, but for chunks_light_order */
+    size_t light_order_num_sorted = 0;
+
+    /**
+     * Chunks that had their dirty level raised (or blocks changed) since the last call to build_dirty_meshes(),
+     * along with any chunks that did not fit in the previous frame's budget
+     *
+     * See: level_t::mark_dirty()
+     */
+    std::vector<chunk_cubic_t*> chunks_dirty;
+
+    /**
+     * Shared by the light, mesh, and upload passes, restarted every frame by build_dirty_meshes()
+     *
+     * See: r_chunk_budget_ms
+     */
+    frame_budget_t chunk_budget;
+    frame_budget_t::cost_t chunk_cost_light = { 100000.0 };
+    frame_budget_t::cost_t chunk_cost_mesh = { 250000.0 };
+    frame_budget_t::cost_t chunk_cost_upload = { 20000.0 };
 
-    Uint64 last_render_order_sort_time = 0;
-    Uint64 last_light_order_sort_time = 0;
     Uint64 last_out_of_range_mesh_clear_time = 0;
 
+    /** Id of the r_render_distance change callback */
+    Uint32 cvr_render_distance_callback_id = 0;
+
     float last_cloud_height = 160.0f;
 
-    glm::i64vec3 last_render_order_cpos = { 0, 0, 0 };
+    glm::ivec3 last_render_order_cpos = { 0, 0, 0 };
 
     /**
-     * Runs the culling pass and builds all visible/near visible dirty meshes
+     * Bring chunks_render_order into order by squared chunk distance from center
      *
-     * TODO: Throttle light?
-     * TODO: Wait for either a timeout to pass or all surrounding chunks to be loaded before building
+     * If center changed since the last call (or request_render_order_sort is set) then every chunk is resorted with a counting sort,
+     * otherwise only chunks added since the last call are sorted and then merged in
+     *
+     * Chunks with the same distance are left in an arbitrary order, see level_t::refine_render_order()
      */
-    void build_dirty_meshes(const int render_distance);
+    void sort_render_order(const glm::ivec3 center);
 
     /**
-     * Propagate dirty levels between chunks (Basically light propagation)
+     * Sort the visible chunks within each distance bucket of chunks_render_order by their exact distance to the camera
+     *
+     * Lazy, nothing is done unless chunks_render_order was resorted or the camera moved a couple blocks since the last refinement
+     *
+     * NOTE: Must be called after culling, because it relies on the packed corners being up to date
      */
-    void propagate_dirty_levels();
+    void refine_render_order(const glm::vec3 camera_pos);
 
     /**
-     * Culls all chunks that are behind the camera or outside of the render distance
+     * Runs the culling pass and builds all visible/near visible dirty meshes
+     *
+     * Lighting and meshing are limited by r_chunk_budget_ms, work that does not fit is carried over to the next frame
+     *
+     * TODO: Wait for either a timeout to pass or all surrounding chunks to be loaded before building
+     */
+    void build_dirty_meshes(const int render_distance);
+
+    /**
+     * Culls all chunks that are outside of the view frustum or the render distance
      *
      * TODO: An equivalent for entities
      */
     void cull_chunks(const glm::ivec2 win_size, const int render_distance);
 
     /**
-     * Build and or replace the mesh for the corresponding chunk
+     * Projection matrix used for rendering the world (Reversed depth)
+     */
+    glm::mat4 get_mat_proj(const glm::ivec2 target_size, const int render_distance) const;
+
+    /**
+     * Camera matrix used for rendering the world (Including damage tilt)
+     */
+    glm::mat4 get_mat_cam() const;
+
+    /**
+     * Build and or replace the mesh for the corresponding chunk on the calling thread
      */
     void build_mesh(chunk_cubic_t* const chunk);
 
-    struct mesh_queue_info_t
-    {
-        Uint32 quad_count_opaque = 0;
-        Uint32 quad_count_alpha_test = 0;
-        Uint32 quad_count_overlay = 0;
-        Uint32 quad_count_translucent = 0;
+    /**
+     * Gathers the 3x3x3 neighborhood and climate data of a chunk and assigns it a new mesh generation
+     *
+     * @param center Chunk to snapshot
+     * @param copy_chunks Copy the chunk data so that the snapshot stays valid after the main thread modifies or removes chunks
+     */
+    mesh_snapshot_t* create_mesh_snapshot(chunk_cubic_t* const center, const bool copy_chunks);
 
-        Uint32 vertex_data_size = 0;
-        void* vertex_data = nullptr;
-        void (*vertex_freefunc)(void*) = nullptr;
+    std::deque<mesh_queue_info_t> mesh_queue;
 
-        /** To be filled in by the upload pass */
-        SDL_GPUBuffer* vertex_buf = nullptr;
+    /**
+     * Queues a freshly built mesh for upload, or discards it if the chunk has changed since the snapshot was taken
+     */
+    void apply_mesh_result(mesh_queue_info_t& result);
 
-        glm::ivec3 pos = { 0, 0, 0 };
+    /**
+     * Marks a chunk for remeshing if the mesh for the given generation was discarded before it could be applied
+     */
+    void mesh_result_lost(const glm::ivec3 pos, const Uint64 generation);
 
-        void release_data();
-    };
+    /** Source of chunk_cubic_t::mesh_generation values */
+    Uint64 mesh_generation_counter = 0;
 
-    std::deque<mesh_queue_info_t> mesh_queue;
+    std::vector<SDL_Thread*> mesh_workers;
+
+    /** Guards mesh_jobs_pending, mesh_jobs_done, and mesh_workers_quit */
+    SDL_Mutex* mesh_jobs_lock = SDL_CreateMutex();
+    SDL_Condition* mesh_jobs_cond = SDL_CreateCondition();
+    std::deque<mesh_snapshot_t*> mesh_jobs_pending;
+    std::vector<mesh_queue_info_t> mesh_jobs_done;
+    bool mesh_workers_quit = false;
+
+    /** Number of jobs submitted but not yet collected, only accessed by the main thread */
+    int mesh_jobs_in_flight = 0;
+
+    /**
+     * Starts or restarts the mesh workers if the requested thread count changed
+     *
+     * @returns Number of running mesh workers
+     */
+    int mesh_workers_update();
+
+    /**
+     * Stops all mesh workers, any meshes not yet collected are discarded and their chunks are marked for remeshing
+     */
+    void mesh_workers_stop();
+
+    /**
+     * Moves finished meshes from the workers to level_t::mesh_queue
+     */
+    void mesh_workers_collect();
+
+    static int mesh_worker_func(void* userdata);
 
     struct transient_indirect_buffers_t
     {
@@ -502,9 +802,23 @@ private:
     void generator_create();
     void generator_destroy();
 
+    /** Seed last applied to generator */
+    Sint64 generator_seed = 0;
+    bool generator_seeded = false;
+
+    /**
+     * Applies mc_seed to the generator, if it changed since the last call
+     */
+    void generator_apply_seed();
+
+    /** Columns produced by generate_climate_colors() */
+    climate_cache_t climate_cache;
+
     /**
      * Generates biome colors/climate values for a chunk with side strips for blending purposes
      *
+     * Results are cached per column (See r_climate_cache_size)
+     *
      * @param chunk_pos Chunk position in chunk coordinates
      * @param colors Output for color values, index: [x+1][y+1]
      * @param temperature Output for temperature values, index: [x+1][y+1]
@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "level.h"
+
+size_t level_t::cave_cull(const std::vector<chunk_cubic_t*>& chunks, chunk_cubic_t* const origin)
+{
+    for (chunk_cubic_t* c : chunks)
+        c->cave_cull_reached = 0;
+
+    struct node_t
+    {
+        chunk_cubic_t* c;
+
+        /** Face the chunk was entered through, or FACE_COUNT for the origin */
+        chunk_cubic_t::face_t entered_through;
+
+        /** Bitmask of directions (chunk_cubic_t::face_t) traveled to get here */
+        Uint8 directions;
+    };
+
+    std::vector<node_t> queue;
+    queue.reserve(chunks.size());
+
+    if (origin)
+    {
+        origin->cave_cull_reached = 1;
+        queue.push_back({ origin, chunk_cubic_t::FACE_COUNT, 0 });
+    }
+
+    /* Breadth first, so every chunk is reached by (one of) the straightest paths from the origin */
+    for (size_t i = 0; i < queue.size(); i++)
+    {
+        const node_t node = queue[i];
+        const Uint16 connections = node.c->renderer_hints.face_connections;
+
+        for (int it = 0; it < chunk_cubic_t::FACE_COUNT; it++)
+        {
+            const chunk_cubic_t::face_t face = chunk_cubic_t::face_t(it);
+
+            /* Never go back */
+            if (node.directions & (1 << chunk_cubic_t::face_opposite(face)))
+                continue;
+
+            /* The camera can be anywhere inside the origin, so only chunks after the first one have to be seen through */
+            if (node.entered_through != chunk_cubic_t::FACE_COUNT)
+            {
+                if (face == node.entered_through || !(connections & chunk_cubic_t::face_pair_bit(node.entered_through, face)))
+                    continue;
+            }
+
+            const int* offset = chunk_cubic_t::face_offsets[face];
+            chunk_cubic_t* const next = node.c->neighborhood[offset[0] + 1][offset[1] + 1][offset[2] + 1];
+
+            if (!next || next->cave_cull_reached || !next->visible)
+                continue;
+
+            next->cave_cull_reached = 1;
+            queue.push_back({ next, chunk_cubic_t::face_opposite(face), Uint8(node.directions | (1 << face)) });
+        }
+    }
+
+    for (chunk_cubic_t* c : chunks)
+        c->visible = c->cave_cull_reached;
+
+    return queue.size();
+}
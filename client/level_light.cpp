@@ -0,0 +1,532 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "level.h"
+
+#include <algorithm>
+
+#include "tetra/util/convar.h"
+
+static convar_int_t r_light_incremental {
+    "r_light_incremental",
+    1,
+    0,
+    1,
+    "Relight single block changes with a flood fill from the changed block instead of relighting every surrounding chunk",
+    CONVAR_FLAG_SAVE | CONVAR_FLAG_INT_IS_BOOL,
+};
+
+/**
+ * Marks every chunk whose mesh reads the provided voxel for a mesh rebuild
+ */
+static void mark_mesh_dirty(chunk_cubic_t* const c, const glm::ivec3 block_pos)
+{
+    const glm::ivec3 lo(block_pos.x == 0 ? -1 : 0, block_pos.y == 0 ? -1 : 0, block_pos.z == 0 ? -1 : 0);
+    const glm::ivec3 hi(block_pos.x == SUBCHUNK_SIZE_X - 1 ? 1 : 0, block_pos.y == SUBCHUNK_SIZE_Y - 1 ? 1 : 0, block_pos.z == SUBCHUNK_SIZE_Z - 1 ? 1 : 0);
+
+    /* Meshes sample the surrounding 3x3x3 chunks for culling, ambient occlusion, and smooth lighting */
+    for (int x = lo.x; x <= hi.x; x++)
+        for (int y = lo.y; y <= hi.y; y++)
+            for (int z = lo.z; z <= hi.z; z++)
+            {
+                chunk_cubic_t* t = chunk_cubic_t::find_chunk(c, c->pos + glm::ivec3(x, y, z));
+                if (t && t->dirty_level < chunk_cubic_t::DIRTY_LEVEL_MESH)
+                    t->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
+            }
+}
+
+namespace
+{
+enum light_channel_t
+{
+    LIGHT_CHANNEL_BLOCK,
+    LIGHT_CHANNEL_SKY,
+};
+
+struct light_node_t
+{
+    chunk_cubic_t* c;
+    int x, y, z;
+    /** Light level the node had when it was queued (Only used by the removal queue) */
+    int level;
+};
+
+/**
+ * Flood fill light updater
+ *
+ * The propagation rules are the same ones used by the chunk_cubic_t::light_pass_*() functions, so the result
+ * is the fixed point that repeated full passes would converge to, restricted to the voxels the change can reach.
+ *
+ * Nodes only cross into loaded neighbors (chunk_cubic_t::neighbors), just like the full passes.
+ */
+struct light_flood_t
+{
+    const light_channel_t channel;
+
+    std::vector<light_node_t> queue_remove;
+    std::vector<light_node_t> queue_add;
+
+    size_t touched = 0;
+
+    light_flood_t(const light_channel_t _channel)
+        : channel(_channel)
+    {
+    }
+
+    inline int get(const light_node_t& n) const
+    {
+        return (channel == LIGHT_CHANNEL_SKY) ? n.c->get_light_sky(n.x, n.y, n.z) : n.c->get_light_block(n.x, n.y, n.z);
+    }
+
+    /**
+     * Sets a light level without triggering a full relight of the chunk (chunk_cubic_t::set_light_*() mark the chunk as such)
+     */
+    inline void set(const light_node_t& n, const int level)
+    {
+        const chunk_cubic_t::dirty_level_t dirty_level = n.c->dirty_level;
+        if (channel == LIGHT_CHANNEL_SKY)
+            n.c->set_light_sky(n.x, n.y, n.z, level);
+        else
+            n.c->set_light_block(n.x, n.y, n.z, level);
+        n.c->dirty_level = dirty_level;
+
+        mark_mesh_dirty(n.c, glm::ivec3(n.x, n.y, n.z));
+        touched++;
+    }
+
+    /**
+     * Light a voxel emits on it's own, regardless of it's neighbors
+     */
+    inline int source(const light_node_t& n) const
+    {
+        const block_id_t type = n.c->get_type(n.x, n.y, n.z);
+        if (channel == LIGHT_CHANNEL_BLOCK)
+            return mc_id::block_properties.light_level[type];
+
+        if (n.y == SUBCHUNK_SIZE_Y - 1 && !n.c->neighbors.pos_y && mc_id::block_properties.transparent[type])
+            return 15;
+        return 0;
+    }
+
+    /**
+     * Get a face neighbor of a node
+     *
+     * @param dir Direction index: +XYZ -XYZ
+     *
+     * @returns false if the neighbor lies in a chunk that is not loaded
+     */
+    static inline bool step(const light_node_t& n, const int dir, light_node_t& out)
+    {
+        out = n;
+        out.level = 0;
+        switch (dir)
+        {
+        case 0:
+            if (++out.x < SUBCHUNK_SIZE_X)
+                return true;
+            out.x = 0;
+            out.c = n.c->neighbors.pos_x;
+            break;
+        case 1:
+            if (++out.y < SUBCHUNK_SIZE_Y)
+                return true;
+            out.y = 0;
+            out.c = n.c->neighbors.pos_y;
+            break;
+        case 2:
+            if (++out.z < SUBCHUNK_SIZE_Z)
+                return true;
+            out.z = 0;
+            out.c = n.c->neighbors.pos_z;
+            break;
+        case 3:
+            if (--out.x >= 0)
+                return true;
+            out.x = SUBCHUNK_SIZE_X - 1;
+            out.c = n.c->neighbors.neg_x;
+            break;
+        case 4:
+            if (--out.y >= 0)
+                return true;
+            out.y = SUBCHUNK_SIZE_Y - 1;
+            out.c = n.c->neighbors.neg_y;
+            break;
+        default:
+            if (--out.z >= 0)
+                return true;
+            out.z = SUBCHUNK_SIZE_Z - 1;
+            out.c = n.c->neighbors.neg_z;
+            break;
+        }
+        return out.c != NULL;
+    }
+
+    /**
+     * Light that a voxel at level `level` contributes to it's neighbor in direction `dir`
+     */
+    inline int contribution(const int level, const int dir, const light_node_t& to) const
+    {
+        /* Sky light traveling downwards is attenuated by the receiving block instead (See chunk_cubic_t::light_pass_sky_propagate_internals()) */
+        if (channel == LIGHT_CHANNEL_SKY && dir == 4)
+            return level - mc_id::block_properties.light_opacity[to.c->get_type(to.x, to.y, to.z)];
+        return level - 1;
+    }
+
+    /**
+     * Removes light that may have depended on the voxel at `origin`, then re-propagates from the remaining sources
+     */
+    void update(const light_node_t& origin)
+    {
+        const mc_id::block_bitset_t& is_transparent = mc_id::block_properties.transparent;
+
+        queue_remove.clear();
+        queue_add.clear();
+
+        /* Phase 1: Remove everything the old value of the origin could have lit */
+        light_node_t o = origin;
+        o.level = get(o);
+        if (o.level)
+        {
+            set(o, 0);
+            queue_remove.push_back(o);
+        }
+
+        for (size_t i = 0; i < queue_remove.size(); i++)
+        {
+            const light_node_t v = queue_remove[i];
+            for (int dir = 0; dir < 6; dir++)
+            {
+                light_node_t n;
+                if (!step(v, dir, n))
+                    continue;
+
+                n.level = get(n);
+                if (!n.level)
+                    continue;
+
+                /* Opaque blocks only ever hold their own emission */
+                if (!is_transparent[n.c->get_type(n.x, n.y, n.z)])
+                {
+                    queue_add.push_back(n);
+                    continue;
+                }
+
+                if (n.level > contribution(v.level, dir, n))
+                {
+                    /* Lit by something else, so it gets to re-fill the hole */
+                    queue_add.push_back(n);
+                    continue;
+                }
+
+                set(n, 0);
+                queue_remove.push_back(n);
+
+                const int src = source(n);
+                if (src)
+                {
+                    set(n, src);
+                    queue_add.push_back(n);
+                }
+            }
+        }
+
+        /* Phase 2: Seed the origin with it's new value, and let the neighbors flow back into it */
+        const int src = source(origin);
+        if (src > get(origin))
+            set(origin, src);
+        queue_add.push_back(origin);
+
+        for (int dir = 0; dir < 6; dir++)
+        {
+            light_node_t n;
+            if (step(origin, dir, n) && get(n))
+                queue_add.push_back(n);
+        }
+
+        /* Phase 3: Propagate (Stale entries are harmless, a node only spreads what it currently holds) */
+        for (size_t i = 0; i < queue_add.size(); i++)
+        {
+            const light_node_t v = queue_add[i];
+            const int level = get(v);
+            if (!level)
+                continue;
+
+            for (int dir = 0; dir < 6; dir++)
+            {
+                light_node_t n;
+                if (!step(v, dir, n))
+                    continue;
+                if (!is_transparent[n.c->get_type(n.x, n.y, n.z)])
+                    continue;
+
+                const int contrib = contribution(level, dir, n);
+                if (contrib > get(n))
+                {
+                    set(n, contrib);
+                    queue_add.push_back(n);
+                }
+            }
+        }
+    }
+};
+}
+
+bool level_t::relight_block(chunk_cubic_t* const c, const glm::ivec3 block_pos)
+{
+    if (!r_light_incremental.get())
+        return false;
+
+    const light_node_t origin = { c, block_pos.x, block_pos.y, block_pos.z, 0 };
+
+    /* chunk_cubic_t::set_type() marked the chunk for a full relight, which this replaces */
+    c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
+
+    /* The block itself changed, so neighboring meshes need to see the new type even if no light does */
+    mark_mesh_dirty(c, block_pos);
+
+    light_flood_t flood_block(LIGHT_CHANNEL_BLOCK);
+    flood_block.update(origin);
+
+    light_flood_t flood_sky(LIGHT_CHANNEL_SKY);
+    flood_sky.update(origin);
+
+    TRACE("Relit <%d, %d, %d>: %zu block light writes, %zu sky light writes", c->pos.x * SUBCHUNK_SIZE_X + block_pos.x,
+        c->pos.y * SUBCHUNK_SIZE_Y + block_pos.y, c->pos.z * SUBCHUNK_SIZE_Z + block_pos.z, flood_block.touched, flood_sky.touched);
+
+    return true;
+}
+
+void level_t::sort_light_order(std::vector<chunk_cubic_t*>& chunks, const size_t num_sorted)
+{
+    if (num_sorted >= chunks.size())
+        return;
+
+    auto cmp = [](const chunk_cubic_t* const a, const chunk_cubic_t* const b) {
+        if (a->pos.x > b->pos.x)
+            return true;
+        if (a->pos.x < b->pos.x)
+            return false;
+        if (a->pos.z > b->pos.z)
+            return true;
+        if (a->pos.z < b->pos.z)
+            return false;
+        return a->pos.y > b->pos.y;
+    };
+
+    /* Only the new chunks need a full sort, which keeps a trickle of new chunks from costing a full O(n log n) sort each time */
+    std::sort(chunks.begin() + num_sorted, chunks.end(), cmp);
+    std::inplace_merge(chunks.begin(), chunks.begin() + num_sorted, chunks.end(), cmp);
+}
+
+size_t level_t::propagate_dirty_levels(std::vector<chunk_cubic_t*>& chunks, const size_t max_chunks, std::vector<chunk_cubic_t*>* const deferred)
+{
+    size_t propagated = 0;
+
+    for (chunk_cubic_t* c : chunks)
+        c->dirty_queued = 1;
+
+    const size_t num_seeds = chunks.size();
+    const size_t limit = deferred ? max_chunks : SIZE_MAX;
+
+    /* Seeds are taken whole (along with everything they spread to), the first one is always taken so that work cannot stall.
+     * Only chunks that spread need light, so those are counted (Including seeds further down the list that a taken seed raised),
+     * and a seed is only taken if the largest closure so far would still fit, so that the last seed does not overshoot the limit by a whole closure */
+    size_t seed_it = 0;
+    size_t num_spread = 0;
+    size_t closure_max = 1;
+    std::vector<chunk_cubic_t*> queue;
+    for (; seed_it < num_seeds && (seed_it == 0 || num_spread + closure_max <= limit); seed_it++)
+    {
+        if (chunks[seed_it]->dirty_level <= chunk_cubic_t::DIRTY_LEVEL_MESH)
+            continue;
+
+        const size_t num_spread_before = num_spread;
+
+        queue.clear();
+        queue.push_back(chunks[seed_it]);
+
+        /* Chunks are requeued whenever their dirty level is raised again, which reaches the same fixed point repeated sweeps would */
+        for (size_t i = 0; i < queue.size(); i++)
+        {
+            chunk_cubic_t* c = queue[i];
+            if (c->dirty_level <= chunk_cubic_t::DIRTY_LEVEL_MESH)
+                continue;
+
+            num_spread += !c->dirty_spread;
+            c->dirty_spread = 1;
+            chunk_cubic_t::dirty_level_t adj_dirt_level = chunk_cubic_t::dirty_level_t(c->dirty_level - 1);
+
+            assert(adj_dirt_level != chunk_cubic_t::DIRTY_LEVEL_NONE);
+
+#define ASSIGN_DIRT_LVL_IF(WHO, LVL, COND)             \
+    if ((WHO) && (COND) && (WHO)->dirty_level < (LVL)) \
+    {                                                  \
+        (WHO)->dirty_level = (LVL);                    \
+        if ((LVL) > chunk_cubic_t::DIRTY_LEVEL_MESH)   \
+            queue.push_back(WHO);                      \
+        if (!(WHO)->dirty_queued)                      \
+        {                                              \
+            (WHO)->dirty_queued = 1;                   \
+            chunks.push_back(WHO);                     \
+        }                                              \
+    }
+            ASSIGN_DIRT_LVL_IF(c->neighbors.pos_x, adj_dirt_level, !c->renderer_hints.opaque_face_pos_x);
+            ASSIGN_DIRT_LVL_IF(c->neighbors.pos_y, adj_dirt_level, !c->renderer_hints.opaque_face_pos_y);
+            ASSIGN_DIRT_LVL_IF(c->neighbors.pos_z, adj_dirt_level, !c->renderer_hints.opaque_face_pos_z);
+            ASSIGN_DIRT_LVL_IF(c->neighbors.neg_x, adj_dirt_level, !c->renderer_hints.opaque_face_neg_x);
+            ASSIGN_DIRT_LVL_IF(c->neighbors.neg_y, c->dirty_level, !c->renderer_hints.opaque_face_neg_y);
+            ASSIGN_DIRT_LVL_IF(c->neighbors.neg_z, adj_dirt_level, !c->renderer_hints.opaque_face_neg_z);
+#undef ASSIGN_DIRT_LVL_IF
+
+            propagated++;
+        }
+
+        closure_max = SDL_max(closure_max, num_spread - num_spread_before);
+    }
+
+    /* A taken seed may have raised a seed that was not taken, which then already spread its dirty level and has to be lit with the rest */
+    if (seed_it < num_seeds)
+        seed_it = std::stable_partition(chunks.begin() + seed_it, chunks.begin() + num_seeds, [](const chunk_cubic_t* const c) { return c->dirty_spread; })
+            - chunks.begin();
+
+    /* Seeds that did not fit are handed back, chunk_cubic_t::dirty_queued stays set since they are still queued */
+    if (seed_it < num_seeds)
+    {
+        deferred->insert(deferred->end(), chunks.begin() + seed_it, chunks.begin() + num_seeds);
+        chunks.erase(chunks.begin() + seed_it, chunks.begin() + num_seeds);
+    }
+
+    for (chunk_cubic_t* c : chunks)
+        c->dirty_spread = 0;
+
+    return propagated;
+}
+
+size_t level_t::take_dirty_chunks(std::vector<chunk_cubic_t*>& chunks_dirty, const size_t max_chunks, std::vector<chunk_cubic_t*>& chunks_taken)
+{
+    chunks_taken.clear();
+    chunks_taken.swap(chunks_dirty);
+
+    const size_t propagated = propagate_dirty_levels(chunks_taken, max_chunks, &chunks_dirty);
+    sort_light_order(chunks_taken);
+
+    return propagated;
+}
+
+size_t level_t::light_clear_pass(const std::vector<chunk_cubic_t*>& chunks, std::vector<chunk_cubic_t*>& chunks_needing_light)
+{
+    size_t cleared = 0;
+
+    for (chunk_cubic_t* c : chunks)
+    {
+        c->dirty_queued = 0;
+
+        /* Fast-forward cull pass */
+        if (BETWEEN_INCL(c->dirty_level, chunk_cubic_t::DIRTY_LEVEL_MESH, chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_0))
+        {
+            bool light_can_leave = c->can_light_leave();
+            if (c->renderer_hints.opaque_sides || !light_can_leave)
+                c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
+            if (c->renderer_hints.uniform_opaque)
+            {
+                c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
+
+                if (!light_can_leave)
+                    c->free_renderer_resources(chunk_cubic_t::DIRTY_LEVEL_NONE);
+            }
+        }
+
+        if (c->dirty_level > chunk_cubic_t::DIRTY_LEVEL_MESH)
+            chunks_needing_light.push_back(c);
+
+        /* Clear Light Pass */
+        if (c->dirty_level != chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL)
+            continue;
+        c->clear_light_block(0);
+        c->light_pass_block_setup();
+        c->clear_light_sky(0);
+        cleared++;
+    }
+
+    return cleared;
+}
+
+/* Light passes only read the face neighbors of a chunk and only write to the chunk itself, and face neighbors always have position sums
+ * that differ by exactly one, with the larger sum coming first in light order. So walking the chunks in waves of descending
+ * (x + y + z) lets every chunk see its neighbors exactly as it would when walking the chunks in light order serially, and the chunks
+ * of one wave can be split across threads without changing the result */
+level_t::light_waves_t level_t::build_light_waves(const std::vector<chunk_cubic_t*>& chunks_needing_light)
+{
+    light_waves_t waves;
+
+#define POS_SUM(C) ((C)->pos.x + (C)->pos.y + (C)->pos.z)
+    waves.chunks = chunks_needing_light;
+    std::stable_sort(waves.chunks.begin(), waves.chunks.end(), [](const chunk_cubic_t* const a, const chunk_cubic_t* const b) { return POS_SUM(a) > POS_SUM(b); });
+
+    for (int i = 1; i <= int(waves.chunks.size()); i++)
+        if (i == int(waves.chunks.size()) || POS_SUM(waves.chunks[i]) != POS_SUM(waves.chunks[i - 1]))
+            waves.ends.push_back(i);
+#undef POS_SUM
+
+    return waves;
+}
+
+size_t level_t::light_pass(const light_waves_t& waves, const chunk_cubic_t::dirty_level_t lvl_in, const int threads)
+{
+    SDL_AtomicInt lit = { 0 };
+
+    auto light_range = [&](const int _start, const int _end) {
+        int num_lit = 0;
+        for (int i = _start; i < _end; i++)
+        {
+            chunk_cubic_t* c = waves.chunks[i];
+            if (c->dirty_level != lvl_in)
+                continue;
+            c->light_pass_block_grab_from_neighbors();
+            c->light_pass_block_propagate_internals();
+            c->light_pass_sky_grab_from_neighbors();
+            c->light_pass_sky_propagate_internals();
+            if (lvl_in != chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_1)
+                c->dirty_level = chunk_cubic_t::dirty_level_t(lvl_in - 1);
+            else if (c->renderer_hints.uniform_air)
+                c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_NONE;
+            else
+                c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_MESH;
+            num_lit++;
+        }
+        SDL_AddAtomicInt(&lit, num_lit);
+    };
+
+    int wave_start = 0;
+    for (const int wave_end : waves.ends)
+    {
+        /* Spawning threads isn't free, so small waves are lit on the calling thread */
+        const int wave_threads = SDL_min(threads, (wave_end - wave_start) / 4);
+        if (wave_threads > 1)
+            util::parallel_for(wave_start, wave_end, light_range, wave_threads);
+        else
+            light_range(wave_start, wave_end);
+        wave_start = wave_end;
+    }
+
+    return SDL_GetAtomicInt(&lit);
+}
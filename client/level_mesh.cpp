@@ -54,6 +54,33 @@ static convar_int_t cvr_r_biome_oversample {
     CONVAR_FLAG_SAVE,
 };
 
+static convar_int_t cvr_r_climate_cache_size {
+    "r_climate_cache_size",
+    2048,
+    0,
+    65536,
+    "Maximum number of chunk columns to keep biome colors for (0 disables caching)",
+    CONVAR_FLAG_SAVE,
+};
+
+static convar_int_t cvr_r_greedy_mesh {
+    "r_greedy_mesh",
+    0,
+    0,
+    1,
+    "Merge identical coplanar opaque and alpha tested block faces into larger quads (Needs shaders built from the current sources)",
+    CONVAR_FLAG_SAVE | CONVAR_FLAG_INT_IS_BOOL,
+};
+
+static convar_int_t cvr_r_greedy_mesh_verify {
+    "r_greedy_mesh_verify",
+    0,
+    0,
+    1,
+    "Compare the block face coverage of every face group before and after greedy merging",
+    CONVAR_FLAG_INT_IS_BOOL | CONVAR_FLAG_DEV_ONLY,
+};
+
 #if (FORCE_OPT_MESH)
 #pragma GCC push_options
 #pragma GCC optimize("Og")
@@ -106,9 +133,371 @@ private:
     T _data[array_size];
 };
 
+static std::atomic<Uint64> greedy_mesh_mismatches = { 0 };
+
+/**
+ * Block aligned rectangle of a quad, as decoded by decode_face_rect()
+ */
+struct face_rect_t
+{
+    /** Position along the face normal (in blocks) */
+    int plane;
+
+    /** Position and size along the in plane axes (in blocks) */
+    int a, b, w, h;
+
+    /** In plane corner of each vertex (Bit 0: a, Bit 1: b) */
+    Uint8 corners[4];
+};
+
+/**
+ * Gets the axes of a face direction (0: X, 1: Y, 2: Z)
+ *
+ * @returns false if the mesh id does not have a single face direction
+ */
+static bool get_face_axes(const mesh_id_t id, int& axis_n, int& axis_a, int& axis_b)
+{
+    switch (id)
+    {
+    case MESH_ID_POS_X:
+    case MESH_ID_NEG_X:
+        axis_n = 0, axis_a = 2, axis_b = 1;
+        return true;
+    case MESH_ID_POS_Y:
+    case MESH_ID_NEG_Y:
+        axis_n = 1, axis_a = 0, axis_b = 2;
+        return true;
+    case MESH_ID_POS_Z:
+    case MESH_ID_NEG_Z:
+        axis_n = 2, axis_a = 0, axis_b = 1;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Decodes a quad as a block aligned rectangle inside the chunk
+ *
+ * @param quad Pointer to the 4 vertices of the quad
+ * @param id Face direction of the quad
+ * @param out Output
+ *
+ * @returns true if the quad is an axis aligned rectangle on block boundaries
+ */
+static bool decode_face_rect(const terrain_vertex_t* const quad, const mesh_id_t id, face_rect_t& out)
+{
+    int axis_n, axis_a, axis_b;
+    if (!get_face_axes(id, axis_n, axis_a, axis_b))
+        return false;
+
+    /* Positions are in 1/16ths of a block, bit 0 is skipped because of FLAG_TILED */
+    int pos[4][3];
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 3; j++)
+            pos[i][j] = int((quad[i].pos.dat >> (1 + j * 10)) & 0x1FF) - 128;
+
+    int min_a = pos[0][axis_a], max_a = pos[0][axis_a];
+    int min_b = pos[0][axis_b], max_b = pos[0][axis_b];
+    for (int i = 1; i < 4; i++)
+    {
+        min_a = SDL_min(min_a, pos[i][axis_a]), max_a = SDL_max(max_a, pos[i][axis_a]);
+        min_b = SDL_min(min_b, pos[i][axis_b]), max_b = SDL_max(max_b, pos[i][axis_b]);
+    }
+
+    if ((pos[0][axis_n] & 15) || (min_a & 15) || (min_b & 15) || (max_a & 15) || (max_b & 15))
+        return false;
+
+    out.plane = pos[0][axis_n] / 16;
+    out.a = min_a / 16, out.w = (max_a - min_a) / 16;
+    out.b = min_b / 16, out.h = (max_b - min_b) / 16;
+
+    if (out.plane < 0 || out.plane > 16 || out.a < 0 || out.b < 0 || out.w < 1 || out.h < 1 || out.a + out.w > 16 || out.b + out.h > 16)
+        return false;
+
+    int seen = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (pos[i][axis_n] != pos[0][axis_n])
+            return false;
+
+        const bool corner_a = pos[i][axis_a] == max_a;
+        const bool corner_b = pos[i][axis_b] == max_b;
+        if ((!corner_a && pos[i][axis_a] != min_a) || (!corner_b && pos[i][axis_b] != min_b))
+            return false;
+
+        out.corners[i] = corner_a | (corner_b << 1);
+        seen |= 1 << out.corners[i];
+    }
+
+    return seen == 0x0F;
+}
+
+/**
+ * Checks if a face can be tiled by the terrain shader
+ *
+ * This requires uniform coloring, lighting, and AO, and a texture rectangle whose axes each follow one of the in plane axes
+ */
+static bool is_face_tileable(const terrain_vertex_t* const quad, const face_rect_t& face)
+{
+    for (int i = 1; i < 4; i++)
+        if (quad[i].col.dat != quad[0].col.dat || (quad[i].pos.dat >> 30) != (quad[0].pos.dat >> 30))
+            return false;
+
+    Uint16 u_min = 0xFFFF, u_max = 0, v_min = 0xFFFF, v_max = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        const Uint16 u = quad[i].tex.dat & 0xFFFF, v = quad[i].tex.dat >> 16;
+        u_min = SDL_min(u_min, u), u_max = SDL_max(u_max, u);
+        v_min = SDL_min(v_min, v), v_max = SDL_max(v_max, v);
+    }
+
+    if (u_min == u_max || v_min == v_max)
+        return false;
+
+    /** Index: [texture axis][in plane axis][flipped] */
+    bool follows[2][2][2] = { { { true, true }, { true, true } }, { { true, true }, { true, true } } };
+    for (int i = 0; i < 4; i++)
+    {
+        const Uint16 u = quad[i].tex.dat & 0xFFFF, v = quad[i].tex.dat >> 16;
+        if ((u != u_min && u != u_max) || (v != v_min && v != v_max))
+            return false;
+
+        const bool tex_corner[2] = { u == u_max, v == v_max };
+        const bool plane_corner[2] = { bool(face.corners[i] & 1), bool(face.corners[i] & 2) };
+        for (int t = 0; t < 2; t++)
+            for (int p = 0; p < 2; p++)
+                follows[t][p][0] &= tex_corner[t] == plane_corner[p], follows[t][p][1] &= tex_corner[t] != plane_corner[p];
+    }
+
+    const bool u_a = follows[0][0][0] || follows[0][0][1], u_b = follows[0][1][0] || follows[0][1][1];
+    const bool v_a = follows[1][0][0] || follows[1][0][1], v_b = follows[1][1][0] || follows[1][1][1];
+
+    return (u_a && v_b) || (u_b && v_a);
+}
+
+/**
+ * Rasterizes the block aligned rectangles of a face group at block resolution
+ *
+ * @param quads Face group
+ * @param id Face direction of quads
+ * @param coverage Output, number of rectangles covering each cell, Index: [plane][b][a]
+ * @param coloring Output, sum of the coloring of the rectangles covering each cell, Index: [plane][b][a]
+ */
+static void rasterize_face_rects(const ImVector<terrain_vertex_t>& quads, const mesh_id_t id, int (&coverage)[17][16][16], Uint64 (&coloring)[17][16][16])
+{
+    memset(coverage, 0, sizeof(coverage));
+    memset(coloring, 0, sizeof(coloring));
+
+    face_rect_t face;
+    for (int i = 0; i + 3 < quads.size(); i += 4)
+    {
+        if (!decode_face_rect(quads.Data + i, id, face))
+            continue;
+        for (int b = face.b; b < face.b + face.h; b++)
+            for (int a = face.a; a < face.a + face.w; a++)
+                coverage[face.plane][b][a]++, coloring[face.plane][b][a] += quads[i].col.dat;
+    }
+}
+
+/**
+ * Greedily merges coplanar single block faces into larger quads
+ *
+ * Faces are only merged if they share their coloring, lighting, AO, and texture coordinates,
+ * merged quads are marked with terrain_vertex_t::vtx_pos_ao_t::FLAG_TILED so that the shader repeats the texture once per block
+ *
+ * @param quads Face group to merge (Modified in place)
+ * @param overlay Overlay quads of the same direction, faces under an overlay are left alone so that the depth values stay identical
+ * @param id Face direction of quads
+ */
+static void merge_cube_faces(ImVector<terrain_vertex_t>& quads, const ImVector<terrain_vertex_t>& overlay, const mesh_id_t id)
+{
+    int axis[3];
+    if (quads.size() < 8 || !get_face_axes(id, axis[0], axis[1], axis[2]))
+        return;
+
+    const bool verify = cvr_r_greedy_mesh_verify.get();
+    static thread_local int verify_coverage[2][17][16][16];
+    static thread_local Uint64 verify_coloring[2][17][16][16];
+    if (verify)
+        rasterize_face_rects(quads, id, verify_coverage[0], verify_coloring[0]);
+
+    face_rect_t face;
+
+    /** Index: [plane][b][a] */
+    bool blocked[17][16][16] = {};
+    for (int i = 0; i + 3 < overlay.size(); i += 4)
+        if (decode_face_rect(overlay.Data + i, id, face))
+            for (int b = face.b; b < face.b + face.h; b++)
+                for (int a = face.a; a < face.a + face.w; a++)
+                    blocked[face.plane][b][a] = true;
+
+    /** Index of the face occupying each cell, or -1, Index: [plane][b][a] */
+    int grid[17][16][16];
+    memset(grid, -1, sizeof(grid));
+
+    ImVector<face_rect_t> faces;
+    faces.resize(quads.size() / 4);
+
+    ImVector<terrain_vertex_t> out;
+    out.reserve(quads.size());
+
+    for (int i = 0; i < faces.size(); i++)
+    {
+        const terrain_vertex_t* const quad = quads.Data + i * 4;
+        face_rect_t& f = faces[i];
+        if (!decode_face_rect(quad, id, f) || f.w != 1 || f.h != 1 || blocked[f.plane][f.b][f.a] || grid[f.plane][f.b][f.a] != -1
+            || !is_face_tileable(quad, f))
+        {
+            for (int j = 0; j < 4; j++)
+                out.push_back(quad[j]);
+            continue;
+        }
+        grid[f.plane][f.b][f.a] = i;
+    }
+
+    for (int plane = 0; plane < 17; plane++)
+    {
+        bool used[16][16] = {};
+        for (int b = 0; b < 16; b++)
+        {
+            for (int a = 0; a < 16; a++)
+            {
+                const int first = grid[plane][b][a];
+                if (first < 0 || used[b][a])
+                    continue;
+
+                const terrain_vertex_t* const quad = quads.Data + first * 4;
+
+                auto mergeable = [&](const int a2, const int b2) -> bool {
+                    const int idx = grid[plane][b2][a2];
+                    if (idx < 0 || used[b2][a2])
+                        return false;
+                    const terrain_vertex_t* const other = quads.Data + idx * 4;
+                    if (other[0].col.dat != quad[0].col.dat || (other[0].pos.dat >> 30) != (quad[0].pos.dat >> 30))
+                        return false;
+                    for (int j = 0; j < 4; j++)
+                        if (faces[idx].corners[j] != faces[first].corners[j] || other[j].tex.dat != quad[j].tex.dat)
+                            return false;
+                    return true;
+                };
+
+                int w = 1;
+                while (a + w < 16 && mergeable(a + w, b))
+                    w++;
+
+                int h = 1;
+                while (b + h < 16)
+                {
+                    bool row = true;
+                    for (int i = 0; row && i < w; i++)
+                        row = mergeable(a + i, b + h);
+                    if (!row)
+                        break;
+                    h++;
+                }
+
+                for (int j = 0; j < h; j++)
+                    for (int i = 0; i < w; i++)
+                        used[b + j][a + i] = true;
+
+                if (w == 1 && h == 1)
+                {
+                    for (int j = 0; j < 4; j++)
+                        out.push_back(quad[j]);
+                    continue;
+                }
+
+                for (int j = 0; j < 4; j++)
+                {
+                    terrain_vertex_t vtx = quad[j];
+
+                    int pos[3];
+                    pos[axis[0]] = plane * 16;
+                    pos[axis[1]] = (a + ((faces[first].corners[j] & 1) ? w : 0)) * 16;
+                    pos[axis[2]] = (b + ((faces[first].corners[j] & 2) ? h : 0)) * 16;
+
+                    vtx.pos.dat = (vtx.pos.dat & 0xC0000000) | terrain_vertex_t::vtx_pos_ao_t::FLAG_TILED;
+                    for (int k = 0; k < 3; k++)
+                        vtx.pos.dat |= Uint32(pos[k] + 128) << (1 + k * 10);
+
+                    out.push_back(vtx);
+                }
+            }
+        }
+    }
+
+    quads.swap(out);
+
+    if (verify)
+    {
+        rasterize_face_rects(quads, id, verify_coverage[1], verify_coloring[1]);
+        if (memcmp(verify_coverage[0], verify_coverage[1], sizeof(verify_coverage[0]))
+            || memcmp(verify_coloring[0], verify_coloring[1], sizeof(verify_coloring[0])))
+        {
+            dc_log_error("Greedy merging changed the face coverage of mesh id %d", id);
+            greedy_mesh_mismatches++;
+        }
+    }
+}
+
+level_t::mesh_snapshot_t::~mesh_snapshot_t()
+{
+    if (!owns_chunks)
+        return;
+
+    for (int i = 0; i < 27; i++)
+        delete rubik[i / 9][(i / 3) % 3][i % 3];
+}
+
+/**
+ * Copies the block, light, and metadata of a chunk (Neighbors, hints, and renderer resources are not copied)
+ */
+static chunk_cubic_t* copy_chunk_data(const chunk_cubic_t* const src)
+{
+    if (!src)
+        return NULL;
+
+    chunk_cubic_t* c = new chunk_cubic_t();
+    c->pos = src->pos;
+    memcpy(c->data_block, src->data_block, sizeof(c->data_block));
+    memcpy(c->data_light_block, src->data_light_block, sizeof(c->data_light_block));
+    memcpy(c->data_light_sky, src->data_light_sky, sizeof(c->data_light_sky));
+    memcpy(c->data_metadata, src->data_metadata, sizeof(c->data_metadata));
+    return c;
+}
+
+level_t::mesh_snapshot_t* level_t::create_mesh_snapshot(chunk_cubic_t* const center, const bool copy_chunks)
+{
+    mesh_snapshot_t* snapshot = new mesh_snapshot_t();
+
+    for (int i = 0; i < 27; i++)
+    {
+        chunk_cubic_t* c = center->neighborhood[i / 9][(i / 3) % 3][i % 3];
+        snapshot->rubik[i / 9][(i / 3) % 3][i % 3] = copy_chunks ? copy_chunk_data(c) : c;
+    }
+    snapshot->owns_chunks = copy_chunks;
+
+    /* Climate generation shares level_t::generator, so it must happen here instead of on the mesh workers */
+    float biome_temperature[18][18];
+    float biome_downfall[18][18];
+    generate_climate_colors(center->pos, snapshot->biome_colors, biome_temperature, biome_downfall);
+
+    snapshot->pos = center->pos;
+    snapshot->terrain = terrain;
+    snapshot->smooth_lighting = cvr_r_smooth_lighting.get();
+    snapshot->biome_blend = cvr_r_biome_oversample.get();
+    snapshot->greedy_mesh = cvr_r_greedy_mesh.get();
+
+    center->mesh_generation = ++mesh_generation_counter;
+    snapshot->generation = center->mesh_generation;
+
+    return snapshot;
+}
+
+#ifndef MCS_B181_CLIENT_HEADLESS
 void level_t::build_mesh(chunk_cubic_t* const center)
 {
-    Uint64 start_ns = SDL_GetTicksNS();
     if (!center)
     {
         dc_log_error("Attempt made to mesh NULL chunk");
@@ -121,35 +510,77 @@ void level_t::build_mesh(chunk_cubic_t* const center)
         return;
     }
 
-    const int chunk_x = center->pos.x;
-    const int chunk_y = center->pos.y;
-    const int chunk_z = center->pos.z;
+    mesh_snapshot_t* snapshot = create_mesh_snapshot(center, false);
 
-    /** Index: [x+1][y+1][z+1] */
-    chunk_cubic_t* rubik[3][3][3] = { { { 0 }, { 0 }, { 0 } }, { { 0 }, { 0 }, { 0 } }, { { 0 }, { 0 }, { 0 } } };
+    mesh_queue_info_t result = {};
+    build_mesh_from_snapshot(*snapshot, result);
+    delete snapshot;
+
+    apply_mesh_result(result);
+}
+#endif
 
-    rubik[1][1][1] = center;
+void level_t::mesh_queue_info_t::release_data()
+{
+    if (vertex_freefunc)
+    {
+        vertex_freefunc(vertex_data);
+        vertex_data = NULL;
+    }
+}
 
-    rubik[2][1][1] = center->neighbors.pos_x;
-    rubik[1][2][1] = center->neighbors.pos_y;
-    rubik[1][1][2] = center->neighbors.pos_z;
-    rubik[0][1][1] = center->neighbors.neg_x;
-    rubik[1][0][1] = center->neighbors.neg_y;
-    rubik[1][1][0] = center->neighbors.neg_z;
+Uint64 level_t::get_greedy_mesh_mismatches() { return greedy_mesh_mismatches; }
 
-    for (int i = 0; i < 27; i++)
+level_t::performance_timer_t level_t::benchmark_mesh_pass(size_t* quad_count, Uint64* coverage_mismatches)
+{
+    performance_timer_t ret;
+    size_t quads = 0;
+    const Uint64 mismatches_old = greedy_mesh_mismatches;
+
+    if (!terrain)
     {
-        const int ix = (i / 9) % 3 - 1;
-        const int iy = (i / 3) % 3 - 1;
-        const int iz = i % 3 - 1;
+        dc_log_error("A texture atlas is required to build a chunk");
+        return ret;
+    }
 
-        /* Skip the cells we have already assigned */
-        if (abs(ix) + abs(iy) + abs(iz) <= 1)
-            continue;
-        assert(rubik[ix + 1][iy + 1][iz + 1] == NULL);
+    const Uint64 start_ns = SDL_GetTicksNS();
+    for (chunk_cubic_t* c : chunks_render_order)
+    {
+        mesh_snapshot_t* snapshot = create_mesh_snapshot(c, false);
 
-        rubik[ix + 1][iy + 1][iz + 1] = center->find_chunk(center, center->pos + glm::ivec3(ix, iy, iz));
+        mesh_queue_info_t result = {};
+        build_mesh_from_snapshot(*snapshot, result);
+        delete snapshot;
+
+        quads += result.quad_count_opaque + result.quad_count_alpha_test + result.quad_count_overlay + result.quad_count_translucent;
+        result.release_data();
+        ret.built++;
     }
+    ret.duration = SDL_GetTicksNS() - start_ns;
+
+    if (quad_count)
+        *quad_count = quads;
+    if (coverage_mismatches)
+        *coverage_mismatches = greedy_mesh_mismatches - mismatches_old;
+
+    return ret;
+}
+
+void level_t::build_mesh_from_snapshot(const mesh_snapshot_t& snapshot, mesh_queue_info_t& queue_info)
+{
+    Uint64 start_ns = SDL_GetTicksNS();
+
+    queue_info.pos = snapshot.pos;
+    queue_info.generation = snapshot.generation;
+
+    texture_terrain_t* const terrain = snapshot.terrain;
+
+    const int chunk_x = snapshot.pos.x;
+    const int chunk_y = snapshot.pos.y;
+    const int chunk_z = snapshot.pos.z;
+
+    /** Index: [x+1][y+1][z+1] */
+    chunk_cubic_t* const(&rubik)[3][3][3] = snapshot.rubik;
 
     /* We use ImVector instead of std::vector because we don't need the complication of std::vector */
     /* We use simple_array_t instead of std::array because it only has the [] operator and doesn't decay to a pointer */
@@ -158,24 +589,12 @@ void level_t::build_mesh(chunk_cubic_t* const center)
     simple_array_t<ImVector<terrain_vertex_t>, MESH_ID_MAX> vtx_overlay;
     simple_array_t<ImVector<terrain_vertex_t>, MESH_ID_MAX> vtx_translucent;
 
-    bool is_transparent[256];
-    bool is_translucent[256];
-    bool is_leaves_style_transparent[256];
-
-    for (int i = 0; i < IM_ARRAYSIZE(is_transparent); i++)
-        is_transparent[i] = mc_id::is_transparent(i);
-
-    for (int i = 0; i < IM_ARRAYSIZE(is_translucent); i++)
-        is_translucent[i] = mc_id::is_translucent(i);
-
-    for (int i = 0; i < IM_ARRAYSIZE(is_leaves_style_transparent); i++)
-        is_leaves_style_transparent[i] = mc_id::is_leaves_style_transparent(i);
+    const mc_id::block_bitset_t& is_transparent = mc_id::block_properties.transparent;
+    const mc_id::block_bitset_t& is_translucent = mc_id::block_properties.translucent;
+    const mc_id::block_bitset_t& is_leaves_style_transparent = mc_id::block_properties.leaves_style_transparent;
 
     /** Index: [x + 1][y + 1] */
-    glm::vec3 biome_colors[18][18];
-    float biome_temperature[18][18];
-    float biome_downfall[18][18];
-    generate_climate_colors(center->pos, biome_colors, biome_temperature, biome_downfall);
+    const glm::vec3(&biome_colors)[18][18] = snapshot.biome_colors;
 
     /** Index: [x+1][y+1][z+1] */
     block_id_t stypes[3][3][3];
@@ -793,7 +1212,7 @@ void level_t::build_mesh(chunk_cubic_t* const center)
             glm::vec3 col_1x_0z = AVG_BIOME_COL(x + 1, z + 0) * 0.25f;
             glm::vec3 col_1x_1z = AVG_BIOME_COL(x + 1, z + 1) * 0.25f;
 
-            if (!cvr_r_biome_oversample.get())
+            if (!snapshot.biome_blend)
             {
                 col_0x_0z = (col_0x_0z + col_0x_1z + col_1x_0z + col_1x_1z) * 0.25f;
                 col_0x_1z = col_0x_0z, col_1x_0z = col_0x_0z, col_1x_1z = col_0x_0z;
@@ -2053,7 +2472,7 @@ void level_t::build_mesh(chunk_cubic_t* const center)
                     break;
                 }
 
-                if (!cvr_r_smooth_lighting.get())
+                if (!snapshot.smooth_lighting)
                     goto skip_smooth;
 
                 if (mask & ~0x01)
@@ -2535,7 +2954,15 @@ void level_t::build_mesh(chunk_cubic_t* const center)
         /* ============ END: IS_NORMAL ============ */
     }
 
-    mesh_queue_info_t queue_info = {};
+    if (snapshot.greedy_mesh)
+    {
+        for (int _i = 0; _i < MESH_ID_MAX; _i++)
+        {
+            mesh_id_t i = (mesh_id_t)_i;
+            merge_cube_faces(vtx_solid[i], vtx_overlay[i], i);
+            merge_cube_faces(vtx_alpha[i], vtx_overlay[i], i);
+        }
+    }
 
     for (int _i = 0; _i < MESH_ID_MAX; _i++)
     {
@@ -2552,10 +2979,7 @@ void level_t::build_mesh(chunk_cubic_t* const center)
     TRACE("Chunk: <%d, %d, %d>, Quads (Overlay): %d", chunk_x, chunk_y, chunk_z, queue_info.quad_count_translucent);
 
     if (!queue_info.quad_count_opaque && !queue_info.quad_count_alpha_test && !queue_info.quad_count_translucent)
-    {
-        center->free_renderer_resources(chunk_cubic_t::DIRTY_LEVEL_NONE);
         return;
-    }
 
     int num_verts = queue_info.quad_count_opaque + queue_info.quad_count_alpha_test + queue_info.quad_count_overlay + queue_info.quad_count_translucent;
     num_verts *= 4;
@@ -2563,7 +2987,6 @@ void level_t::build_mesh(chunk_cubic_t* const center)
     queue_info.vertex_data = SDL_aligned_alloc(sizeof(terrain_vertex_t), num_verts * sizeof(terrain_vertex_t));
     queue_info.vertex_data_size = num_verts * sizeof(terrain_vertex_t);
     queue_info.vertex_freefunc = [](void* b) { SDL_aligned_free(b); };
-    queue_info.pos = center->pos;
 
     /* Combine vectors into one */
     int vtx_solid_idx = 0;
@@ -2580,8 +3003,6 @@ void level_t::build_mesh(chunk_cubic_t* const center)
 
     assert(vtx_solid_idx == num_verts);
 
-    mesh_queue.push_back(queue_info);
-
     accumulator += (SDL_GetTicksNS() - start_ns) / Uint64(100);
     Uint64 cur_cycle = ++cycles;
 
@@ -2605,9 +3026,19 @@ void level_t::generator_create()
 
 void level_t::generator_destroy() { delete GEN; }
 
-void level_t::generate_biome_ids(glm::ivec3 chunk_pos, std::vector<mc_id::biome_t>& biome_ids, int oversample)
+void level_t::generator_apply_seed()
 {
+    if (generator_seeded && generator_seed == mc_seed)
+        return;
+
     applySeed(GEN, DIM_OVERWORLD, mc_seed);
+    generator_seed = mc_seed;
+    generator_seeded = true;
+}
+
+void level_t::generate_biome_ids(glm::ivec3 chunk_pos, std::vector<mc_id::biome_t>& biome_ids, int oversample)
+{
+    generator_apply_seed();
 
     Range r = {
         .scale = 1,
@@ -2664,10 +3095,29 @@ SDL_FORCE_INLINE const glm::vec3 get_color_map(const float temperature, const fl
 
 void level_t::generate_climate_colors(const glm::ivec3 chunk_pos, glm::vec3 colors[18][18], float temperature[18][18], float humidity[18][18])
 {
-    generate_climate_parameters(chunk_pos, temperature, humidity);
-    for (int i = 0; i < 18; i++)
-        for (int j = 0; j < 18; j++)
-            colors[i][j] = get_color_map(temperature[i][j], humidity[i][j]);
+    const int cache_size = cvr_r_climate_cache_size.get();
+
+    /* The y coordinate is ignored because biomes only vary by column in this version */
+    climate_cache_t::key_t key;
+    key.x = chunk_pos.x;
+    key.z = chunk_pos.z;
+    key.seed = mc_seed;
+    key.dimension = dimension;
+    key.blend = cvr_r_biome_oversample.get();
+
+    climate_column_t column;
+    if (!cache_size || !climate_cache.get(key, column))
+    {
+        generate_climate_parameters(chunk_pos, column.temperature, column.humidity);
+        for (int i = 0; i < 18; i++)
+            for (int j = 0; j < 18; j++)
+                column.colors[i][j] = get_color_map(column.temperature[i][j], column.humidity[i][j]);
+        climate_cache.put(key, column, cache_size);
+    }
+
+    memcpy(colors, column.colors, sizeof(column.colors));
+    memcpy(temperature, column.temperature, sizeof(column.temperature));
+    memcpy(humidity, column.humidity, sizeof(column.humidity));
 }
 
 void level_t::generate_climate_parameters(const glm::ivec3 chunk_pos, float temperature[18][18], float humidity[18][18])
@@ -2750,7 +3200,7 @@ mc_id::biome_t level_t::get_biome_at(const glm::ivec3 pos)
     {
     case mc_id::DIMENSION_OVERWORLD:
         static_assert(sizeof(mc_id::biome_t) == sizeof(int));
-        applySeed(GEN, DIM_OVERWORLD, mc_seed);
+        generator_apply_seed();
         return mc_id::biome_t(getBiomeAt(GEN, 1, pos.x, pos.y, pos.z));
         break;
     case mc_id::DIMENSION_NETHER:
@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "chunk_cubic.h"
+
+/**
+ * Build a light test world of simplex terrain sprinkled with random blocks
+ *
+ * @param size World size (in chunks)
+ *
+ * @returns Chunks of the world, ownership is passed to the caller
+ */
+std::vector<chunk_cubic_t*> create_light_test_decorated_simplex(const glm::ivec3 size);
+
+/**
+ * Build a light test world of SDL_rand blocks
+ *
+ * @param size World size (in chunks)
+ * @param r_state State for SDL_rand_bits(), if null then a fixed state is used
+ *
+ * @returns Chunks of the world, ownership is passed to the caller
+ */
+std::vector<chunk_cubic_t*> create_light_test_sdl_rand(const glm::ivec3 size, Uint64* r_state = NULL);
@@ -240,6 +240,11 @@ static bool initialize_resources()
 
 static bool deinitialize_resources()
 {
+    /* Levels must let go of the resources first, the mesh workers read from the terrain atlas until they are stopped */
+    for (game_t* g : games)
+        if (g)
+            g->reload_resources(nullptr, true);
+
     delete state::game_resources;
     state::game_resources = 0;
 
@@ -253,10 +258,6 @@ static bool deinitialize_resources()
     state::destroy_clouds_pipelines();
     state::destroy_textures();
 
-    for (game_t* g : games)
-        if (g)
-            g->reload_resources(nullptr, true);
-
     delete sound_engine_main_menu;
     sound_engine_main_menu = NULL;
     return true;
@@ -531,17 +532,15 @@ void render_world_overlays(level_t* level, ImDrawList* const bg_draw_list)
     block_id_t type = BLOCK_ID_AIR;
     Uint8 metadata = 0;
 
-    auto chunk_map = level->get_chunk_map();
-
-    auto it = chunk_map->find(glm::ivec3(cam_pos) >> 4);
-    if (it != chunk_map->end())
+    chunk_cubic_t* c = level->get_chunk(glm::ivec3(cam_pos) >> 4);
+    if (c)
     {
         glm::ivec3 coords_rel = glm::ivec3(cam_pos) & 0x0F;
-        block_id_t _type = it->second->get_type(coords_rel.x, coords_rel.y, coords_rel.z);
+        block_id_t _type = c->get_type(coords_rel.x, coords_rel.y, coords_rel.z);
         if (_type != BLOCK_ID_AIR && _type != BLOCK_ID_NONE)
         {
             type = _type;
-            metadata = it->second->get_metadata(coords_rel.x, coords_rel.y, coords_rel.z);
+            metadata = c->get_metadata(coords_rel.x, coords_rel.y, coords_rel.z);
         }
     }
 
@@ -1425,7 +1424,7 @@ static void process_event(SDL_Event& event, bool* done)
                 glm::ivec3 chunk_coords = glm::ivec3(level->foot_pos) >> 4;
                 if (chunk_coords != c->pos)
                     continue;
-                c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL;
+                level->mark_dirty(c);
             }
             break;
         }
@@ -1453,7 +1452,7 @@ static void process_event(SDL_Event& event, bool* done)
             {
                 if (SDL_abs(chunk_coords.x - c->pos.x) > 1 || SDL_abs(chunk_coords.y - c->pos.y) > 1 || SDL_abs(chunk_coords.z - c->pos.z) > 1)
                     continue;
-                c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL;
+                level->mark_dirty(c);
             }
             break;
         }
@@ -1828,12 +1827,40 @@ static void screenshot_func_save(const glm::ivec2 tex_size, gpu::fence_t* const
 }
 
 static convar_int_t cvr_profile_light("profile_light", 0, 0, 1, "Profile lighting engine then exit", CONVAR_FLAG_INT_IS_BOOL | CONVAR_FLAG_DEV_ONLY);
+
+/**
+ * Hashes the light data of every chunk in a level (Independent of chunk order)
+ */
+static Uint64 hash_level_light(level_t* const level)
+{
+    Uint64 ret = 0;
+    for (chunk_cubic_t* c : level->get_chunk_vec())
+    {
+        /* FNV-1a */
+        Uint64 hash = 0xcbf29ce484222325;
+        auto feed = [&hash](const void* const dat, const size_t len) {
+            for (size_t i = 0; i < len; i++)
+                hash = (hash ^ static_cast<const Uint8*>(dat)[i]) * 0x100000001b3;
+        };
+        feed(&c->pos, sizeof(c->pos));
+        feed(c->data_light_block, sizeof(c->data_light_block));
+        feed(c->data_light_sky, sizeof(c->data_light_sky));
+        ret += hash;
+    }
+    return ret;
+}
+
 static void profile_light()
 {
     game_t game(state::game_resources);
 
     game.level->enable_timer_log_light = 1;
 
+    /* Every world has to be lit in a single frame */
+    convar_float_t* chunk_budget = convar_t::get_convar_float("r_chunk_budget_ms");
+    const float chunk_budget_old = chunk_budget->get();
+    chunk_budget->set(0.0f);
+
     const glm::ivec3 world_configs[] = {
         { 24, 16, 24 },
         { 24, 8, 24 },
@@ -1878,7 +1905,7 @@ static void profile_light()
         size_t total = 0;
         for (chunk_cubic_t* c : game.level->get_chunk_vec())
         {
-            c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL;
+            game.level->mark_dirty(c);
             for (int pos_it = 0; pos_it < SUBCHUNK_SIZE_VOLUME; pos_it++)
             {
                 const int y = (pos_it) & 0x0F;
@@ -1945,6 +1972,231 @@ static void profile_light()
         if (timers[j][i].built)
             dc_log("Lit %zu chunks in %.2f ms (%.2f us per) (Pass %d)", timers[j][i].built, timers[j][i].duration / 1000.0 / 1000.0,
                 timers[j][i].duration / timers[j][i].built / 1000.0, i % 5);
+
+    /* Thread scaling, every thread count must produce exactly the same light data as the single threaded run */
+    dc_log(SPACER " Results (Thread scaling) " SPACER);
+    game.level->enable_timer_log_light = 0;
+
+    std::vector<Uint64> reference_hashes;
+    const int max_threads = SDL_max(SDL_GetNumLogicalCPUCores() - 1, 1);
+    Uint64 duration_single = 0;
+    for (int num_threads = 1;; num_threads = SDL_min(num_threads * 2, max_threads))
+    {
+        game.level->light_threads_override = num_threads;
+
+        level_t::performance_timer_t timer;
+        size_t mismatches = 0;
+        for (int pass = 0; pass < IM_ARRAYSIZE(world_configs) * 2; pass++)
+        {
+            const glm::ivec3 world_size = world_configs[pass % IM_ARRAYSIZE(world_configs)];
+            if (pass < IM_ARRAYSIZE(world_configs))
+                game.create_light_test_decorated_simplex(world_size);
+            else
+                game.create_light_test_sdl_rand(world_size);
+
+            for (chunk_cubic_t* c : game.level->get_chunk_vec())
+                game.level->mark_dirty(c);
+
+            game.level->render_stage_prepare({ 10, 10 }, 0.0f);
+
+            timer += game.level->last_perf_light_pass1;
+            timer += game.level->last_perf_light_pass2;
+            timer += game.level->last_perf_light_pass3;
+
+            const Uint64 hash = hash_level_light(game.level);
+            if (num_threads == 1)
+                reference_hashes.push_back(hash);
+            else if (hash != reference_hashes[pass])
+                mismatches++;
+        }
+
+        if (num_threads == 1)
+            duration_single = timer.duration;
+
+        dc_log("%d thread(s): Lit %zu chunks in %.2f ms (%.2f us per) (%.2fx)", num_threads, timer.built, timer.duration / 1000.0 / 1000.0,
+            timer.duration / SDL_max(timer.built, size_t(1)) / 1000.0, double(duration_single) / double(SDL_max(timer.duration, Uint64(1))));
+        if (mismatches)
+            dc_log_error("%d thread(s): Light data differs from the single threaded run in %zu worlds!", num_threads, mismatches);
+
+        if (num_threads >= max_threads)
+            break;
+    }
+
+    game.level->light_threads_override = 0;
+
+    /* Light kernels, the vectorized kernels must produce exactly the same light data as the scalar reference */
+    dc_log(SPACER " Results (Light kernels) " SPACER);
+    if (!chunk_cubic_t::light_pass_is_vectorized())
+        dc_log_warn("Vectorized light kernels are not available on this platform, both timings are of the scalar kernels");
+
+    Uint64 duration_scalar = 0;
+    Uint64 duration_vector = 0;
+    size_t kernel_chunks = 0;
+    size_t kernel_mismatches = 0;
+    for (int pass = 0; pass < IM_ARRAYSIZE(world_configs) * 2; pass++)
+    {
+        const glm::ivec3 world_size = world_configs[pass % IM_ARRAYSIZE(world_configs)];
+        if (pass < IM_ARRAYSIZE(world_configs))
+            game.create_light_test_decorated_simplex(world_size);
+        else
+            game.create_light_test_sdl_rand(world_size);
+
+        for (chunk_cubic_t* c : game.level->get_chunk_vec())
+        {
+            c->clear_light_block(0);
+            c->light_pass_block_setup();
+            c->clear_light_sky(0);
+            c->light_pass_block_grab_from_neighbors();
+            c->light_pass_sky_grab_from_neighbors();
+
+            Uint8 in_block[sizeof(c->data_light_block)];
+            Uint8 in_sky[sizeof(c->data_light_sky)];
+            memcpy(in_block, c->data_light_block, sizeof(in_block));
+            memcpy(in_sky, c->data_light_sky, sizeof(in_sky));
+
+            Uint64 start = SDL_GetTicksNS();
+            c->light_pass_block_propagate_internals_scalar();
+            c->light_pass_sky_propagate_internals_scalar();
+            duration_scalar += SDL_GetTicksNS() - start;
+
+            Uint8 ref_block[sizeof(c->data_light_block)];
+            Uint8 ref_sky[sizeof(c->data_light_sky)];
+            memcpy(ref_block, c->data_light_block, sizeof(ref_block));
+            memcpy(ref_sky, c->data_light_sky, sizeof(ref_sky));
+            memcpy(c->data_light_block, in_block, sizeof(in_block));
+            memcpy(c->data_light_sky, in_sky, sizeof(in_sky));
+
+            start = SDL_GetTicksNS();
+            c->light_pass_block_propagate_internals();
+            c->light_pass_sky_propagate_internals();
+            duration_vector += SDL_GetTicksNS() - start;
+
+            if (memcmp(ref_block, c->data_light_block, sizeof(ref_block)) || memcmp(ref_sky, c->data_light_sky, sizeof(ref_sky)))
+                kernel_mismatches++;
+            kernel_chunks++;
+        }
+    }
+
+    kernel_chunks = SDL_max(kernel_chunks, size_t(1));
+    dc_log("Scalar: Propagated %zu chunks in %.2f ms (%.2f us per)", kernel_chunks, duration_scalar / 1000.0 / 1000.0,
+        duration_scalar / kernel_chunks / 1000.0);
+    dc_log("Vector: Propagated %zu chunks in %.2f ms (%.2f us per) (%.2fx)", kernel_chunks, duration_vector / 1000.0 / 1000.0,
+        duration_vector / kernel_chunks / 1000.0, double(duration_scalar) / double(SDL_max(duration_vector, Uint64(1))));
+    if (kernel_mismatches)
+        dc_log_error("Vectorized light kernels differ from the scalar reference in %zu chunks!", kernel_mismatches);
+
+    chunk_budget->set(chunk_budget_old);
+}
+
+static convar_int_t cvr_profile_mesh("profile_mesh", 0, 0, 1, "Profile mesh building with and without the climate cache and greedy merging then exit",
+    CONVAR_FLAG_INT_IS_BOOL | CONVAR_FLAG_DEV_ONLY);
+
+static void profile_mesh()
+{
+    game_t game(state::game_resources);
+
+    /* Tall worlds have more chunks per column, and thus more to gain from the climate cache */
+    const glm::ivec3 world_configs[] = {
+        { 16, 16, 16 },
+        { 8, 64, 8 },
+        { 8, 8, 8 },
+        { 4, 256, 4 },
+        { 24, 4, 24 },
+    };
+
+    convar_int_t* cache_size = convar_t::get_convar_int("r_climate_cache_size");
+    const int cache_size_old = cache_size->get();
+
+    convar_int_t* greedy_mesh = convar_t::get_convar_int("r_greedy_mesh");
+    convar_int_t* greedy_mesh_verify = convar_t::get_convar_int("r_greedy_mesh_verify");
+    const int greedy_mesh_old = greedy_mesh->get();
+    const int greedy_mesh_verify_old = greedy_mesh_verify->get();
+
+    /* Every world has to be lit in a single frame */
+    convar_float_t* chunk_budget = convar_t::get_convar_float("r_chunk_budget_ms");
+    const float chunk_budget_old = chunk_budget->get();
+    chunk_budget->set(0.0f);
+
+    /** Index: [cached] */
+    level_t::performance_timer_t timers[2];
+    Uint64 hits[2] = { 0 };
+    Uint64 misses[2] = { 0 };
+
+    /** Index: [greedy] */
+    level_t::performance_timer_t timers_greedy[2];
+    size_t quads_greedy[2] = { 0 };
+    Uint64 coverage_mismatches = 0;
+
+    for (int pass = 0; pass < IM_ARRAYSIZE(world_configs); pass++)
+    {
+        const glm::ivec3 world_size = world_configs[pass];
+        dc_log(SPACER " Pass %d (%dx%dx%d) " SPACER, pass, world_size.x, world_size.y, world_size.z);
+        game.create_light_test_decorated_simplex(world_size);
+
+        for (chunk_cubic_t* c : game.level->get_chunk_vec())
+            game.level->mark_dirty(c);
+        game.level->render_stage_prepare({ 10, 10 }, 0.0f);
+
+        for (int cached = 0; cached < 2; cached++)
+        {
+            cache_size->set(cached ? SDL_max(cache_size_old, cache_size->get_default()) : 0);
+            game.level->get_climate_cache().clear();
+
+            const Uint64 hits_old = game.level->get_climate_cache().hits;
+            const Uint64 misses_old = game.level->get_climate_cache().misses;
+
+            const level_t::performance_timer_t timer = game.level->benchmark_mesh_pass();
+            dc_log("%s: Built %zu meshes in %.2f ms (%.2f us per)", cached ? "Cached" : "Uncached", timer.built, timer.duration / 1000.0 / 1000.0,
+                timer.duration / SDL_max(timer.built, size_t(1)) / 1000.0);
+
+            timers[cached] += timer;
+            hits[cached] += game.level->get_climate_cache().hits - hits_old;
+            misses[cached] += game.level->get_climate_cache().misses - misses_old;
+        }
+
+        /* The coverage check is done on a separate pass so that it does not pollute the timings */
+        for (int greedy = 0; greedy < 2; greedy++)
+        {
+            greedy_mesh->set(greedy);
+            greedy_mesh_verify->set(0);
+
+            size_t quads = 0;
+            const level_t::performance_timer_t timer = game.level->benchmark_mesh_pass(&quads);
+            dc_log("%s: Built %zu meshes in %.2f ms (%.2f us per) (%zu quads)", greedy ? "Greedy" : "Per face", timer.built, timer.duration / 1000.0 / 1000.0,
+                timer.duration / SDL_max(timer.built, size_t(1)) / 1000.0, quads);
+
+            timers_greedy[greedy] += timer;
+            quads_greedy[greedy] += quads;
+        }
+
+        greedy_mesh_verify->set(1);
+        Uint64 mismatches = 0;
+        game.level->benchmark_mesh_pass(nullptr, &mismatches);
+        coverage_mismatches += mismatches;
+    }
+
+    cache_size->set(cache_size_old);
+    greedy_mesh->set(greedy_mesh_old);
+    greedy_mesh_verify->set(greedy_mesh_verify_old);
+    chunk_budget->set(chunk_budget_old);
+
+    dc_log(SPACER " Results (Climate cache) " SPACER);
+    for (int cached = 0; cached < 2; cached++)
+        dc_log("%s: Built %zu meshes in %.2f ms (%.2f us per, %.1f meshes/s) (%.2fx) (%lu hits, %lu misses)", cached ? "Cached" : "Uncached",
+            timers[cached].built, timers[cached].duration / 1000.0 / 1000.0, timers[cached].duration / SDL_max(timers[cached].built, size_t(1)) / 1000.0,
+            timers[cached].built * 1000000000.0 / double(SDL_max(timers[cached].duration, Uint64(1))),
+            double(timers[0].duration) / double(SDL_max(timers[cached].duration, Uint64(1))), hits[cached], misses[cached]);
+
+    dc_log(SPACER " Results (Greedy merging) " SPACER);
+    for (int greedy = 0; greedy < 2; greedy++)
+        dc_log("%s: Built %zu meshes in %.2f ms (%.2f us per) (%zu quads, %.2f MiB of vertices) (%.2fx quads)", greedy ? "Greedy" : "Per face",
+            timers_greedy[greedy].built, timers_greedy[greedy].duration / 1000.0 / 1000.0,
+            timers_greedy[greedy].duration / SDL_max(timers_greedy[greedy].built, size_t(1)) / 1000.0, quads_greedy[greedy],
+            quads_greedy[greedy] * 4 * sizeof(terrain_vertex_t) / 1024.0 / 1024.0, double(quads_greedy[0]) / double(SDL_max(quads_greedy[greedy], size_t(1))));
+    if (coverage_mismatches)
+        dc_log_error("Greedy merging changed the rasterized face coverage of %lu face groups!", coverage_mismatches);
+    else
+        dc_log("Greedy merging preserved the rasterized face coverage of every face group");
 }
 
 #include "sound/sound_world.h"
@@ -2126,14 +2378,15 @@ int main(int argc, char* argv[])
     SDL_SetLogPriorityPrefix(SDL_LOG_PRIORITY_ERROR, "[SDL_LOG][ERROR]: ");
     SDL_SetLogPriorityPrefix(SDL_LOG_PRIORITY_CRITICAL, "[SDL_LOG][CRITICAL]: ");
 
-    /* No reason to allow cvr_profile_light in non-dev environments */
+    /* No reason to allow cvr_profile_light/cvr_profile_mesh in non-dev environments */
     if (!convar_t::dev())
-        cvr_profile_light.set(0);
+        cvr_profile_light.set(0), cvr_profile_mesh.set(0);
 
     /* Prevent someone from unexpectedly killing the application */
     cvr_profile_light.set_pre_callback([](int, int) -> bool { return 0; });
+    cvr_profile_mesh.set_pre_callback([](int, int) -> bool { return 0; });
 
-    if (cvr_profile_light.get())
+    if (cvr_profile_light.get() || cvr_profile_mesh.get())
         SDL_HideWindow(state::window);
 
     dev_console::add_command("chat", [=](int argc, const char** argv) -> int {
@@ -2283,7 +2536,7 @@ int main(int argc, char* argv[])
         case ENGINE_STATE_CONFIGURE:
         {
             /* This is maybe a bit unnecessary as no normal person should ever be in this situation but, it doesn't hurt to have this here */
-            if (cvr_profile_light.get())
+            if (cvr_profile_light.get() || cvr_profile_mesh.get())
                 SDL_ShowWindow(state::window);
 
             ImGui::SetNextWindowSizeConstraints(ImVec2(0, 0), viewport->WorkSize);
@@ -2348,6 +2601,15 @@ int main(int argc, char* argv[])
                 break;
             }
 
+            if (cvr_profile_mesh.get())
+            {
+                profile_mesh();
+
+                engine_state_target = ENGINE_STATE_EXIT;
+
+                break;
+            }
+
             static task_timer_t timer_process_input("Loop stage: Process input");
             static task_timer_t timer_stage_prerender("Loop stage: Pre-render");
             static task_timer_t timer_stage_render("Loop stage: Render");
@@ -2411,7 +2673,7 @@ int main(int argc, char* argv[])
                 if (ImGui::Button("Mark all meshes for relight"))
                 {
                     for (chunk_cubic_t* c : level->get_chunk_vec())
-                        c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL;
+                        level->mark_dirty(c);
                 }
 
                 if (ImGui::Button("Clear meshes"))
@@ -69,8 +69,22 @@ struct main0_in
     float frag_light_block [[user(locn3)]];
     float frag_light_sky [[user(locn4)]];
     float frag_fog_dist [[user(locn5)]];
+    float4 frag_uv_rect [[user(locn6), flat]];
+    uint frag_tiled [[user(locn7), flat]];
 };
 
+static inline __attribute__((always_inline))
+float4 sample_atlas(thread const _69& frag, thread const float4& frag_uv_rect, thread const uint& frag_tiled, texture2d<float> tex_atlas, sampler tex_atlasSmplr)
+{
+    if (frag_tiled == 0u)
+    {
+        return tex_atlas.sample(tex_atlasSmplr, frag.uv, bias(-1.0));
+    }
+    float2 uv_unwrapped = frag.uv * frag_uv_rect.zw;
+    float2 uv = frag_uv_rect.xy + (fract(frag.uv) * frag_uv_rect.zw);
+    return tex_atlas.sample(tex_atlasSmplr, uv, gradient2d(dfdx(uv_unwrapped) * 0.5, dfdy(uv_unwrapped) * 0.5));
+}
+
 fragment main0_out main0(main0_in in [[stage_in]], constant ubo_frag_t& ubo_frag [[buffer(0)]], constant ubo_lightmap_t& ubo_lightmap [[buffer(1)]], texture2d<float> tex_atlas [[texture(0)]], sampler tex_atlasSmplr [[sampler(0)]])
 {
     main0_out out = {};
@@ -84,11 +98,11 @@ fragment main0_out main0(main0_in in [[stage_in]], constant ubo_frag_t& ubo_frag
     out.out_color = frag.color;
     if (ubo_frag.use_texture == 1u)
     {
-        out.out_color *= tex_atlas.sample(tex_atlasSmplr, frag.uv, bias(-1.0));
+        out.out_color *= sample_atlas(frag, in.frag_uv_rect, in.frag_tiled, tex_atlas, tex_atlasSmplr);
     }
     else
     {
-        out.out_color.w *= tex_atlas.sample(tex_atlasSmplr, frag.uv, bias(-1.0)).w;
+        out.out_color.w *= sample_atlas(frag, in.frag_uv_rect, in.frag_tiled, tex_atlas, tex_atlasSmplr).w;
     }
     if (out.out_color.w < 0.00390625)
     {
@@ -75,26 +75,78 @@ struct main0_out
     float frag_light_block [[user(locn3)]];
     float frag_light_sky [[user(locn4)]];
     float frag_fog_dist [[user(locn5)]];
+    float4 frag_uv_rect [[user(locn6)]];
+    uint frag_tiled [[user(locn7)]];
     float4 gl_Position [[position]];
 };
 
+static inline __attribute__((always_inline))
+float3 unpack_pos(thread const uint& pos_ao)
+{
+    int3 pos;
+    pos.x = int(extract_bits(pos_ao, uint(0), uint(10)) & 4294967294u) - 256;
+    pos.y = int(extract_bits(pos_ao, uint(10), uint(10))) - 256;
+    pos.z = int(extract_bits(pos_ao, uint(20), uint(10))) - 256;
+    return float3(pos) * 0.03125;
+}
+
+static inline __attribute__((always_inline))
+float2 unpack_uv(thread const uint& texturing)
+{
+    return float2(float(extract_bits(texturing, uint(0), uint(16))), float(extract_bits(texturing, uint(16), uint(16)))) * 3.0517578125e-05;
+}
+
 vertex main0_out main0(constant ubo_world_t& ubo_world [[buffer(0)]], constant ubo_tint_t& ubo_tint [[buffer(1)]], const device vertex_data_t& vtx_data [[buffer(2)]], const device draw_pos_t& draw_pos [[buffer(3)]], uint gl_VertexIndex [[vertex_id]], uint gl_InstanceIndex [[instance_id]])
 {
     main0_out out = {};
     _123 frag = {};
-    uint _20 = uint(int(gl_VertexIndex) >> 2);
-    uint _36 = uint(int(gl_InstanceIndex) * 4) + uint(int(gl_VertexIndex) & 3);
-    float4 _121 = ubo_world.camera * float4(float((int(extract_bits(vtx_data.data[_36].pos_ao, uint(0), uint(10))) - 256) + (((device int*)&draw_pos.pos[_20])[0u] * 512)) * 0.03125, float((int(extract_bits(vtx_data.data[_36].pos_ao, uint(10), uint(10))) - 256) + (((device int*)&draw_pos.pos[_20])[1u] * 512)) * 0.03125, float((int(extract_bits(vtx_data.data[_36].pos_ao, uint(20), uint(10))) - 256) + (((device int*)&draw_pos.pos[_20])[2u] * 512)) * 0.03125, 1.0);
+    uint idx_vtx = uint(int(gl_VertexIndex) & 3);
+    uint idx_draw = uint(int(gl_VertexIndex) >> 2);
+    vertex_t vtx = vtx_data.data[(uint(int(gl_InstanceIndex) * 4) + idx_vtx)];
+    float4 _121 = ubo_world.camera * float4(unpack_pos(vtx.pos_ao) + float3(draw_pos.pos[idx_draw].xyz * int3(16)), 1.0);
     frag.fog_dist = length(_121.xyz);
     out.gl_Position = ubo_world.projection * _121;
-    frag.ao = float(extract_bits(vtx_data.data[_36].pos_ao, uint(30), uint(2))) * 0.3333333432674407958984375;
-    frag.color.x = (ubo_tint.tint.x * float(extract_bits(vtx_data.data[_36].coloring, uint(0), uint(8)))) * 0.0039215688593685626983642578125;
-    frag.color.y = (ubo_tint.tint.y * float(extract_bits(vtx_data.data[_36].coloring, uint(8), uint(8)))) * 0.0039215688593685626983642578125;
-    frag.color.z = (ubo_tint.tint.z * float(extract_bits(vtx_data.data[_36].coloring, uint(16), uint(8)))) * 0.0039215688593685626983642578125;
+    frag.ao = float(extract_bits(vtx.pos_ao, uint(30), uint(2))) * 0.3333333432674407958984375;
+    frag.color.x = (ubo_tint.tint.x * float(extract_bits(vtx.coloring, uint(0), uint(8)))) * 0.0039215688593685626983642578125;
+    frag.color.y = (ubo_tint.tint.y * float(extract_bits(vtx.coloring, uint(8), uint(8)))) * 0.0039215688593685626983642578125;
+    frag.color.z = (ubo_tint.tint.z * float(extract_bits(vtx.coloring, uint(16), uint(8)))) * 0.0039215688593685626983642578125;
     frag.color.w = ubo_tint.tint.w;
-    frag.light_block = float(extract_bits(vtx_data.data[_36].coloring, uint(24), uint(4))) * 0.066666670143604278564453125;
-    frag.light_sky = float(extract_bits(vtx_data.data[_36].coloring, uint(28), uint(4))) * 0.066666670143604278564453125;
-    frag.uv = float2(float(extract_bits(vtx_data.data[_36].texturing, uint(0), uint(16))) * 3.0517578125e-05, float(extract_bits(vtx_data.data[_36].texturing, uint(16), uint(16))) * 3.0517578125e-05);
+    frag.light_block = float(extract_bits(vtx.coloring, uint(24), uint(4))) * 0.066666670143604278564453125;
+    frag.light_sky = float(extract_bits(vtx.coloring, uint(28), uint(4))) * 0.066666670143604278564453125;
+    frag.uv = unpack_uv(vtx.texturing);
+    out.frag_tiled = extract_bits(vtx.pos_ao, uint(0), uint(1));
+    out.frag_uv_rect = float4(frag.uv, 0.0, 0.0);
+    if (out.frag_tiled == 1u)
+    {
+        float3 quad_pos[4];
+        float2 quad_uv[4];
+        float2 uv_min = frag.uv;
+        float2 uv_max = frag.uv;
+        for (uint i = 0u; i < 4u; i++)
+        {
+            vertex_t quad_vtx = vtx_data.data[(uint(int(gl_InstanceIndex) * 4) + i)];
+            quad_pos[i] = unpack_pos(quad_vtx.pos_ao);
+            quad_uv[i] = unpack_uv(quad_vtx.texturing);
+            uv_min = fast::min(uv_min, quad_uv[i]);
+            uv_max = fast::max(uv_max, quad_uv[i]);
+        }
+        bool2 corner = frag.uv == uv_max;
+        float2 repeats = float2(1.0);
+        for (uint i = 0u; i < 4u; i++)
+        {
+            bool2 other = quad_uv[i] == uv_max;
+            if ((other.x != corner.x) && (other.y == corner.y))
+            {
+                repeats.x = distance(quad_pos[i], quad_pos[idx_vtx]);
+            }
+            if ((other.y != corner.y) && (other.x == corner.x))
+            {
+                repeats.y = distance(quad_pos[i], quad_pos[idx_vtx]);
+            }
+        }
+        out.frag_uv_rect = float4(uv_min, uv_max - uv_min);
+        frag.uv = float2(corner) * repeats;
+    }
     out.frag_color = frag.color;
     out.frag_uv = frag.uv;
     out.frag_ao = frag.ao;
@@ -35,6 +35,10 @@ layout(location = 0) in struct
     float light_sky;
     float fog_dist;
 } frag;
+
+/** Texture rectangle of a tiled quad (xy: Origin, zw: Size), frag.uv is then in blocks */
+layout(location = 6) flat in vec4 frag_uv_rect;
+layout(location = 7) flat in uint frag_tiled;
 /* ================ END Fragment inputs ================ */
 
 /**
@@ -68,14 +72,25 @@ layout(std140, set = 3, binding = 0) uniform ubo_frag_t
 #error "Alpha testing is not compatible with depth peeling!"
 #endif
 
+vec4 sample_atlas()
+{
+    if (frag_tiled == 0)
+        return texture(tex_atlas, frag.uv, -1.0);
+
+    /* Gradients come from the unwrapped coordinates so that the mip level does not jump at tile seams, halving them matches the bias above */
+    vec2 uv_unwrapped = frag.uv * frag_uv_rect.zw;
+    vec2 uv = frag_uv_rect.xy + fract(frag.uv) * frag_uv_rect.zw;
+    return textureGrad(tex_atlas, uv, dFdx(uv_unwrapped) * 0.5, dFdy(uv_unwrapped) * 0.5);
+}
+
 void main()
 {
     out_color = frag.color;
 
     if (ubo_frag.use_texture == 1)
-        out_color *= texture(tex_atlas, frag.uv, -1.0);
+        out_color *= sample_atlas();
     else
-        out_color.a *= texture(tex_atlas, frag.uv, -1.0).a;
+        out_color.a *= sample_atlas().a;
 
 #if (DEPTH_PEELING) == 1
     if(out_color.a < (1.0/256.0))
@@ -29,6 +29,8 @@ struct vertex_t
      * Y:  [10..19]
      * Z:  [20..29]
      * AO: [30..31]
+     *
+     * Tiled: [0] (The lowest bit of X is always zero, so it marks merged quads)
      */
     uint pos_ao;
     /**
@@ -65,6 +67,10 @@ layout(location = 0) out struct
     float light_sky;
     float fog_dist;
 } frag;
+
+/** Texture rectangle of a tiled quad (xy: Origin, zw: Size), frag.uv is then in blocks */
+layout(location = 6) flat out vec4 frag_uv_rect;
+layout(location = 7) flat out uint frag_tiled;
 /* ================ END Vertex outputs ================ */
 
 /**
@@ -85,6 +91,18 @@ ubo_world;
 layout(std140, set = 1, binding = 1) uniform ubo_tint_t { vec4 tint; }
 ubo_tint;
 
+/** Position relative to the chunk (in blocks) */
+vec3 unpack_pos(uint pos_ao)
+{
+    ivec3 pos;
+    pos.x = int(bitfieldExtract(pos_ao,  0, 10) & ~1u) - 256;
+    pos.y = int(bitfieldExtract(pos_ao, 10, 10)) - 256;
+    pos.z = int(bitfieldExtract(pos_ao, 20, 10)) - 256;
+    return vec3(pos) / 32.0;
+}
+
+vec2 unpack_uv(uint texturing) { return vec2(bitfieldExtract(texturing, 0, 16), bitfieldExtract(texturing, 16, 16)) / 32768.0; }
+
 void main()
 {
     uint idx_vtx = gl_VertexIndex & 3;
@@ -92,10 +110,7 @@ void main()
 
     vertex_t vtx = vtx_data.data[gl_InstanceIndex * 4 + idx_vtx];
 
-    vec3 pos;
-    pos.x = float(int(bitfieldExtract(vtx.pos_ao,  0, 10)) - 256 + draw_pos.pos[idx_draw].x * 512) / 32.0;
-    pos.y = float(int(bitfieldExtract(vtx.pos_ao, 10, 10)) - 256 + draw_pos.pos[idx_draw].y * 512) / 32.0;
-    pos.z = float(int(bitfieldExtract(vtx.pos_ao, 20, 10)) - 256 + draw_pos.pos[idx_draw].z * 512) / 32.0;
+    vec3 pos = unpack_pos(vtx.pos_ao) + vec3(draw_pos.pos[idx_draw].xyz * 16);
     vec4 camera_space_pos = ubo_world.camera * vec4(pos, 1.0);
 
     frag.fog_dist = length(camera_space_pos.xyz);
@@ -112,7 +127,40 @@ void main()
     frag.light_block = float(bitfieldExtract(vtx.coloring, 24, 4)) / 15.0;
     frag.light_sky   = float(bitfieldExtract(vtx.coloring, 28, 4)) / 15.0;
 
-    float u = float(bitfieldExtract(vtx.texturing,  0, 16)) / 32768.0;
-    float v = float(bitfieldExtract(vtx.texturing, 16, 16)) / 32768.0;
-    frag.uv = vec2(u, v);
+    frag.uv = unpack_uv(vtx.texturing);
+
+    frag_tiled = bitfieldExtract(vtx.pos_ao, 0, 1);
+    frag_uv_rect = vec4(frag.uv, 0.0, 0.0);
+
+    if (frag_tiled == 1)
+    {
+        /* The vertices of a tiled quad keep the texture corners of a single block face, so the rectangle comes from the whole quad */
+        vec3 quad_pos[4];
+        vec2 quad_uv[4];
+        vec2 uv_min = frag.uv;
+        vec2 uv_max = frag.uv;
+        for (uint i = 0; i < 4; i++)
+        {
+            vertex_t quad_vtx = vtx_data.data[gl_InstanceIndex * 4 + i];
+            quad_pos[i] = unpack_pos(quad_vtx.pos_ao);
+            quad_uv[i] = unpack_uv(quad_vtx.texturing);
+            uv_min = min(uv_min, quad_uv[i]);
+            uv_max = max(uv_max, quad_uv[i]);
+        }
+
+        /* The repeat count along a texture axis is the distance to the vertex on the other side of that axis */
+        bvec2 corner = equal(frag.uv, uv_max);
+        vec2 repeats = vec2(1.0);
+        for (uint i = 0; i < 4; i++)
+        {
+            bvec2 other = equal(quad_uv[i], uv_max);
+            if (other.x != corner.x && other.y == corner.y)
+                repeats.x = distance(quad_pos[i], quad_pos[idx_vtx]);
+            if (other.y != corner.y && other.x == corner.x)
+                repeats.y = distance(quad_pos[i], quad_pos[idx_vtx]);
+        }
+
+        frag_uv_rect = vec4(uv_min, uv_max - uv_min);
+        frag.uv = vec2(corner) * repeats;
+    }
 }
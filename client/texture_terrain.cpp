@@ -424,6 +424,7 @@ texture_terrain_t::texture_terrain_t(const std::string& path_textures)
         }
     }
 
+#ifndef MCS_B181_CLIENT_HEADLESS
     SDL_GPUTextureCreateInfo cinfo_texture = {};
     cinfo_texture.type = SDL_GPU_TEXTURETYPE_2D;
     cinfo_texture.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
@@ -440,6 +441,7 @@ texture_terrain_t::texture_terrain_t(const std::string& path_textures)
 
     binding.texture = gpu::create_texture(cinfo_texture, "Terrain texture");
     binding.sampler = gpu::create_sampler(cinfo_sampler, "Terrain sampler");
+#endif
 
     dc_log("Built terrain atlas in %.1f ms", (double)(SDL_GetTicksNS() - start_tick) / 1000000.0);
 
@@ -447,6 +449,25 @@ texture_terrain_t::texture_terrain_t(const std::string& path_textures)
         dump_mipmaps();
 }
 
+texture_terrain_t::texture_terrain_t()
+{
+    const int tile_size = 16;
+    const int tiles_per_row = SDL_ceil(SDL_sqrt(double(mc_id::FACE_COUNT)));
+
+    tex_base_width = tiles_per_row * tile_size;
+    tex_base_height = tiles_per_row * tile_size;
+
+    for (int i = 0; i < mc_id::FACE_COUNT; i++)
+    {
+        texture_pre_pack_t tile;
+        tile.w = tile_size;
+        tile.h = tile_size;
+        tile.x = (i % tiles_per_row) * tile_size;
+        tile.y = (i / tiles_per_row) * tile_size;
+        texture_faces[i] = texture_post_pack_t(tile, mc_id::terrain_face_id_t(i), tex_base_width, tex_base_height);
+    }
+}
+
 void texture_terrain_t::update(SDL_GPUCopyPass* copy_pass)
 {
     Uint64 cur_sdl_tick = SDL_GetTicks();
@@ -570,9 +591,11 @@ void texture_terrain_t::update(SDL_GPUCopyPass* copy_pass)
         }
     }
 
+#ifndef MCS_B181_CLIENT_HEADLESS
     for (size_t i = 0; i < raw_mipmaps.size(); i++)
         gpu::upload_to_texture2d(
             copy_pass, binding.texture, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, 0, i, tex_base_width >> i, tex_base_height >> i, raw_mipmaps[i], false);
+#endif
 }
 
 void texture_terrain_t::dump_mipmaps()
@@ -691,8 +714,10 @@ bool texture_terrain_t::imgui_view(const char* title)
 
 texture_terrain_t::~texture_terrain_t()
 {
+#ifndef MCS_B181_CLIENT_HEADLESS
     gpu::release_texture(binding.texture);
     gpu::release_sampler(binding.sampler);
+#endif
 
     for (size_t i = 0; i < raw_mipmaps.size(); i++)
         free(raw_mipmaps[i]);
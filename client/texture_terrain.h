@@ -36,6 +36,13 @@ struct terrain_vertex_t
 {
     struct vtx_pos_ao_t
     {
+        /**
+         * Bit 0 of the X position is always zero, so it is used to mark a merged quad that repeats its texture once per block
+         *
+         * See: merge_cube_faces() in level_mesh.cpp and the tiling code in terrain.vert/terrain.frag
+         */
+        static const Uint32 FLAG_TILED = 1;
+
         Uint32 dat = 0;
 
         vtx_pos_ao_t() { }
@@ -113,6 +120,15 @@ public:
      */
     texture_terrain_t(const std::string& path_textures);
 
+    /**
+     * Build a placeholder atlas layout without touching any files or the GPU
+     *
+     * Every face gets its own 16x16 tile, which is enough for meshing (See: mcs_b181_mesh_bench)
+     *
+     * NOTE: No pixel data is generated, so texture_terrain_t::update() must not be called
+     */
+    texture_terrain_t();
+
     ~texture_terrain_t();
 
     /**
@@ -0,0 +1,208 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tetra/log.h"
+#include "tetra/tetra_core.h"
+#include "tetra/util/convar.h"
+
+#include "shared/build_info.h"
+#include "shared/misc.h"
+#include "shared/packet.h"
+
+#include "bridge/entity_tracker.h"
+
+static convar_int_t entity_test_steps("entity_test_steps", 20000, 1, 10000000, "Number of entity packets to replay", CONVAR_FLAG_CLI_ONLY);
+
+static convar_int_t entity_test_history {
+    "entity_test_history",
+    64,
+    1,
+    1048576,
+    "Maximum number of destroyed entities to keep (Small so that trimming happens many times over the run)",
+    CONVAR_FLAG_CLI_ONLY,
+};
+
+/**
+ * Replays a randomized stream of entity packets through the packet parser and entity_tracker_t,
+ * and compares the tracked entities against a simple model of what the server did
+ *
+ * @returns Number of failed checks
+ */
+static int test_entities()
+{
+    struct model_ent_t
+    {
+        int x, y, z;
+    };
+    std::unordered_map<int, model_ent_t> model;
+    std::vector<Uint8> stream;
+    Uint64 r_state = 0x0b181b181b181b18;
+
+    const int num_steps = entity_test_steps.get();
+    const int max_eid = 512;
+    for (int i = 0; i < num_steps; i++)
+    {
+        const int eid = SDL_rand_r(&r_state, max_eid);
+        auto it = model.find(eid);
+        std::vector<Uint8> dat;
+
+        switch (SDL_rand_r(&r_state, 4))
+        {
+        case 0: /* Spawn (Or respawn over a live entity) */
+        {
+            packet_ent_spawn_named_t p;
+            p.eid = eid;
+            p.name = "test";
+            p.x = SDL_rand_r(&r_state, 65536) - 32768;
+            p.y = SDL_rand_r(&r_state, 4096);
+            p.z = SDL_rand_r(&r_state, 65536) - 32768;
+            model[eid] = { p.x, p.y, p.z };
+            dat = p.assemble();
+            break;
+        }
+        case 1: /* Relative move (Ignored for dead entities) */
+        {
+            packet_ent_move_rel_t p;
+            p.eid = eid;
+            p.delta_x = SDL_rand_r(&r_state, 256) - 128;
+            p.delta_y = SDL_rand_r(&r_state, 256) - 128;
+            p.delta_z = SDL_rand_r(&r_state, 256) - 128;
+            if (it != model.end())
+            {
+                it->second.x += p.delta_x;
+                it->second.y += p.delta_y;
+                it->second.z += p.delta_z;
+            }
+            dat = p.assemble();
+            break;
+        }
+        case 2: /* Teleport (Ignored for dead entities) */
+        {
+            packet_ent_teleport_t p;
+            p.eid = eid;
+            p.x = SDL_rand_r(&r_state, 65536) - 32768;
+            p.y = SDL_rand_r(&r_state, 4096);
+            p.z = SDL_rand_r(&r_state, 65536) - 32768;
+            if (it != model.end())
+                it->second = { p.x, p.y, p.z };
+            dat = p.assemble();
+            break;
+        }
+        default: /* Destroy (Including entities that were never seen) */
+        {
+            packet_ent_destroy_t p;
+            p.eid = eid;
+            model.erase(eid);
+            dat = p.assemble();
+            break;
+        }
+        }
+
+        stream.insert(stream.end(), dat.begin(), dat.end());
+    }
+
+    const size_t history_limit = size_t(entity_test_history.get());
+
+    /* Fed in uneven pieces so that packets get split the same way they do over a socket */
+    entity_tracker_t tracker;
+    packet_handler_t handler(false);
+    size_t num_packs = 0;
+    for (size_t off = 0; off < stream.size() && !handler.get_error().length();)
+    {
+        const size_t len = SDL_min(size_t(SDL_rand_r(&r_state, 300) + 1), stream.size() - off);
+        handler.feed_bytes(stream.data() + off, len);
+        off += len;
+
+        while (packet_t* pack = handler.get_next_packet())
+        {
+            tracker.feed_packet_from_server(pack, num_packs++, history_limit);
+            delete pack;
+        }
+    }
+
+    int failed = 0;
+#define CHECK(cond, fmt, ...)                          \
+    do                                                 \
+    {                                                  \
+        if (!(cond))                                   \
+        {                                              \
+            dc_log_error("FAIL: " fmt, ##__VA_ARGS__); \
+            failed++;                                  \
+        }                                              \
+    } while (0)
+
+    CHECK(!handler.get_error().length(), "Packet parser error: %s", handler.get_error().c_str());
+    CHECK(handler.get_bytes_pending() == 0, "%zu bytes left unparsed", handler.get_bytes_pending());
+    CHECK(tracker.entity_map.size() == model.size(), "Tracking %zu live entities, expected %zu", tracker.entity_map.size(), model.size());
+    CHECK(tracker.entities_destroyed <= history_limit, "Kept %zu destroyed entities, limit: %zu", tracker.entities_destroyed, history_limit);
+    CHECK(tracker.entities.size() == tracker.entity_map.size() + tracker.entities_destroyed, "entities.size(): %zu, live: %zu, destroyed: %zu",
+        tracker.entities.size(), tracker.entity_map.size(), tracker.entities_destroyed);
+
+    size_t mismatches = 0;
+    for (const auto& it : model)
+    {
+        entity_info_t* e = tracker.find_entity(it.first);
+        if (!e || e->eid != it.first || e->pack_destruction != CAPTURE_IDX_NONE || e->pos_x != it.second.x || e->pos_y != it.second.y
+            || e->pos_z != it.second.z)
+            mismatches++;
+    }
+    CHECK(mismatches == 0, "%zu live entities are missing or have the wrong position", mismatches);
+#undef CHECK
+
+    dc_log("Replayed %zu packets (%zu bytes): %zu live entities, %zu destroyed entities kept, %d failed checks", num_packs, stream.size(),
+        tracker.entity_map.size(), tracker.entities_destroyed, failed);
+
+    return failed;
+}
+
+int main(int argc, const char** argv)
+{
+    /* KDevelop fully buffers the output and will not display anything */
+    setvbuf(stdout, NULL, _IONBF, 0);
+    setvbuf(stderr, NULL, _IONBF, 0);
+
+    dc_log("mcs_b181_entity_test (%s)-%s (%s)", build_info::ver_string::bridge().c_str(), build_info::build_mode, build_info::git::refspec);
+
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_NAME_STRING, "mcs_b181_entity_test");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_VERSION_STRING, build_info::ver_string::bridge().c_str());
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_IDENTIFIER_STRING, "net.icrashstuff.mcs_b181_entity_test");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_CREATOR_STRING, "Ian Hangartner (icrashstuff)");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_COPYRIGHT_STRING, "Copyright (c) 2024-2025 Ian Hangartner (icrashstuff)");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_URL_STRING, "https://github.com/icrashstuff/mcs_b181");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_TYPE_STRING, "application");
+
+    tetra::init("icrashstuff", "mcs_b181", "mcs_b181_entity_test", argc, argv);
+
+    const int failed = test_entities();
+
+    tetra::deinit();
+
+    return failed ? 1 : 0;
+}
@@ -1,2 +1,2 @@
 #!/bin/bash
-exec clang-format --verbose -i {client\/{,gpu/,shaders/,sys/,gui/,sound/sound_,lang/},shared/,server/,bridge/}*.{c,h,cpp}
+exec clang-format --verbose -i {client\/{,gpu/,shaders/,sys/,gui/,sound/sound_,lang/},shared/,server/,bridge/,replay/,mesh_bench/,entity_test/}*.{c,h,cpp}
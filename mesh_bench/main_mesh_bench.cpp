@@ -0,0 +1,935 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <string>
+#include <vector>
+
+#include "tetra/log.h"
+#include "tetra/tetra_core.h"
+#include "tetra/util/convar.h"
+
+#include "shared/build_info.h"
+#include "shared/capture.h"
+#include "shared/misc.h"
+#include "shared/packet.h"
+
+#include "client/chunk_cubic.h"
+#include "client/chunk_decompress.h"
+#include "client/chunk_grid.h"
+#include "client/frame_budget.h"
+#include "client/frustum.h"
+#include "client/level.h"
+#include "client/light_test_worlds.h"
+#include "client/texture_terrain.h"
+
+static convar_int_t mesh_bench_world {
+    "mesh_bench_world",
+    0,
+    0,
+    2,
+    "0: Decorated simplex light test world, 1: SDL_rand light test world, 2: Chunks decompressed from a capture (See mesh_bench_capture)",
+    CONVAR_FLAG_CLI_ONLY,
+};
+
+static convar_int_t mesh_bench_size_xz("mesh_bench_size_xz", 16, 1, 64, "Horizontal size of the light test worlds (in chunks)", CONVAR_FLAG_CLI_ONLY);
+
+static convar_int_t mesh_bench_size_y("mesh_bench_size_y", 8, 1, 32, "Vertical size of the light test worlds (in chunks)", CONVAR_FLAG_CLI_ONLY);
+
+static convar_string_t mesh_bench_capture(
+    "mesh_bench_capture", "", "Path of the capture to take chunks from (Without the \".idx\"/\".dat\" extension)", CONVAR_FLAG_CLI_ONLY);
+
+static convar_int_t mesh_bench_iterations("mesh_bench_iterations", 5, 1, 1000, "Number of times to relight and remesh the world", CONVAR_FLAG_CLI_ONLY);
+
+static convar_int_t mesh_bench_light_threads {
+    "mesh_bench_light_threads",
+    -1,
+    -1,
+    64,
+    "Number of threads to propagate light on (-1: All but one logical core, 0: Main thread only)",
+    CONVAR_FLAG_CLI_ONLY,
+};
+
+static convar_int_t mesh_bench_mesh_threads {
+    "mesh_bench_mesh_threads",
+    0,
+    -1,
+    64,
+    "Number of threads to build meshes on (-1: All but one logical core, 0: Main thread only)",
+    CONVAR_FLAG_CLI_ONLY,
+};
+
+static convar_float_t mesh_bench_budget_ms {
+    "mesh_bench_budget_ms",
+    4.0f,
+    0.1f,
+    100.0f,
+    "Frame budget of the scheduler test (See: r_chunk_budget_ms)",
+    CONVAR_FLAG_CLI_ONLY,
+};
+
+/**
+ * Collection of time samples (nanoseconds)
+ */
+struct time_samples_t
+{
+    std::vector<Uint64> samples;
+    Uint64 total = 0;
+
+    /** Number of chunks processed over all samples */
+    size_t built = 0;
+
+    inline void add(const Uint64 ns, const size_t num_built)
+    {
+        samples.push_back(ns);
+        total += ns;
+        built += num_built;
+    }
+
+    /**
+     * Log the average, a few percentiles, and the number of chunks processed per iteration
+     *
+     * NOTE: Sorts the samples
+     */
+    void log(const char* name)
+    {
+        if (samples.empty())
+        {
+            dc_log("%-20s: No samples", name);
+            return;
+        }
+
+        std::sort(samples.begin(), samples.end());
+
+        auto percentile = [&](const double pct) -> double {
+            size_t idx = size_t(double(samples.size() - 1) * pct / 100.0);
+            return double(samples[idx]) / 1000000.0;
+        };
+
+        dc_log("%-20s: avg: %.3f ms, min: %.3f ms, p50: %.3f ms, max: %.3f ms (%zu chunks per iteration)", name,
+            double(total) / double(samples.size()) / 1000000.0, percentile(0), percentile(50), percentile(100), built / samples.size());
+    }
+};
+
+/**
+ * FNV-1a
+ */
+static Uint64 hash_bytes(Uint64 hash, const void* const data, const size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ Uint64(((const Uint8*)data)[i])) * 0x100000001b3;
+    return hash;
+}
+
+static const Uint64 HASH_BASIS = 0xcbf29ce484222325;
+
+/**
+ * Fill a vector with the chunks of a capture
+ *
+ * @returns false on failure
+ */
+static bool load_capture(const std::string& path, std::vector<chunk_cubic_t*>& chunks)
+{
+    capture_t capture;
+    if (!capture.open(path))
+    {
+        dc_log_error("Unable to open capture \"%s\"", path.c_str());
+        return false;
+    }
+
+    chunk_grid_t grid;
+    auto lookup = [&](const glm::ivec3 cpos, const bool create) -> chunk_cubic_t* {
+        chunk_cubic_t* c = grid.find(cpos);
+        if (c || !create)
+            return c;
+
+        c = new chunk_cubic_t();
+        c->pos = cpos;
+        grid.insert(c);
+        chunks.push_back(c);
+        return c;
+    };
+
+    packet_handler_t handler(false);
+    std::vector<Uint8> decompression_buffer;
+    Uint64 chunk_errors = 0;
+
+    for (size_t i = 0; i < capture.size(); i++)
+    {
+        const capture_t::index_entry_t entry = capture.get_entry(i);
+        if (entry.from_client)
+            continue;
+
+        const Uint8* data = capture.get_data(entry);
+        if (!data)
+        {
+            dc_log_error("Missing data for packet %zu", i);
+            break;
+        }
+
+        handler.feed_bytes(data, entry.len);
+        packet_t* pack = handler.get_next_packet();
+        if (!pack)
+        {
+            dc_log_error("Unable to parse packet %zu (0x%02x): %s", i, entry.id, handler.get_error().length() ? handler.get_error().c_str() : "Incomplete packet");
+            break;
+        }
+
+        if (pack->id == PACKET_ID_CHUNK_MAP && !decompress_chunk_packet((packet_chunk_t*)pack, decompression_buffer, lookup))
+            chunk_errors++;
+
+        handler.free_packet(pack);
+    }
+
+    capture.close();
+
+    dc_log("Decompressed %zu chunks from \"%s\" (%lu errors)", chunks.size(), path.c_str(), (unsigned long)chunk_errors);
+
+    return chunks.size();
+}
+
+/**
+ * Frustum test done in clip space, independent of the planes frustum_t extracts
+ *
+ * The box is outside if all 8 corners are outside of the same clip plane (-w <= x <= w, -w <= y <= w, 0 <= z <= w)
+ *
+ * @param mat_proj_view Projection matrix multiplied by view matrix
+ *
+ * @returns 1 if the box may be visible, 0 if it is outside, -1 if it is too close to a plane to tell with floats
+ */
+static int clip_space_test_aabb(const glm::mat4& mat_proj_view, const glm::vec3 min, const glm::vec3 max)
+{
+    glm::vec4 clip[8];
+    for (int i = 0; i < 8; i++)
+        clip[i] = mat_proj_view * glm::vec4((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, 1.0f);
+
+    bool close = 0;
+    for (int plane = 0; plane < 6; plane++)
+    {
+        int num_outside = 0;
+        int num_close = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            const glm::vec4 c = clip[i];
+            const float dist[6] = { c.w + c.x, c.w - c.x, c.w + c.y, c.w - c.y, c.z, c.w - c.z };
+            const float epsilon = (SDL_fabsf(c.x) + SDL_fabsf(c.y) + SDL_fabsf(c.z) + SDL_fabsf(c.w)) * 1e-4f;
+            if (dist[plane] < -epsilon)
+                num_outside++;
+            else if (dist[plane] <= epsilon)
+                num_close++;
+        }
+
+        if (num_outside == 8)
+            return 0;
+        close = close || (num_outside + num_close == 8);
+    }
+
+    return close ? -1 : 1;
+}
+
+/**
+ * Light the chunks in a dirty list the same way level_t::build_dirty_meshes() does (See: level_t::take_dirty_chunks())
+ *
+ * @param dirty Dirty list (In priority order), replaced with the chunks that did not fit
+ * @param max_chunks Maximum number of chunks to light (See: level_t::propagate_dirty_levels())
+ * @param light_threads Number of threads to light on
+ * @param deferred_raised Output (optional), incremented for every chunk handed back with a different dirty level than it was queued with
+ *
+ * @returns Number of chunks that needed light (What max_chunks counts)
+ */
+static size_t light_dirty_list(std::vector<chunk_cubic_t*>& dirty, const size_t max_chunks, const int light_threads, size_t* const deferred_raised = NULL)
+{
+    std::vector<chunk_cubic_t*> queued;
+    std::vector<chunk_cubic_t::dirty_level_t> queued_levels;
+    if (deferred_raised)
+    {
+        queued = dirty;
+        for (chunk_cubic_t* c : dirty)
+            queued_levels.push_back(c->dirty_level);
+    }
+
+    std::vector<chunk_cubic_t*> taken;
+    level_t::take_dirty_chunks(dirty, max_chunks, taken);
+
+    /* A raised chunk has already spread its dirty level to chunks that are lit now, so it has to be lit with them
+     * (The chunks handed back keep their order from the dirty list) */
+    if (deferred_raised)
+    {
+        for (size_t i = 0, j = 0; i < queued.size() && j < dirty.size(); i++)
+        {
+            if (queued[i] != dirty[j])
+                continue;
+            *deferred_raised += dirty[j]->dirty_level != queued_levels[i];
+            j++;
+        }
+    }
+
+    std::vector<chunk_cubic_t*> chunks_needing_light;
+    level_t::light_clear_pass(taken, chunks_needing_light);
+    const level_t::light_waves_t waves = level_t::build_light_waves(chunks_needing_light);
+    level_t::light_pass(waves, chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL, light_threads);
+    level_t::light_pass(waves, chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_0, light_threads);
+    level_t::light_pass(waves, chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_1, light_threads);
+
+    return chunks_needing_light.size();
+}
+
+/**
+ * Per chunk result of the mesh pass
+ */
+struct mesh_result_t
+{
+    Uint64 hash = HASH_BASIS;
+    size_t quads = 0;
+    bool built = 0;
+};
+
+/**
+ * Mesh a chunk the same way the mesh workers do, with the climate colors replaced by a constant
+ *
+ * @param c Chunk to mesh (The neighborhood must be linked)
+ * @param terrain Atlas to mesh with
+ *
+ * @returns Hash and quad count of the mesh
+ */
+static mesh_result_t mesh_chunk(chunk_cubic_t* const c, texture_terrain_t* const terrain)
+{
+    level_t::mesh_snapshot_t snapshot;
+
+    for (int i = 0; i < 27; i++)
+        snapshot.rubik[i / 9][(i / 3) % 3][i % 3] = c->neighborhood[i / 9][(i / 3) % 3][i % 3];
+    snapshot.owns_chunks = false;
+
+    /* Climate generation needs a level, and is already covered by profile_mesh in the client */
+    for (int i = 0; i < 18; i++)
+        for (int j = 0; j < 18; j++)
+            snapshot.biome_colors[i][j] = glm::vec3(0.51f, 0.77f, 0.26f);
+
+    snapshot.pos = c->pos;
+    snapshot.terrain = terrain;
+    snapshot.smooth_lighting = convar_t::get_convar_int("r_smooth_lighting")->get();
+    snapshot.biome_blend = convar_t::get_convar_int("r_biome_blend_limit")->get();
+    snapshot.greedy_mesh = convar_t::get_convar_int("r_greedy_mesh")->get();
+
+    level_t::mesh_queue_info_t queue_info = {};
+    level_t::build_mesh_from_snapshot(snapshot, queue_info);
+
+    mesh_result_t ret;
+    ret.built = 1;
+    ret.quads = queue_info.quad_count_opaque + queue_info.quad_count_alpha_test + queue_info.quad_count_overlay + queue_info.quad_count_translucent;
+
+    const Uint32 quad_counts[] = {
+        queue_info.quad_count_opaque,
+        queue_info.quad_count_alpha_test,
+        queue_info.quad_count_overlay,
+        queue_info.quad_count_translucent,
+    };
+    ret.hash = hash_bytes(ret.hash, quad_counts, sizeof(quad_counts));
+    if (queue_info.vertex_data)
+        ret.hash = hash_bytes(ret.hash, queue_info.vertex_data, queue_info.vertex_data_size);
+
+    queue_info.release_data();
+
+    return ret;
+}
+
+int main(int argc, const char** argv)
+{
+    /* KDevelop fully buffers the output and will not display anything */
+    setvbuf(stdout, NULL, _IONBF, 0);
+    setvbuf(stderr, NULL, _IONBF, 0);
+
+    dc_log("mcs_b181_mesh_bench (%s)-%s (%s)", build_info::ver_string::client().c_str(), build_info::build_mode, build_info::git::refspec);
+
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_NAME_STRING, "mcs_b181_mesh_bench");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_VERSION_STRING, build_info::ver_string::client().c_str());
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_IDENTIFIER_STRING, "net.icrashstuff.mcs_b181_mesh_bench");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_CREATOR_STRING, "Ian Hangartner (icrashstuff)");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_COPYRIGHT_STRING, "Copyright (c) 2024-2025 Ian Hangartner (icrashstuff)");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_URL_STRING, "https://github.com/icrashstuff/mcs_b181");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_TYPE_STRING, "application");
+
+    tetra::init("icrashstuff", "mcs_b181", "mcs_b181_mesh_bench", argc, argv);
+
+    std::vector<chunk_cubic_t*> chunks;
+    const glm::ivec3 world_size(mesh_bench_size_xz.get(), mesh_bench_size_y.get(), mesh_bench_size_xz.get());
+    switch (mesh_bench_world.get())
+    {
+    case 0:
+        chunks = create_light_test_decorated_simplex(world_size);
+        break;
+    case 1:
+        chunks = create_light_test_sdl_rand(world_size);
+        break;
+    default:
+        if (!mesh_bench_capture.get().length())
+            dc_log_error("No capture specified (Set the convar \"%s\")", mesh_bench_capture.get_name());
+        else
+            load_capture(mesh_bench_capture.get(), chunks);
+        break;
+    }
+
+    if (chunks.empty())
+    {
+        dc_log_error("World is empty");
+        tetra::deinit();
+        return 1;
+    }
+
+    /* Link the neighbor tables, with the grid window covering the whole world */
+    glm::ivec3 pos_min = chunks[0]->pos;
+    glm::ivec3 pos_max = chunks[0]->pos;
+    for (chunk_cubic_t* c : chunks)
+        pos_min = glm::min(pos_min, c->pos), pos_max = glm::max(pos_max, c->pos);
+
+    chunk_grid_t grid;
+    const glm::ivec3 half_extent = (pos_max - pos_min + 1) / 2;
+    grid.recenter((pos_min + pos_max) / 2, SDL_max(SDL_max(half_extent.x, half_extent.y), half_extent.z) + 1);
+    for (chunk_cubic_t* c : chunks)
+        grid.insert(c);
+    for (chunk_cubic_t* c : chunks)
+        grid.link_neighbors(c);
+
+    /* The vertex hash is combined in light order, so the order the chunks were generated in does not matter */
+    level_t::sort_light_order(chunks);
+
+    texture_terrain_t terrain;
+
+    int light_threads = mesh_bench_light_threads.get();
+    if (light_threads < 0)
+        light_threads = SDL_GetNumLogicalCPUCores() - 1;
+
+    int mesh_threads = mesh_bench_mesh_threads.get();
+    if (mesh_threads < 0)
+        mesh_threads = SDL_GetNumLogicalCPUCores() - 1;
+
+    dc_log("World: %zu chunks, <%d, %d, %d> to <%d, %d, %d>, light threads: %d, mesh threads: %d", chunks.size(), pos_min.x, pos_min.y, pos_min.z,
+        pos_max.x, pos_max.y, pos_max.z, light_threads, mesh_threads);
+
+    time_samples_t time_hints;
+    time_samples_t time_dirty;
+    time_samples_t time_clear;
+    time_samples_t time_light[3];
+    time_samples_t time_mesh;
+    size_t quads_total = 0;
+
+    std::vector<Uint64> hashes;
+    std::vector<mesh_result_t> results;
+
+    for (int it = 0; it < mesh_bench_iterations.get(); it++)
+    {
+        for (chunk_cubic_t* c : chunks)
+        {
+            c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL;
+            c->renderer_hints.hints_set = 0;
+        }
+
+        Uint64 tick_start = SDL_GetTicksNS();
+        for (chunk_cubic_t* c : chunks)
+            c->update_renderer_hints();
+        time_hints.add(SDL_GetTicksNS() - tick_start, chunks.size());
+
+        tick_start = SDL_GetTicksNS();
+        const size_t num_propagated = level_t::propagate_dirty_levels(chunks);
+        time_dirty.add(SDL_GetTicksNS() - tick_start, num_propagated);
+
+        std::vector<chunk_cubic_t*> chunks_needing_light;
+        tick_start = SDL_GetTicksNS();
+        const size_t num_cleared = level_t::light_clear_pass(chunks, chunks_needing_light);
+        const level_t::light_waves_t waves = level_t::build_light_waves(chunks_needing_light);
+        time_clear.add(SDL_GetTicksNS() - tick_start, num_cleared);
+
+        const chunk_cubic_t::dirty_level_t light_levels[] = {
+            chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL,
+            chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_0,
+            chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_EXT_1,
+        };
+        for (int i = 0; i < int(SDL_arraysize(light_levels)); i++)
+        {
+            tick_start = SDL_GetTicksNS();
+            const size_t num_lit = level_t::light_pass(waves, light_levels[i], light_threads);
+            time_light[i].add(SDL_GetTicksNS() - tick_start, num_lit);
+        }
+
+        results.assign(chunks.size(), mesh_result_t());
+        auto mesh_range = [&](const int _start, const int _end) {
+            for (int i = _start; i < _end; i++)
+                if (chunks[i]->dirty_level == chunk_cubic_t::DIRTY_LEVEL_MESH)
+                    results[i] = mesh_chunk(chunks[i], &terrain);
+        };
+
+        tick_start = SDL_GetTicksNS();
+        if (mesh_threads > 1)
+            util::parallel_for(0, int(chunks.size()), mesh_range, mesh_threads);
+        else
+            mesh_range(0, int(chunks.size()));
+        const Uint64 elapsed_mesh = SDL_GetTicksNS() - tick_start;
+
+        Uint64 hash = HASH_BASIS;
+        size_t num_meshed = 0;
+        size_t quads = 0;
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            if (!results[i].built)
+                continue;
+            chunks[i]->dirty_level = chunk_cubic_t::DIRTY_LEVEL_NONE;
+            hash = hash_bytes(hash, &chunks[i]->pos, sizeof(chunks[i]->pos));
+            hash = hash_bytes(hash, &results[i].hash, sizeof(results[i].hash));
+            quads += results[i].quads;
+            num_meshed++;
+        }
+        time_mesh.add(elapsed_mesh, num_meshed);
+        quads_total += quads;
+        hashes.push_back(hash);
+
+        dc_log("Iteration %d: Lit %zu chunks, meshed %zu chunks (%zu quads) in %.2f ms, vertex hash: %016lx", it, waves.chunks.size(), num_meshed, quads,
+            elapsed_mesh / 1000000.0, hash);
+    }
+
+    /* Greedy merging must not change what is drawn, so every chunk is meshed with and without merging and the face coverage compared */
+    size_t quads_greedy[2] = { 0, 0 };
+    Uint64 greedy_mismatches = 0;
+    {
+        convar_int_t* greedy_mesh = convar_t::get_convar_int("r_greedy_mesh");
+        convar_int_t* greedy_mesh_verify = convar_t::get_convar_int("r_greedy_mesh_verify");
+        const int greedy_mesh_old = greedy_mesh->get();
+        const int greedy_mesh_verify_old = greedy_mesh_verify->get();
+
+        const Uint64 mismatches_old = level_t::get_greedy_mesh_mismatches();
+        for (int greedy = 0; greedy < 2; greedy++)
+        {
+            greedy_mesh->set(greedy);
+            greedy_mesh_verify->set(greedy);
+            for (chunk_cubic_t* c : chunks)
+                quads_greedy[greedy] += mesh_chunk(c, &terrain).quads;
+        }
+        greedy_mismatches = level_t::get_greedy_mesh_mismatches() - mismatches_old;
+
+        greedy_mesh->set(greedy_mesh_old);
+        greedy_mesh_verify->set(greedy_mesh_verify_old);
+    }
+
+    /* Light kernels, the vectorized kernels must produce exactly the same light data as the scalar reference */
+    time_samples_t time_kernel_scalar;
+    time_samples_t time_kernel_vector;
+    size_t kernel_mismatches = 0;
+    for (int it = 0; it < mesh_bench_iterations.get(); it++)
+    {
+        Uint64 duration_scalar = 0;
+        Uint64 duration_vector = 0;
+        for (chunk_cubic_t* c : chunks)
+        {
+            /* Every chunk is put back the way it was, so that its neighbors grab from a fully lit world */
+            Uint8 old_block[sizeof(c->data_light_block)];
+            Uint8 old_sky[sizeof(c->data_light_sky)];
+            memcpy(old_block, c->data_light_block, sizeof(old_block));
+            memcpy(old_sky, c->data_light_sky, sizeof(old_sky));
+
+            c->clear_light_block(0);
+            c->light_pass_block_setup();
+            c->clear_light_sky(0);
+            c->light_pass_block_grab_from_neighbors();
+            c->light_pass_sky_grab_from_neighbors();
+
+            Uint8 in_block[sizeof(c->data_light_block)];
+            Uint8 in_sky[sizeof(c->data_light_sky)];
+            memcpy(in_block, c->data_light_block, sizeof(in_block));
+            memcpy(in_sky, c->data_light_sky, sizeof(in_sky));
+
+            Uint64 tick_start = SDL_GetTicksNS();
+            c->light_pass_block_propagate_internals_scalar();
+            c->light_pass_sky_propagate_internals_scalar();
+            duration_scalar += SDL_GetTicksNS() - tick_start;
+
+            Uint8 ref_block[sizeof(c->data_light_block)];
+            Uint8 ref_sky[sizeof(c->data_light_sky)];
+            memcpy(ref_block, c->data_light_block, sizeof(ref_block));
+            memcpy(ref_sky, c->data_light_sky, sizeof(ref_sky));
+            memcpy(c->data_light_block, in_block, sizeof(in_block));
+            memcpy(c->data_light_sky, in_sky, sizeof(in_sky));
+
+            tick_start = SDL_GetTicksNS();
+            c->light_pass_block_propagate_internals();
+            c->light_pass_sky_propagate_internals();
+            duration_vector += SDL_GetTicksNS() - tick_start;
+
+            if (memcmp(ref_block, c->data_light_block, sizeof(ref_block)) || memcmp(ref_sky, c->data_light_sky, sizeof(ref_sky)))
+                kernel_mismatches++;
+
+            memcpy(c->data_light_block, old_block, sizeof(old_block));
+            memcpy(c->data_light_sky, old_sky, sizeof(old_sky));
+        }
+        time_kernel_scalar.add(duration_scalar, chunks.size());
+        time_kernel_vector.add(duration_vector, chunks.size());
+    }
+
+    /* Visibility from each chunk of the center column, without any frustum culling */
+    time_samples_t time_cave;
+    const glm::ivec3 pos_center = (pos_min + pos_max) / 2;
+    for (int y = pos_min.y; y <= pos_max.y; y++)
+    {
+        chunk_cubic_t* const origin = grid.find(glm::ivec3(pos_center.x, y, pos_center.z));
+        if (!origin)
+            continue;
+
+        for (chunk_cubic_t* c : chunks)
+            c->visible = 1;
+
+        const Uint64 tick_start = SDL_GetTicksNS();
+        const size_t num_reached = level_t::cave_cull(chunks, origin);
+        time_cave.add(SDL_GetTicksNS() - tick_start, num_reached);
+
+        dc_log("Cave culling from <%d, %d, %d>: %zu of %zu chunks visible", origin->pos.x, origin->pos.y, origin->pos.z, num_reached, chunks.size());
+    }
+
+    /* Frustum culling from random cameras, the batched test has to exactly match the reference test, and agree with a clip space test */
+    time_samples_t time_frustum;
+    size_t frustum_mismatches = 0;
+    size_t frustum_clip_mismatches = 0;
+    size_t frustum_clip_close = 0;
+    {
+        std::vector<float> corner_x(chunks.size()), corner_y(chunks.size()), corner_z(chunks.size());
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            corner_x[i] = chunks[i]->pos.x * SUBCHUNK_SIZE_X;
+            corner_y[i] = chunks[i]->pos.y * SUBCHUNK_SIZE_Y;
+            corner_z[i] = chunks[i]->pos.z * SUBCHUNK_SIZE_Z;
+        }
+
+        std::vector<Uint8> frustum_results(chunks.size());
+        const glm::vec3 world_min(pos_min << 4);
+        const glm::vec3 world_extent((pos_max - pos_min + 1) << 4);
+        Uint64 r_state = 0;
+
+        for (int it = 0; it < mesh_bench_iterations.get() * 16; it++)
+        {
+            const glm::vec3 eye = world_min + glm::vec3(SDL_randf_r(&r_state), SDL_randf_r(&r_state), SDL_randf_r(&r_state)) * world_extent;
+            const float yaw = glm::radians(SDL_randf_r(&r_state) * 360.0f);
+            const float pitch = glm::radians((SDL_randf_r(&r_state) - 0.5f) * 178.0f);
+            const glm::vec3 dir(SDL_cosf(yaw) * SDL_cosf(pitch), SDL_sinf(pitch), SDL_sinf(yaw) * SDL_cosf(pitch));
+
+            /* Same projection as level_t::get_mat_proj() with a render distance of 8 */
+            const glm::mat4 mat_proj = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 8 * 32.0f, 1.f / 16.f);
+            const glm::mat4 mat_proj_view = mat_proj * glm::lookAt(eye, eye + dir, glm::vec3(0.0f, 1.0f, 0.0f));
+            const frustum_t frustum(mat_proj_view);
+
+            const Uint64 tick_start = SDL_GetTicksNS();
+            frustum.test_cubes(corner_x.data(), corner_y.data(), corner_z.data(), SUBCHUNK_SIZE_X, chunks.size(), frustum_results.data());
+            const Uint64 elapsed = SDL_GetTicksNS() - tick_start;
+
+            size_t num_visible = 0;
+            for (size_t i = 0; i < chunks.size(); i++)
+            {
+                const glm::vec3 corner(corner_x[i], corner_y[i], corner_z[i]);
+                num_visible += frustum_results[i];
+                frustum_mismatches += (frustum_results[i] != frustum.test_aabb(corner, corner + float(SUBCHUNK_SIZE_X)));
+
+                const int clip_result = clip_space_test_aabb(mat_proj_view, corner, corner + float(SUBCHUNK_SIZE_X));
+                if (clip_result < 0)
+                    frustum_clip_close++;
+                else
+                    frustum_clip_mismatches += (frustum_results[i] != clip_result);
+            }
+            time_frustum.add(elapsed, num_visible);
+        }
+    }
+
+    /* Scheduler: a synthetic stream of block changes is lit and meshed within a per-frame budget, the same way level_t::build_dirty_meshes() does */
+    time_samples_t time_sched;
+    size_t sched_frames_over = 0;
+    Uint64 sched_p95_ns = 0;
+    Uint64 sched_max_ns = 0;
+    size_t sched_light_darker = 0;
+    size_t sched_light_brighter = 0;
+    size_t sched_deferred_raised = 0;
+    bool sched_drained = 0;
+    const Uint64 sched_budget_ns = Uint64(mesh_bench_budget_ms.get() * 1000000.0f);
+    {
+        /* Sorted by distance from the center once, which stands in for level_t::chunks_render_order */
+        std::vector<chunk_cubic_t*> chunks_by_distance = chunks;
+        auto dist_squared = [&pos_center](const chunk_cubic_t* const c) {
+            const glm::ivec3 d = c->pos - pos_center;
+            return d.x * d.x + d.y * d.y + d.z * d.z;
+        };
+        std::stable_sort(chunks_by_distance.begin(), chunks_by_distance.end(),
+            [&dist_squared](const chunk_cubic_t* const a, const chunk_cubic_t* const b) { return dist_squared(a) < dist_squared(b); });
+
+        for (chunk_cubic_t* c : chunks)
+            c->dirty_queued = 0;
+
+        frame_budget_t budget;
+        frame_budget_t::cost_t cost_light = { 100000.0 };
+        frame_budget_t::cost_t cost_mesh = { 250000.0 };
+        std::vector<chunk_cubic_t*> dirty;
+        std::vector<Uint64> busy_samples;
+        Uint64 r_state = 0x5ced5ced5ced5ced;
+
+        /* Blocks changed by the stream, along with the type to put back */
+        struct stream_change_t
+        {
+            chunk_cubic_t* c;
+            glm::ivec3 pos;
+            Uint8 type;
+        };
+        std::vector<stream_change_t> changed;
+
+        /* Same as level_t::mark_dirty() */
+        auto mark_dirty = [&dirty](chunk_cubic_t* const c, const chunk_cubic_t::dirty_level_t lvl) {
+            if (c->dirty_level < lvl)
+                c->dirty_level = lvl;
+            if (c->dirty_queued)
+                return;
+            c->dirty_queued = 1;
+            dirty.push_back(c);
+        };
+
+        const int stream_frames = 300;
+        for (int frame = 0; frame < stream_frames * 10; frame++)
+        {
+            /* A trickle of single block changes, with a burst (like a batch of chunk packets) every 100 frames
+             * Light sources are placed and later removed again, and some chunks are only queued for a new mesh (Like level_t::clear_mesh() does),
+             * which leaves seeds in the dirty list that a nearby change can raise */
+            if (frame < stream_frames)
+            {
+                const int num_changed = (frame % 100 == 0) ? int(chunks.size() / 8) : SDL_rand_r(&r_state, 4);
+                for (int i = 0; i < num_changed; i++)
+                {
+                    stream_change_t change;
+                    if (SDL_rand_r(&r_state, 4) == 0)
+                    {
+                        mark_dirty(chunks[SDL_rand_r(&r_state, int(chunks.size()))], chunk_cubic_t::DIRTY_LEVEL_MESH);
+                        continue;
+                    }
+
+                    if (changed.size() && SDL_rand_r(&r_state, 2))
+                    {
+                        const size_t idx = SDL_rand_r(&r_state, int(changed.size()));
+                        change = changed[idx];
+                        changed[idx] = changed.back();
+                        changed.pop_back();
+                    }
+                    else
+                    {
+                        change.c = chunks[SDL_rand_r(&r_state, int(chunks.size()))];
+                        change.pos.x = SDL_rand_r(&r_state, SUBCHUNK_SIZE_X);
+                        change.pos.y = SDL_rand_r(&r_state, SUBCHUNK_SIZE_Y);
+                        change.pos.z = SDL_rand_r(&r_state, SUBCHUNK_SIZE_Z);
+                        change.type = SDL_rand_r(&r_state, 2) ? BLOCK_ID_GLOWSTONE : BLOCK_ID_TORCH;
+                    }
+
+                    const Uint8 old_type = change.c->get_type(change.pos.x, change.pos.y, change.pos.z);
+                    change.c->set_type(change.pos.x, change.pos.y, change.pos.z, change.type);
+                    change.c->update_renderer_hints();
+                    change.type = old_type;
+                    changed.push_back(change);
+
+                    /* Light from the changed block can reach further than the dirty level of one chunk spreads,
+                     * so the whole neighborhood is marked, the same way level_t::set_block() does without incremental relighting */
+                    for (int n = 0; n < 27; n++)
+                        if (chunk_cubic_t* c = change.c->neighborhood[n / 9][(n / 3) % 3][n % 3])
+                            mark_dirty(c, chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL);
+                }
+            }
+
+            bool mesh_pending = 0;
+            for (chunk_cubic_t* c : chunks)
+                mesh_pending |= c->dirty_level == chunk_cubic_t::DIRTY_LEVEL_MESH;
+            if (frame >= stream_frames && dirty.empty() && !mesh_pending)
+            {
+                sched_drained = 1;
+                break;
+            }
+
+            budget.begin_frame(sched_budget_ns);
+            const Uint64 tick_frame = SDL_GetTicksNS();
+
+            std::stable_sort(dirty.begin(), dirty.end(), [&dist_squared](const chunk_cubic_t* const a, const chunk_cubic_t* const b) {
+                return dist_squared(a) < dist_squared(b);
+            });
+            const size_t num_lit = light_dirty_list(dirty, budget.fit(cost_light, 1, Uint64(cost_mesh.ns_per_item)), light_threads, &sched_deferred_raised);
+            budget.spend(cost_light, SDL_GetTicksNS() - tick_frame, num_lit);
+
+            const Uint64 tick_mesh = SDL_GetTicksNS();
+            const size_t max_meshes = budget.fit(cost_mesh);
+            size_t num_meshed = 0;
+            for (size_t i = 0; i < chunks_by_distance.size() && num_meshed < max_meshes; i++)
+            {
+                chunk_cubic_t* c = chunks_by_distance[i];
+                if (c->dirty_level != chunk_cubic_t::DIRTY_LEVEL_MESH)
+                    continue;
+                mesh_chunk(c, &terrain);
+                c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_NONE;
+                num_meshed++;
+            }
+            budget.spend(cost_mesh, SDL_GetTicksNS() - tick_mesh, num_meshed);
+
+            const Uint64 elapsed = SDL_GetTicksNS() - tick_frame;
+            time_sched.add(elapsed, num_lit + num_meshed);
+            sched_frames_over += elapsed > sched_budget_ns * 2;
+
+            /* Frames with nothing (or only a little) to do would hide the frames that matter */
+            if (num_lit + num_meshed)
+                busy_samples.push_back(elapsed);
+        }
+
+        std::sort(busy_samples.begin(), busy_samples.end());
+        if (busy_samples.size())
+        {
+            sched_p95_ns = busy_samples[(busy_samples.size() - 1) * 95 / 100];
+            sched_max_ns = busy_samples.back();
+        }
+
+        /* A full relight is the reference. It stops after three passes, which can leave it short of light that repeated relights of a region
+         * carry further, so scheduled light may end up brighter in places, but missing light means a chunk was not lit when it had to be */
+        std::vector<Uint8> light_streamed;
+        for (chunk_cubic_t* c : chunks)
+        {
+            light_streamed.insert(light_streamed.end(), c->data_light_block, c->data_light_block + sizeof(c->data_light_block));
+            light_streamed.insert(light_streamed.end(), c->data_light_sky, c->data_light_sky + sizeof(c->data_light_sky));
+        }
+
+        for (chunk_cubic_t* c : chunks)
+            c->dirty_level = chunk_cubic_t::DIRTY_LEVEL_LIGHT_PASS_INTERNAL;
+        std::vector<chunk_cubic_t*> all = chunks;
+        light_dirty_list(all, SIZE_MAX, light_threads);
+
+        size_t pos = 0;
+        for (chunk_cubic_t* c : chunks)
+        {
+            for (int channel = 0; channel < 2; channel++)
+            {
+                const Uint8* light_full = channel ? c->data_light_sky : c->data_light_block;
+                for (size_t i = 0; i < sizeof(c->data_light_block); i++, pos++)
+                {
+                    for (int shift = 0; shift < 8; shift += 4)
+                    {
+                        const int level_streamed = (light_streamed[pos] >> shift) & 0x0F;
+                        const int level_full = (light_full[i] >> shift) & 0x0F;
+                        sched_light_darker += level_streamed < level_full;
+                        sched_light_brighter += level_streamed > level_full;
+                    }
+                }
+            }
+        }
+
+        dc_log("Scheduler: %zu frames, %zu over twice the budget of %.2f ms, drained: %d", time_sched.samples.size(), sched_frames_over,
+            sched_budget_ns / 1000000.0, sched_drained);
+        dc_log("Scheduler: predicted %.2f us per lit chunk, %.2f us per mesh", cost_light.ns_per_item / 1000.0, cost_mesh.ns_per_item / 1000.0);
+        dc_log("Scheduler: %zu frames with work, p95: %.2f ms, max: %.2f ms", busy_samples.size(), sched_p95_ns / 1000000.0, sched_max_ns / 1000000.0);
+        dc_log("Scheduler: %zu light values brighter than a full relight", sched_light_brighter);
+    }
+
+    dc_log("========================== Results ==========================");
+    time_hints.log("Renderer hints");
+    time_dirty.log("Dirty propagation");
+    time_clear.log("Light clear");
+    time_light[0].log("Light pass 1");
+    time_light[1].log("Light pass 2");
+    time_light[2].log("Light pass 3");
+    time_kernel_scalar.log("Light kernel scalar");
+    time_kernel_vector.log("Light kernel vector");
+    time_mesh.log("Mesh");
+    time_cave.log("Cave culling");
+    time_frustum.log("Frustum culling");
+    time_sched.log("Scheduler frame");
+    dc_log("%-20s: %.2f ns/chunk", "Frustum throughput", double(time_frustum.total) / double(SDL_max(time_frustum.samples.size() * chunks.size(), size_t(1))));
+    dc_log("%-20s: %.0f quads/s, %.1f meshes/s", "Mesh throughput", quads_total * 1000000000.0 / double(SDL_max(time_mesh.total, Uint64(1))),
+        time_mesh.built * 1000000000.0 / double(SDL_max(time_mesh.total, Uint64(1))));
+    dc_log("%-20s: %016lx", "Vertex hash", hashes[0]);
+    dc_log("%-20s: %zu -> %zu quads (%.2fx)", "Greedy merging", quads_greedy[0], quads_greedy[1],
+        double(quads_greedy[0]) / double(SDL_max(quads_greedy[1], size_t(1))));
+
+    if (!chunk_cubic_t::light_pass_is_vectorized())
+        dc_log_warn("Vectorized light kernels are not available on this platform, both kernel timings are of the scalar kernels");
+    dc_log("%-20s: %.2fx", "Light kernel speedup", double(time_kernel_scalar.total) / double(SDL_max(time_kernel_vector.total, Uint64(1))));
+
+    int ret = 0;
+    if (kernel_mismatches)
+    {
+        dc_log_error("Vectorized light kernels differ from the scalar reference in %zu chunks!", kernel_mismatches);
+        ret = 1;
+    }
+
+    if (greedy_mismatches)
+    {
+        dc_log_error("Greedy merging changed the face coverage of %lu face groups!", (unsigned long)greedy_mismatches);
+        ret = 1;
+    }
+
+    if (frustum_mismatches)
+    {
+        dc_log_error("Batched frustum test disagreed with the reference test %zu times!", frustum_mismatches);
+        ret = 1;
+    }
+
+    if (frustum_clip_mismatches)
+    {
+        dc_log_error("Batched frustum test disagreed with the clip space test %zu times! (%zu boxes too close to a plane to compare)", frustum_clip_mismatches,
+            frustum_clip_close);
+        ret = 1;
+    }
+
+    /* Some frames over budget are expected, a dirty chunk is always lit together with every chunk its dirty level spreads to and one mesh is always built,
+     * the maximum is only logged since a single frame can be stretched by anything else running on the machine */
+    if (!sched_drained || sched_p95_ns > sched_budget_ns * 2)
+    {
+        dc_log_error("Scheduler did not keep to the budget (p95: %.2f ms, max: %.2f ms, budget: %.2f ms, drained: %d)", sched_p95_ns / 1000000.0,
+            sched_max_ns / 1000000.0, sched_budget_ns / 1000000.0, sched_drained);
+        ret = 1;
+    }
+
+    if (sched_light_darker)
+    {
+        dc_log_error("Light data from the scheduler is darker than a full relight in %zu places!", sched_light_darker);
+        ret = 1;
+    }
+
+    if (sched_deferred_raised)
+    {
+        dc_log_error("Scheduler handed back %zu chunks after spreading their raised dirty level!", sched_deferred_raised);
+        ret = 1;
+    }
+
+    for (const Uint64 hash : hashes)
+    {
+        if (hash == hashes[0])
+            continue;
+        dc_log_error("Vertex hash differs between iterations!");
+        ret = 1;
+        break;
+    }
+
+    for (chunk_cubic_t* c : chunks)
+        delete c;
+
+    tetra::deinit();
+
+    return ret;
+}
@@ -0,0 +1,512 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Replays packet captures written by mcs_b181_bridge
+ *
+ * Server mode: Pushes the client->server half of a capture to a live mcs_b181_server over a socket
+ * Client mode: Feeds the server->client half of a capture into packet_handler_t and the client chunk decoder
+ */
+
+#include "shared/sdl_net/include/SDL3_net/SDL_net.h"
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tetra/log.h"
+#include "tetra/tetra_core.h"
+#include "tetra/util/convar.h"
+
+#include "shared/build_info.h"
+#include "shared/capture.h"
+#include "shared/misc.h"
+#include "shared/packet.h"
+
+#include "client/chunk_cubic.h"
+#include "client/chunk_decompress.h"
+
+static convar_string_t replay_capture("replay_capture", "", "Path of the capture to replay (Without the \".idx\"/\".dat\" extension)", CONVAR_FLAG_CLI_ONLY);
+
+static convar_int_t replay_mode {
+    "replay_mode",
+    0,
+    0,
+    1,
+    "0: Push client->server packets to a server, 1: Feed server->client packets to the client decoding path",
+    CONVAR_FLAG_CLI_ONLY,
+};
+
+static convar_string_t replay_address("replay_address", "127.0.0.1", "Address of the server to replay to (Server mode)", CONVAR_FLAG_CLI_ONLY);
+
+static convar_float_t replay_speed {
+    "replay_speed",
+    1.0f,
+    0.0f,
+    1000.0f,
+    "Timing multiplier for server mode (1.0: Original timing, 0.0: As fast as possible)",
+    CONVAR_FLAG_CLI_ONLY,
+};
+
+static convar_int_t replay_drain_time {
+    "replay_drain_time",
+    2000,
+    0,
+    60000,
+    "Time to keep reading server responses after the last packet was sent (Server mode, milliseconds)",
+    CONVAR_FLAG_CLI_ONLY,
+};
+
+static convar_int_t replay_stats_interval {
+    "replay_stats_interval",
+    1000,
+    0,
+    60000,
+    "Interval between intermediate stat reports (milliseconds, 0 to disable)",
+    CONVAR_FLAG_CLI_ONLY,
+};
+
+/**
+ * Collection of time samples (nanoseconds)
+ */
+struct time_samples_t
+{
+    std::vector<Uint64> samples;
+    Uint64 total = 0;
+
+    inline void add(const Uint64 ns)
+    {
+        samples.push_back(ns);
+        total += ns;
+    }
+
+    /**
+     * Log the count, average and a few percentiles
+     *
+     * NOTE: Sorts the samples
+     */
+    void log(const char* name)
+    {
+        if (samples.empty())
+        {
+            dc_log("%-20s: No samples", name);
+            return;
+        }
+
+        std::sort(samples.begin(), samples.end());
+
+        auto percentile = [&](const double pct) -> double {
+            size_t idx = size_t(double(samples.size() - 1) * pct / 100.0);
+            return double(samples[idx]) / 1000000.0;
+        };
+
+        dc_log("%-20s: n: %zu, avg: %.3f ms, min: %.3f ms, p50: %.3f ms, p99: %.3f ms, max: %.3f ms", name, samples.size(),
+            double(total) / double(samples.size()) / 1000000.0, percentile(0), percentile(50), percentile(99), percentile(100));
+    }
+};
+
+/**
+ * Packet and byte counters for one direction
+ */
+struct traffic_stats_t
+{
+    Uint64 packets = 0;
+    Uint64 bytes = 0;
+
+    inline void add(const size_t len)
+    {
+        packets++;
+        bytes += len;
+    }
+
+    /**
+     * @param name Label for the direction
+     * @param elapsed_ns Time these stats were collected over
+     */
+    void log(const char* name, const Uint64 elapsed_ns) const
+    {
+        const double secs = SDL_max(double(elapsed_ns) / 1000000000.0, 0.000001);
+        dc_log("%-20s: %lu packets (%.1f/s), %.2f MiB (%.2f MiB/s)", name, (unsigned long)packets, double(packets) / secs, double(bytes) / (1024.0 * 1024.0),
+            double(bytes) / (1024.0 * 1024.0) / secs);
+    }
+};
+
+/**
+ * Push the client->server half of a capture to a server and measure the response
+ *
+ * Keep alive packets in the capture are skipped and instead the keep alive packets sent by the server are echoed back
+ *
+ * @returns Process exit code
+ */
+static int replay_to_server(capture_t& capture)
+{
+    std::vector<capture_t::index_entry_t> entries;
+    for (size_t i = 0; i < capture.size(); i++)
+    {
+        capture_t::index_entry_t entry = capture.get_entry(i);
+        if (entry.from_client && entry.id != PACKET_ID_KEEP_ALIVE)
+            entries.push_back(entry);
+    }
+
+    if (entries.empty())
+    {
+        dc_log_error("Capture contains no client->server packets");
+        return 1;
+    }
+
+    SDLNet_Address* addr = SDLNet_ResolveHostname(replay_address.get().c_str());
+    if (!addr || SDLNet_WaitUntilResolved(addr, 5000) != 1)
+    {
+        dc_log_error("Unable to resolve \"%s\": %s", replay_address.get().c_str(), SDL_GetError());
+        if (addr)
+            SDLNet_UnrefAddress(addr);
+        return 1;
+    }
+
+    SDLNet_StreamSocket* sock = SDLNet_CreateClient(addr, 25565);
+    SDLNet_UnrefAddress(addr);
+
+    if (!sock || SDLNet_WaitUntilConnected(sock, 5000) != 1)
+    {
+        dc_log_error("Unable to connect to \"%s\": %s", replay_address.get().c_str(), SDL_GetError());
+        if (sock)
+            SDLNet_DestroyStreamSocket(sock);
+        return 1;
+    }
+
+    dc_log("Replaying %zu packets to %s (speed: %.2f)", entries.size(), replay_address.get().c_str(), replay_speed.get());
+
+    packet_handler_t handler(false);
+
+    traffic_stats_t stats_sent;
+    traffic_stats_t stats_recv;
+    Uint64 keep_alives_echoed = 0;
+
+    time_samples_t schedule_lag;
+    time_samples_t handshake_rtt;
+    time_samples_t login_rtt;
+    Uint64 tick_handshake_sent = 0;
+    Uint64 tick_login_sent = 0;
+
+    const double speed = replay_speed.get();
+    const Uint64 first_tick = entries[0].tick;
+    const Uint64 tick_start = SDL_GetTicksNS();
+    Uint64 tick_last_send = tick_start;
+    Uint64 tick_last_stats = tick_start;
+    Uint64 stats_recv_bytes_last = 0;
+
+    size_t pos = 0;
+    bool done = false;
+    int ret = 0;
+
+    while (!done)
+    {
+        Uint64 tick_cur = SDL_GetTicksNS();
+
+        /* Send every packet that is due */
+        for (; pos < entries.size(); pos++)
+        {
+            const capture_t::index_entry_t& entry = entries[pos];
+            const Uint64 due = tick_start + (speed > 0.0 ? Uint64(double(entry.tick - first_tick) * 1000000.0 / speed) : 0);
+            if (due > tick_cur)
+                break;
+
+            const Uint8* data = capture.get_data(entry);
+            if (!data || !SDLNet_WriteToStreamSocket(sock, data, entry.len))
+            {
+                dc_log_error("Unable to send packet %zu: %s", pos, data ? SDL_GetError() : "Missing data");
+                done = true;
+                ret = 1;
+                break;
+            }
+
+            if (entry.id == PACKET_ID_HANDSHAKE)
+                tick_handshake_sent = tick_cur;
+            else if (entry.id == PACKET_ID_LOGIN_REQUEST)
+                tick_login_sent = tick_cur;
+
+            stats_sent.add(entry.len);
+            schedule_lag.add(tick_cur - due);
+            tick_last_send = tick_cur;
+        }
+
+        /* Drain responses */
+        while (packet_t* pack = handler.get_next_packet(sock))
+        {
+            tick_cur = SDL_GetTicksNS();
+            stats_recv.add(handler.get_last_packet_data().size());
+
+            switch (pack->id)
+            {
+            case PACKET_ID_KEEP_ALIVE:
+                send_buffer(sock, pack->assemble());
+                keep_alives_echoed++;
+                break;
+            case PACKET_ID_HANDSHAKE:
+                if (tick_handshake_sent)
+                    handshake_rtt.add(tick_cur - tick_handshake_sent);
+                tick_handshake_sent = 0;
+                break;
+            case PACKET_ID_LOGIN_REQUEST:
+                if (tick_login_sent)
+                    login_rtt.add(tick_cur - tick_login_sent);
+                tick_login_sent = 0;
+                break;
+            case PACKET_ID_KICK:
+                dc_log("Kicked by server: \"%s\"", ((packet_kick_t*)pack)->reason.c_str());
+                done = true;
+                break;
+            default:
+                break;
+            }
+
+            handler.free_packet(pack);
+        }
+
+        if (handler.get_error().length())
+        {
+            if (pos < entries.size())
+            {
+                dc_log_error("Connection lost after %zu/%zu packets: %s", pos, entries.size(), handler.get_error().c_str());
+                ret = 1;
+            }
+            done = true;
+        }
+
+        tick_cur = SDL_GetTicksNS();
+
+        if (pos >= entries.size() && tick_cur - tick_last_send > Uint64(replay_drain_time.get()) * 1000000)
+            done = true;
+
+        if (replay_stats_interval.get() && tick_cur - tick_last_stats > Uint64(replay_stats_interval.get()) * 1000000)
+        {
+            const double secs = double(tick_cur - tick_last_stats) / 1000000000.0;
+            dc_log("Sent %zu/%zu packets, received %lu packets (%.2f MiB/s)", pos, entries.size(), (unsigned long)stats_recv.packets,
+                double(stats_recv.bytes - stats_recv_bytes_last) / (1024.0 * 1024.0) / secs);
+            stats_recv_bytes_last = stats_recv.bytes;
+            tick_last_stats = tick_cur;
+        }
+
+        if (done)
+            break;
+
+        /* Sleep until the next packet is due or the server sends something */
+        Sint32 timeout = 10;
+        if (pos < entries.size() && speed > 0.0)
+        {
+            const Uint64 due = tick_start + Uint64(double(entries[pos].tick - first_tick) * 1000000.0 / speed);
+            timeout = (due > tick_cur) ? Sint32(SDL_min((due - tick_cur) / 1000000, Uint64(10))) : 0;
+        }
+        else if (pos < entries.size())
+            timeout = 0;
+
+        if (timeout > 0)
+            SDLNet_WaitUntilInputAvailable((void**)&sock, 1, timeout);
+    }
+
+    const Uint64 elapsed = SDL_GetTicksNS() - tick_start;
+
+    SDLNet_WaitUntilStreamSocketDrained(sock, 1000);
+    SDLNet_DestroyStreamSocket(sock);
+
+    dc_log("Replay finished in %.3f s", double(elapsed) / 1000000000.0);
+    stats_sent.log("Sent", elapsed);
+    stats_recv.log("Received", elapsed);
+    dc_log("%-20s: %lu", "Keep alives echoed", (unsigned long)keep_alives_echoed);
+    schedule_lag.log("Schedule lag");
+    handshake_rtt.log("Handshake latency");
+    login_rtt.log("Login latency");
+
+    return ret;
+}
+
+/**
+ * Feed the server->client half of a capture through packet_handler_t and the client chunk decoder without any sockets
+ *
+ * @returns Process exit code
+ */
+static int replay_to_client(capture_t& capture)
+{
+    struct ivec3_comparator_t
+    {
+        bool operator()(const glm::ivec3& a, const glm::ivec3& b) const
+        {
+            if (a.x != b.x)
+                return a.x < b.x;
+            if (a.y != b.y)
+                return a.y < b.y;
+            return a.z < b.z;
+        }
+    };
+
+    std::map<glm::ivec3, chunk_cubic_t*, ivec3_comparator_t> chunks;
+    auto lookup = [&](const glm::ivec3 cpos, const bool create) -> chunk_cubic_t* {
+        auto it = chunks.find(cpos);
+        if (it != chunks.end())
+            return it->second;
+        if (!create)
+            return NULL;
+
+        chunk_cubic_t* c = new chunk_cubic_t();
+        c->pos = cpos;
+        chunks[cpos] = c;
+        return c;
+    };
+
+    packet_handler_t handler(false);
+    std::vector<Uint8> decompression_buffer;
+
+    traffic_stats_t stats_parsed;
+    traffic_stats_t stats_chunk;
+    Uint64 chunk_errors = 0;
+    Uint64 tick_parse = 0;
+
+    time_samples_t parse_time;
+    time_samples_t chunk_time;
+
+    const Uint64 tick_start = SDL_GetTicksNS();
+    Uint64 tick_last_stats = tick_start;
+
+    for (size_t i = 0; i < capture.size(); i++)
+    {
+        const capture_t::index_entry_t entry = capture.get_entry(i);
+        if (entry.from_client)
+            continue;
+
+        const Uint8* data = capture.get_data(entry);
+        if (!data)
+        {
+            dc_log_error("Missing data for packet %zu", i);
+            break;
+        }
+
+        const Uint64 tick_parse_start = SDL_GetTicksNS();
+        handler.feed_bytes(data, entry.len);
+        packet_t* pack = handler.get_next_packet();
+        const Uint64 tick_parse_end = SDL_GetTicksNS();
+
+        if (!pack)
+        {
+            dc_log_error("Unable to parse packet %zu (0x%02x): %s", i, entry.id, handler.get_error().length() ? handler.get_error().c_str() : "Incomplete packet");
+            break;
+        }
+
+        tick_parse += tick_parse_end - tick_parse_start;
+        parse_time.add(tick_parse_end - tick_parse_start);
+        stats_parsed.add(entry.len);
+
+        if (pack->id == PACKET_ID_CHUNK_MAP)
+        {
+            const Uint64 tick_chunk_start = SDL_GetTicksNS();
+            if (!decompress_chunk_packet((packet_chunk_t*)pack, decompression_buffer, lookup))
+                chunk_errors++;
+            chunk_time.add(SDL_GetTicksNS() - tick_chunk_start);
+            stats_chunk.add(entry.len);
+        }
+
+        handler.free_packet(pack);
+
+        const Uint64 tick_cur = SDL_GetTicksNS();
+        if (replay_stats_interval.get() && tick_cur - tick_last_stats > Uint64(replay_stats_interval.get()) * 1000000)
+        {
+            dc_log("Processed %zu/%zu packets, %zu chunks", i + 1, capture.size(), chunks.size());
+            tick_last_stats = tick_cur;
+        }
+    }
+
+    const Uint64 elapsed = SDL_GetTicksNS() - tick_start;
+
+    dc_log("Replay finished in %.3f s", double(elapsed) / 1000000000.0);
+    stats_parsed.log("Parsed", elapsed);
+    stats_parsed.log("Parsed (parse time)", tick_parse);
+    stats_chunk.log("Chunk packets", elapsed);
+    dc_log("%-20s: %zu (%lu errors)", "Chunks", chunks.size(), (unsigned long)chunk_errors);
+    parse_time.log("Parse time");
+    chunk_time.log("Chunk decode time");
+
+    for (auto it : chunks)
+        delete it.second;
+
+    return 0;
+}
+
+int main(int argc, const char** argv)
+{
+    /* KDevelop fully buffers the output and will not display anything */
+    setvbuf(stdout, NULL, _IONBF, 0);
+    setvbuf(stderr, NULL, _IONBF, 0);
+
+    dc_log("mcs_b181_replay (%s)-%s (%s)", build_info::ver_string::replay().c_str(), build_info::build_mode, build_info::git::refspec);
+
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_NAME_STRING, "mcs_b181_replay");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_VERSION_STRING, build_info::ver_string::replay().c_str());
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_IDENTIFIER_STRING, "net.icrashstuff.mcs_b181_replay");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_CREATOR_STRING, "Ian Hangartner (icrashstuff)");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_COPYRIGHT_STRING, "Copyright (c) 2024-2025 Ian Hangartner (icrashstuff)");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_URL_STRING, "https://github.com/icrashstuff/mcs_b181");
+    SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_TYPE_STRING, "application");
+
+    tetra::init("icrashstuff", "mcs_b181", "mcs_b181_replay", argc, argv);
+
+    if (!replay_capture.get().length())
+    {
+        dc_log_error("No capture specified (Set the convar \"%s\")", replay_capture.get_name());
+        tetra::deinit();
+        return 1;
+    }
+
+    capture_t capture;
+    if (!capture.open(replay_capture.get()))
+    {
+        dc_log_error("Unable to open capture \"%s\"", replay_capture.get().c_str());
+        tetra::deinit();
+        return 1;
+    }
+
+    dc_log("Opened capture \"%s\" (%zu packets)", replay_capture.get().c_str(), capture.size());
+
+    int ret = 0;
+    if (replay_mode.get() == 0)
+    {
+        if (!SDLNet_Init())
+        {
+            dc_log_error("SDLNet_Init: %s", SDL_GetError());
+            tetra::deinit();
+            return 1;
+        }
+
+        ret = replay_to_server(capture);
+
+        SDLNet_Quit();
+    }
+    else
+        ret = replay_to_client(capture);
+
+    capture.close();
+    tetra::deinit();
+
+    return ret;
+}
@@ -1581,7 +1581,7 @@ void player_place(std::vector<client_t>& clients, client_t* client, packet_playe
         double diff_y = (double)place_y - client->player_y;
 
         if (SDL_floor(client->player_x) == place_x && (-0.9 < diff_y && diff_y < 1.8) && SDL_floor(client->player_z) == place_z
-            && mc_id::block_has_collision(type))
+            && mc_id::block_properties.collision[type])
         {
             type = 0;
             p->damage = 0;
@@ -1679,10 +1679,10 @@ int main(const int argc, const char** argv)
         exit(1);
     }
 
-    if (!((convar_int_t*)convar_t::get_convar("dev"))->get())
+    if (!convar_t::dev())
         server_seed = cast_to_sint64((Uint64)SDL_rand_bits() << 32 | (Uint64)SDL_rand_bits());
 
-    if (!((convar_int_t*)convar_t::get_convar("dev"))->get())
+    if (!convar_t::dev())
         server_time = cast_to_sint64(SDL_rand_bits());
 
     next_thunder_bolt = SDL_rand_bits() & 0x7fff;
@@ -1706,7 +1706,7 @@ int main(const int argc, const char** argv)
     std::vector<mc_command_t> mc_commands;
 
     MC_COMMAND_REGB(smite, "", "Smite the player");
-    if (((convar_int_t*)convar_t::get_convar("dev"))->get())
+    if (convar_t::dev())
     {
         MC_COMMAND_REGB(strip_stone, "", "Strip all stone from chunk (dev)");
         MC_COMMAND_REGB(unload, "", "Forcebly unload the chunk (dev)");
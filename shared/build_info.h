@@ -29,6 +29,7 @@ namespace ver_string
     extern std::string client();
     extern std::string server();
     extern std::string bridge();
+    extern std::string replay();
     extern std::string shared();
 }
 
@@ -50,6 +51,9 @@ namespace git
         /** Last commit touching "bridge/" */
         extern const char* bridge_only;
 
+        /** Last commit touching "replay/" */
+        extern const char* replay_only;
+
         /** Last commit touching "shared/" */
         extern const char* shared_only;
     }
@@ -68,6 +72,9 @@ namespace git
         /** Dirty flag for "bridge/" */
         extern const bool bridge_only;
 
+        /** Dirty flag for "replay/" */
+        extern const bool replay_only;
+
         /** Dirty flag for "shared/" */
         extern const bool shared_only;
     }
@@ -0,0 +1,321 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "capture.h"
+
+#include "tetra/log.h"
+
+#include <SDL3/SDL_timer.h>
+
+#ifdef SDL_PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define CAPTURE_MAGIC "MCSBCAP"
+#define CAPTURE_VERSION 1
+
+static_assert(sizeof(capture_t::index_entry_t) == 24, "capture_t::index_entry_t must not have any padding");
+
+bool capture_t::mapping_t::map(const std::string& path, const size_t min_len)
+{
+    if (ptr && len >= min_len)
+        return true;
+
+    unmap();
+
+    if (min_len == 0)
+        return false;
+
+#ifdef SDL_PLATFORM_WINDOWS
+    handle_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle_file == INVALID_HANDLE_VALUE)
+    {
+        handle_file = NULL;
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(handle_file, &file_size) || (size_t)file_size.QuadPart < min_len)
+    {
+        unmap();
+        return false;
+    }
+
+    handle_mapping = CreateFileMappingA(handle_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!handle_mapping)
+    {
+        unmap();
+        return false;
+    }
+
+    ptr = (Uint8*)MapViewOfFile(handle_mapping, FILE_MAP_READ, 0, 0, 0);
+    len = file_size.QuadPart;
+#else
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    off_t file_size = lseek(fd, 0, SEEK_END);
+    if (file_size < 0 || (size_t)file_size < min_len)
+    {
+        unmap();
+        return false;
+    }
+
+    void* p = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    ptr = (p == MAP_FAILED) ? NULL : (Uint8*)p;
+    len = file_size;
+#endif
+
+    if (!ptr)
+    {
+        dc_log_error("Unable to map \"%s\"", path.c_str());
+        unmap();
+        return false;
+    }
+
+    return true;
+}
+
+void capture_t::mapping_t::unmap()
+{
+#ifdef SDL_PLATFORM_WINDOWS
+    if (ptr)
+        UnmapViewOfFile(ptr);
+    if (handle_mapping)
+        CloseHandle(handle_mapping);
+    if (handle_file)
+        CloseHandle(handle_file);
+    handle_mapping = NULL;
+    handle_file = NULL;
+#else
+    if (ptr)
+        munmap(ptr, len);
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+#endif
+    ptr = NULL;
+    len = 0;
+}
+
+capture_t::~capture_t() { close(); }
+
+bool capture_t::create(const std::string& path)
+{
+    close();
+
+    path_base = path;
+
+    stream_idx = SDL_IOFromFile((path_base + ".idx").c_str(), "wb");
+    stream_dat = SDL_IOFromFile((path_base + ".dat").c_str(), "wb");
+
+    if (!stream_idx || !stream_dat)
+    {
+        dc_log_error("Unable to create capture \"%s\": %s", path_base.c_str(), SDL_GetError());
+        close();
+        return false;
+    }
+
+    header_t header;
+    SDL_zero(header);
+    SDL_strlcpy(header.magic, CAPTURE_MAGIC, SDL_arraysize(header.magic));
+    header.version = CAPTURE_VERSION;
+    header.entry_size = sizeof(index_entry_t);
+    header.start_tick = SDL_GetTicks();
+    SDL_GetCurrentTime(&header.start_time);
+
+    if (SDL_WriteIO(stream_idx, &header, sizeof(header)) != sizeof(header) || !SDL_FlushIO(stream_idx))
+    {
+        dc_log_error("Unable to write capture header \"%s\": %s", path_base.c_str(), SDL_GetError());
+        close();
+        return false;
+    }
+
+    tick_adjust = 0;
+
+    return true;
+}
+
+bool capture_t::open(const std::string& path)
+{
+    close();
+
+    path_base = path;
+
+    if (!map_idx.map(path_base + ".idx", sizeof(header_t)))
+    {
+        dc_log_error("Unable to open capture index \"%s.idx\"", path_base.c_str());
+        close();
+        return false;
+    }
+
+    header_t header;
+    memcpy(&header, map_idx.ptr, sizeof(header));
+
+    if (memcmp(header.magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0 || header.version != CAPTURE_VERSION || header.entry_size != sizeof(index_entry_t))
+    {
+        dc_log_error("\"%s.idx\" is not a valid capture index (Or is from an incompatible version)", path_base.c_str());
+        close();
+        return false;
+    }
+
+    /* Ignore a partially written entry at the end */
+    num_entries = (map_idx.len - sizeof(header_t)) / sizeof(index_entry_t);
+    num_entries_flushed = num_entries;
+
+    if (num_entries)
+    {
+        index_entry_t last;
+        memcpy(&last, map_idx.ptr + sizeof(header_t) + (num_entries - 1) * sizeof(index_entry_t), sizeof(last));
+        data_len = last.offset + last.len;
+        data_len_flushed = data_len;
+
+        if (!map_dat.map(path_base + ".dat", data_len))
+        {
+            dc_log_error("Capture data \"%s.dat\" is missing or truncated", path_base.c_str());
+            close();
+            return false;
+        }
+    }
+
+    /* Rebase the ticks onto this process's clock, so that they map to the same wall clock time */
+    SDL_Time now_time = 0;
+    SDL_GetCurrentTime(&now_time);
+    tick_adjust = Sint64(SDL_GetTicks()) - Sint64(header.start_tick) + (header.start_time - now_time) / 1000000;
+
+    return true;
+}
+
+void capture_t::close()
+{
+    if (stream_idx || stream_dat)
+        flush();
+
+    if (stream_idx)
+        SDL_CloseIO(stream_idx);
+    if (stream_dat)
+        SDL_CloseIO(stream_dat);
+    stream_idx = NULL;
+    stream_dat = NULL;
+
+    map_idx.unmap();
+    map_dat.unmap();
+
+    num_entries = 0;
+    num_entries_flushed = 0;
+    data_len = 0;
+    data_len_flushed = 0;
+    tick_adjust = 0;
+}
+
+size_t capture_t::append(const Uint64 tick, const bool from_client, const Uint8* const data, const size_t len)
+{
+    if (!stream_idx || !stream_dat || !len)
+        return num_entries;
+
+    index_entry_t entry;
+    SDL_zero(entry);
+    entry.tick = tick;
+    entry.offset = data_len;
+    entry.len = len;
+    entry.id = data[0];
+    entry.from_client = from_client;
+
+    /* After a short write the files no longer match the counters, so writing stops and everything before this packet stays readable
+     * (The data is written first, and a partial index entry at the end is ignored by capture_t::open()) */
+    if (SDL_WriteIO(stream_dat, data, len) != len || SDL_WriteIO(stream_idx, &entry, sizeof(entry)) != sizeof(entry))
+    {
+        dc_log_error("Error writing to capture \"%s\", no further packets will be captured: %s", path_base.c_str(), SDL_GetError());
+        flush();
+        SDL_CloseIO(stream_idx);
+        SDL_CloseIO(stream_dat);
+        stream_idx = NULL;
+        stream_dat = NULL;
+        return num_entries;
+    }
+
+    data_len += len;
+
+    return num_entries++;
+}
+
+void capture_t::flush()
+{
+    if (num_entries == num_entries_flushed)
+        return;
+
+    /* Data must hit the disk before the index entries that point to it */
+    if (stream_dat)
+        SDL_FlushIO(stream_dat);
+    if (stream_idx)
+        SDL_FlushIO(stream_idx);
+
+    num_entries_flushed = num_entries;
+    data_len_flushed = data_len;
+}
+
+capture_t::index_entry_t capture_t::get_entry(const size_t i)
+{
+    index_entry_t entry;
+    SDL_zero(entry);
+
+    if (i >= num_entries_flushed || !map_idx.map(path_base + ".idx", sizeof(header_t) + num_entries_flushed * sizeof(index_entry_t)))
+        return entry;
+
+    memcpy(&entry, map_idx.ptr + sizeof(header_t) + i * sizeof(index_entry_t), sizeof(entry));
+    entry.tick += tick_adjust;
+
+    return entry;
+}
+
+const Uint8* capture_t::get_data(const index_entry_t& entry)
+{
+    if (!entry.len || entry.offset + entry.len > data_len_flushed || !map_dat.map(path_base + ".dat", data_len_flushed))
+        return NULL;
+
+    return map_dat.ptr + entry.offset;
+}
+
+packet_t* capture_t::decode(const size_t i)
+{
+    index_entry_t entry = get_entry(i);
+    const Uint8* data = get_data(entry);
+
+    if (!data)
+        return NULL;
+
+    packet_handler_t handler(entry.from_client);
+    handler.feed_bytes(data, entry.len);
+
+    packet_t* pack = handler.get_next_packet();
+
+    if (pack)
+        pack->assemble_tick = entry.tick;
+
+    return pack;
+}
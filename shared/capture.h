@@ -0,0 +1,215 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_platform.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_time.h>
+
+#include <string>
+
+#include "shared/packet.h"
+
+/** Marks an unset capture index */
+#define CAPTURE_IDX_NONE SIZE_MAX
+
+/**
+ * Append-only on disk packet capture
+ *
+ * A capture consists of two files:
+ * - "<path>.dat": The wire bytes of every packet, back to back
+ * - "<path>.idx": A header followed by one capture_t::index_entry_t per packet
+ *
+ * Both files are written through buffered streams and read back through memory mappings, so the
+ * memory usage of a capture does not depend on its length.
+ *
+ * Both files use native byte order
+ *
+ * Thread-Safety:
+ * - None, callers are expected to do their own locking
+ */
+struct capture_t
+{
+    struct index_entry_t
+    {
+        /** SDL tick (0.001s) of the process that wrote the capture when the packet was received */
+        Uint64 tick;
+
+        /** Offset of the packet in the data file */
+        Uint64 offset;
+
+        /** Length of the packet in bytes */
+        Uint32 len;
+
+        /** Packet id (Same as the first byte of the packet) */
+        Uint8 id;
+
+        /** Non-zero if the packet was sent by the client */
+        Uint8 from_client;
+
+        Uint16 reserved;
+    };
+
+    struct header_t
+    {
+        char magic[8];
+        Uint32 version;
+        Uint32 entry_size;
+
+        /** Wall clock time of capture_t::header_t::start_tick */
+        SDL_Time start_time;
+
+        /** SDL tick (0.001s) of the process that wrote the capture when the capture was created */
+        Uint64 start_tick;
+    };
+
+    capture_t() = default;
+    capture_t(const capture_t&) = delete;
+    capture_t& operator=(const capture_t&) = delete;
+
+    ~capture_t();
+
+    /**
+     * Create a new capture for writing (Existing files are overwritten)
+     *
+     * @param path Path of the capture without the file extension
+     *
+     * @returns True on success, false on failure
+     */
+    bool create(const std::string& path);
+
+    /**
+     * Open an existing capture for reading
+     *
+     * @param path Path of the capture without the file extension
+     *
+     * @returns True on success, false on failure
+     */
+    bool open(const std::string& path);
+
+    /**
+     * Closes the capture files and releases any mappings
+     */
+    void close();
+
+    /**
+     * Append a packet to the capture
+     *
+     * NOTE: The packet will not be visible to get_entry()/get_data() until capture_t::flush() is called
+     *
+     * @param tick SDL tick (0.001s) when the packet was received
+     * @param from_client True if the packet was sent by the client
+     * @param data Wire bytes of the packet (The first byte is the packet id)
+     * @param len Number of bytes in data
+     *
+     * @returns Index of the packet (If writing failed the capture stops being writable and nothing is appended)
+     */
+    size_t append(const Uint64 tick, const bool from_client, const Uint8* const data, const size_t len);
+
+    /**
+     * Writes all appended packets to disk and makes them visible to readers
+     */
+    void flush();
+
+    /**
+     * Returns the number of packets visible to readers
+     */
+    inline size_t size() const { return num_entries_flushed; }
+
+    /**
+     * Returns the number of packets appended (Including packets not yet flushed)
+     */
+    inline size_t size_appended() const { return num_entries; }
+
+    /**
+     * Returns the combined size in bytes of the capture files
+     */
+    inline size_t size_on_disk() const { return sizeof(header_t) + num_entries * sizeof(index_entry_t) + data_len; }
+
+    inline bool is_writable() const { return stream_idx != NULL; }
+
+    inline const std::string& get_path() const { return path_base; }
+
+    /**
+     * Get the index entry of a packet
+     *
+     * Ticks are adjusted so that timestamps of packets from captures created by other processes are correct
+     *
+     * @param i Index of the packet, must be less than capture_t::size()
+     */
+    index_entry_t get_entry(const size_t i);
+
+    /**
+     * Get the wire bytes of a packet
+     *
+     * NOTE: Only valid until the next call to any non-const function
+     *
+     * @returns Pointer to capture_t::index_entry_t::len bytes, or NULL on failure
+     */
+    const Uint8* get_data(const index_entry_t& entry);
+
+    /**
+     * Decode a packet from the capture
+     *
+     * WARNING: It is your responsibility to free the returned packet!
+     *
+     * @returns NULL on failure
+     */
+    packet_t* decode(const size_t i);
+
+private:
+    struct mapping_t
+    {
+        Uint8* ptr = NULL;
+        size_t len = 0;
+#ifdef SDL_PLATFORM_WINDOWS
+        void* handle_file = NULL;
+        void* handle_mapping = NULL;
+#else
+        int fd = -1;
+#endif
+
+        /**
+         * (Re)maps the file so that at least min_len bytes are available
+         */
+        bool map(const std::string& path, const size_t min_len);
+        void unmap();
+    };
+
+    std::string path_base;
+
+    SDL_IOStream* stream_idx = NULL;
+    SDL_IOStream* stream_dat = NULL;
+
+    mapping_t map_idx;
+    mapping_t map_dat;
+
+    size_t num_entries = 0;
+    size_t num_entries_flushed = 0;
+    size_t data_len = 0;
+    size_t data_len_flushed = 0;
+
+    /** Added to the tick of every entry (See get_entry()) */
+    Sint64 tick_adjust = 0;
+};
@@ -165,7 +165,7 @@ void chunk_t::correct_lighting(int generator)
                     set_light_sky(x, y, z, 15);
                 else
                     set_light_sky(x, y, z, 0);
-                Uint8 level = mc_id::get_light_level(get_type(x, y, z));
+                Uint8 level = mc_id::block_properties.light_level[get_type(x, y, z)];
                 set_light_block(x, y, z, level);
             }
         }
@@ -207,7 +207,7 @@ void chunk_t::correct_grass()
         fix_dirty_grass:;
             for (; i > 0; i--)
             {
-                if (!mc_id::is_transparent(get_type(cx, i, cz)) && get_type(cx, i - 1, cz) == BLOCK_ID_GRASS)
+                if (!mc_id::block_properties.transparent[get_type(cx, i, cz)] && get_type(cx, i - 1, cz) == BLOCK_ID_GRASS)
                     set_type(cx, i - 1, cz, BLOCK_ID_DIRT);
             }
 
@@ -312,7 +312,7 @@ void chunk_t::generate_biome_toppings(const long seed, const int cx, const int c
  */
 void chunk_t::generate_from_seed_over(const long seed, const int cx, const int cz)
 {
-    if (((convar_int_t*)convar_t::get_convar("dev"))->get() && (cx == -1 || cx == 0) && (cz == -1 || cz == 0))
+    if (convar_t::dev() && (cx == -1 || cx == 0) && (cz == -1 || cz == 0))
     {
         if (cz == 0 && cx == 0)
             generate_special_metadata();
@@ -464,7 +464,7 @@ void chunk_t::generate_from_seed_over(const long seed, const int cx, const int c
         for (int z = 0; z < CHUNK_SIZE_Z; z++)
             set_type(x, 0, z, BLOCK_ID_BEDROCK);
 
-    if (((convar_int_t*)convar_t::get_convar("dev"))->get())
+    if (convar_t::dev())
     {
         for (int x = 0; x < CHUNK_SIZE_X; x++)
         {
@@ -929,7 +929,7 @@ void chunk_t::generate_from_seed_nether(long seed, int cx, int cz)
         }
     }
 
-    if (((convar_int_t*)convar_t::get_convar("dev"))->get())
+    if (convar_t::dev())
     {
         for (int x = 0; x < CHUNK_SIZE_X; x++)
         {
@@ -642,6 +642,36 @@ MC_ID_CONST bool mc_id::is_transparent(const short block_id)
     }
 }
 
+MC_ID_CONST bool mc_id::is_opaque_cube(const short block_id)
+{
+    if (!is_block(block_id) || is_transparent(block_id))
+        return false;
+
+    switch (block_id)
+    {
+        ADD_NAME(BLOCK_ID_PISTON, 0);
+        ADD_NAME(BLOCK_ID_PISTON_STICKY, 0);
+        ADD_NAME(BLOCK_ID_PISTON_HEAD, 0);
+        ADD_NAME(BLOCK_ID_SLAB_SINGLE, 0);
+        ADD_NAME(BLOCK_ID_STAIRS_WOOD, 0);
+        ADD_NAME(BLOCK_ID_STAIRS_COBBLESTONE, 0);
+        ADD_NAME(BLOCK_ID_STAIRS_BRICK, 0);
+        ADD_NAME(BLOCK_ID_STAIRS_BRICK_STONE, 0);
+        ADD_NAME(BLOCK_ID_DIRT_TILLED, 0);
+        ADD_NAME(BLOCK_ID_SIGN_STANDING, 0);
+        ADD_NAME(BLOCK_ID_SIGN_WALL, 0);
+        ADD_NAME(BLOCK_ID_LEVER, 0);
+        ADD_NAME(BLOCK_ID_PRESSURE_PLATE_STONE, 0);
+        ADD_NAME(BLOCK_ID_PRESSURE_PLATE_WOOD, 0);
+        ADD_NAME(BLOCK_ID_BUTTON_STONE, 0);
+        ADD_NAME(BLOCK_ID_SNOW, 0);
+        ADD_NAME(BLOCK_ID_STEM_PUMPKIN, 0);
+        ADD_NAME(BLOCK_ID_STEM_MELON, 0);
+    default:
+        return true;
+    }
+}
+
 MC_ID_CONST bool mc_id::is_leaves_style_transparent(const short block_id)
 {
     switch (block_id)
@@ -810,6 +840,40 @@ MC_ID_CONST glm::vec3 mc_id::get_light_color(const short block_id)
     }
 }
 
+MC_ID_CONST Uint8 mc_id::get_light_opacity(const short block_id)
+{
+    switch (block_id)
+    {
+        ADD_NAME(BLOCK_ID_LEAVES, 1);
+        ADD_NAME(BLOCK_ID_WATER_FLOWING, 1);
+        ADD_NAME(BLOCK_ID_WATER_SOURCE, 1);
+    default:
+        return is_transparent(block_id) ? 0 : 15;
+    }
+}
+
+static mc_id::block_property_tables_t build_block_property_tables()
+{
+    mc_id::block_property_tables_t t;
+    SDL_zero(t);
+
+    for (int i = 0; i < BLOCK_ID_ARRAY_SIZE; i++)
+    {
+        t.transparent.set(i, mc_id::is_transparent(i));
+        t.translucent.set(i, mc_id::is_translucent(i));
+        t.leaves_style_transparent.set(i, mc_id::is_leaves_style_transparent(i));
+        t.opaque_cube.set(i, mc_id::is_opaque_cube(i));
+        t.fluid.set(i, mc_id::is_fluid(i));
+        t.collision.set(i, mc_id::block_has_collision(i));
+        t.light_level[i] = mc_id::get_light_level(i);
+        t.light_opacity[i] = mc_id::get_light_opacity(i);
+    }
+
+    return t;
+}
+
+const mc_id::block_property_tables_t mc_id::block_properties = build_block_property_tables();
+
 MC_ID_CONST Uint8 mc_id::get_food_value(const short item_id)
 {
     switch (item_id)
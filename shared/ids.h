@@ -496,6 +496,11 @@ MC_ID_CONST bool is_leaves_style_transparent(const short block_id);
 
 MC_ID_CONST bool is_translucent(const short block_id);
 
+/**
+ * For blocks that completely fill their space with opaque faces, and as such hide anything behind them (ie. Not slabs, stairs, snow layers, and such)
+ */
+MC_ID_CONST bool is_opaque_cube(const short block_id);
+
 MC_ID_CONST bool can_host_hanging(const short block_id);
 
 MC_ID_CONST bool can_host_rail(const short block_id);
@@ -518,6 +523,75 @@ MC_ID_CONST Uint8 get_light_level(const short block_id);
 
 MC_ID_CONST glm::vec3 get_light_color(const short block_id);
 
+/**
+ * Get the amount of extra attenuation light receives when entering a block
+ *
+ * A value of 15 means that light cannot enter the block at all (ie. !is_transparent(block_id))
+ *
+ * NOTE: The client lighting engine only applies non-opaque values to sky light traveling downwards
+ */
+MC_ID_CONST Uint8 get_light_opacity(const short block_id);
+
+/**
+ * Fixed size bitset indexed by block id
+ */
+struct block_bitset_t
+{
+    Uint64 bits[BLOCK_ID_ARRAY_SIZE / 64];
+
+    inline bool operator[](const Uint8 block_id) const { return (bits[block_id >> 6] >> (block_id & 63)) & 1; }
+
+    inline void set(const Uint8 block_id, const bool val)
+    {
+        if (val)
+            bits[block_id >> 6] |= Uint64(1) << (block_id & 63);
+        else
+            bits[block_id >> 6] &= ~(Uint64(1) << (block_id & 63));
+    }
+};
+
+/**
+ * Structure of arrays containing precomputed block properties, index: block id
+ *
+ * Hot loops (lighting, meshing, renderer hints, collision) should index mc_id::block_properties instead of
+ * calling the switch based functions (or rebuilding their own lookup tables) per block
+ *
+ * Every entry is generated from the corresponding mc_id function at startup, so those remain the source of truth
+ */
+struct block_property_tables_t
+{
+    /** @sa mc_id::is_transparent() */
+    block_bitset_t transparent;
+
+    /** @sa mc_id::is_translucent() */
+    block_bitset_t translucent;
+
+    /** @sa mc_id::is_leaves_style_transparent() */
+    block_bitset_t leaves_style_transparent;
+
+    /** @sa mc_id::is_opaque_cube() */
+    block_bitset_t opaque_cube;
+
+    /** @sa mc_id::is_fluid() */
+    block_bitset_t fluid;
+
+    /** @sa mc_id::block_has_collision() */
+    block_bitset_t collision;
+
+    /** @sa mc_id::get_light_level() */
+    Uint8 light_level[BLOCK_ID_ARRAY_SIZE];
+
+    /** @sa mc_id::get_light_opacity() */
+    Uint8 light_opacity[BLOCK_ID_ARRAY_SIZE];
+};
+
+/**
+ * Global block property tables
+ *
+ * NOTE: These are filled in during static initialization and should not be accessed by other static initializers
+ */
+extern const block_property_tables_t block_properties;
+
 /**
  * Get the corresponding return data for a block id
  */
@@ -103,10 +103,10 @@ bool int_from_str(const std::string& str, int& out)
     return r;
 }
 
-void util::parallel_for(const int start, const int end, std::function<void(const int start, const int end)> func)
+void util::parallel_for(const int start, const int end, std::function<void(const int start, const int end)> func, const int max_threads)
 {
     /** Maximum number of threads available (Leave one thread alone for the system) */
-    const int max_new_threads = SDL_GetNumLogicalCPUCores() - 1;
+    const int max_new_threads = max_threads > 0 ? max_threads : SDL_GetNumLogicalCPUCores() - 1;
 
     assert(start <= end);
 
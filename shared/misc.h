@@ -185,8 +185,9 @@ namespace util
  * @param start Inclusive start of range
  * @param end Inclusive end of range
  * @param func Sub-loop function to call
+ * @param max_threads Maximum number of threads to split the range across (including the calling thread), 0 for automatic
  */
-void parallel_for(const int start, const int end, std::function<void(const int start, const int end)> func);
+void parallel_for(const int start, const int end, std::function<void(const int start, const int end)> func, const int max_threads = 0);
 
 /**
  * Dummy printf-style function
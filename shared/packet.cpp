@@ -574,6 +574,40 @@ packet_handler_t::packet_handler_t(const bool is_server_)
     packet_type = 16384;
 }
 
+void packet_handler_t::feed_bytes(const void* const data, const size_t data_len)
+{
+    if (fed_bytes_pos)
+    {
+        fed_bytes.erase(fed_bytes.begin(), fed_bytes.begin() + fed_bytes_pos);
+        fed_bytes_pos = 0;
+    }
+
+    fed_bytes.insert(fed_bytes.end(), (const Uint8*)data, (const Uint8*)data + data_len);
+}
+
+int packet_handler_t::read_input(SDLNet_StreamSocket* const sock, Uint8* const dest, const int dest_len)
+{
+    if (dest_len <= 0)
+        return 0;
+
+    if (sock)
+        return SDLNet_ReadFromStreamSocket(sock, dest, dest_len);
+
+    const int amount = SDL_min((size_t)dest_len, fed_bytes.size() - fed_bytes_pos);
+    memcpy(dest, fed_bytes.data() + fed_bytes_pos, amount);
+    fed_bytes_pos += amount;
+
+    if (fed_bytes_pos == fed_bytes.size())
+    {
+        fed_bytes.clear();
+        fed_bytes_pos = 0;
+    }
+
+    return amount;
+}
+
+packet_t* packet_handler_t::get_next_packet() { return get_next_packet(NULL); }
+
 packet_t* packet_handler_t::get_next_packet(SDLNet_StreamSocket* const sock)
 {
     if (err_str.length() > 0)
@@ -583,13 +617,13 @@ packet_t* packet_handler_t::get_next_packet(SDLNet_StreamSocket* const sock)
     if (buf_size == 0)
     {
         buf.resize(128);
-        if (SDLNet_GetConnectionStatus(sock) != 1)
+        if (sock && SDLNet_GetConnectionStatus(sock) != 1)
         {
             err_str = "SDLNet_GetConnectionStatus failed!";
             return NULL;
         }
 
-        int buf_inc = SDLNet_ReadFromStreamSocket(sock, buf.data(), 1);
+        int buf_inc = read_input(sock, buf.data(), 1);
         if (buf_inc < 0)
         {
             err_str = "Socket is dead!";
@@ -651,6 +685,9 @@ packet_t* packet_handler_t::get_next_packet(SDLNet_StreamSocket* const sock)
         }
 #undef PACK_LEN
 #undef PACK_LENV
+
+        if (err_str.length() > 0)
+            return NULL;
     }
 
     /* This section reads the data and determines any variable length stuff as well */
@@ -664,7 +701,7 @@ packet_t* packet_handler_t::get_next_packet(SDLNet_StreamSocket* const sock)
         if (len >= buf.size())
             buf.resize(len);
 
-        int buf_inc = SDLNet_ReadFromStreamSocket(sock, buf.data() + buf_size, len - buf_size);
+        int buf_inc = read_input(sock, buf.data() + buf_size, len - buf_size);
 
         if (buf_inc < 0)
         {
@@ -922,6 +959,9 @@ packet_t* packet_handler_t::get_next_packet(SDLNet_StreamSocket* const sock)
                 }
             }
         }
+
+        if (err_str.length() > 0)
+            return NULL;
     } while (change_happened && (var_len > 0 || buf_size != len));
 
     if (buf_size != len || var_len > 0)
@@ -872,6 +872,38 @@ public:
      */
     packet_t* get_next_packet(SDLNet_StreamSocket* const sock);
 
+    /**
+     * Get the next finished packet or work on it, reading from bytes queued with packet_handler_t::feed_bytes() instead of a socket
+     * Non-Blocking
+     *
+     * This allows decoding a byte stream that was forwarded or captured elsewhere
+     *
+     * WARNING: It is your responsibility to free the returned packet!
+     *
+     * @returns NULL if no packet is available or if an error has occurred
+     */
+    packet_t* get_next_packet();
+
+    /**
+     * Queue raw bytes for packet_handler_t::get_next_packet()
+     *
+     * @param data Bytes to queue
+     * @param data_len Number of bytes to queue
+     */
+    void feed_bytes(const void* const data, const size_t data_len);
+
+    /**
+     * Returns the number of bytes queued with packet_handler_t::feed_bytes() that have not been consumed yet
+     */
+    inline size_t get_bytes_pending() { return fed_bytes.size() - fed_bytes_pos; }
+
+    /**
+     * Returns the wire bytes of the packet most recently returned by get_next_packet()
+     *
+     * NOTE: Only valid until the next call to get_next_packet()
+     */
+    inline const std::vector<Uint8>& get_last_packet_data() { return buf; }
+
     static void free_packet(packet_t* const packet);
 
     /**
@@ -890,10 +922,18 @@ public:
     inline size_t get_bytes_received() { return bytes_received; }
 
 private:
+    /**
+     * Reads from sock, or from fed_bytes if sock is NULL
+     */
+    int read_input(SDLNet_StreamSocket* const sock, Uint8* const dest, const int dest_len);
+
     Uint64 last_packet_time;
 
     size_t bytes_received;
 
+    std::vector<Uint8> fed_bytes;
+    size_t fed_bytes_pos = 0;
+
     std::vector<Uint8> buf;
 
     size_t buf_size;
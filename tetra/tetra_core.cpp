@@ -77,7 +77,7 @@ void tetra::init(const char* organization, const char* appname, const char* cfg_
     cli_parser::parse(argc, argv);
 
     {
-        convar_int_t* dev = (convar_int_t*)convar_t::get_convar("dev");
+        convar_int_t* dev = convar_t::get_convar_int("dev");
 
         /* Set dev before any other variables in case their callbacks require dev */
         environ_parser::apply_to("CVR_", SDL_GetEnvironment(), dev);
@@ -94,7 +94,7 @@ void tetra::init(const char* organization, const char* appname, const char* cfg_
         fflush(stderr);
         dc_log("Developer convar set");
 
-        convar_int_t* console_overlay = (convar_int_t*)convar_t::get_convar("console_overlay");
+        convar_int_t* console_overlay = convar_t::get_convar_int("console_overlay");
 
         if (console_overlay)
             console_overlay->set(3);
@@ -29,6 +29,7 @@
 #include <SDL3/SDL_assert.h>
 #include <stdlib.h>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -51,19 +52,70 @@ std::vector<convar_t*>* convar_t::get_convar_list()
     return &_vector;
 }
 
+/**
+ * Name lookup table for convar_t::get_convar()
+ *
+ * Keys point to convar_t::_name, which lives as long as the convar
+ */
+static std::unordered_map<std::string_view, convar_t*>* get_convar_map()
+{
+    static std::unordered_map<std::string_view, convar_t*> _map;
+    return &_map;
+}
+
 convar_t* convar_t::get_convar(const char* name)
 {
-    std::vector<convar_t*>* vector = convar_t::get_convar_list();
+    if (!name)
+        return NULL;
+
+    std::unordered_map<std::string_view, convar_t*>* map = get_convar_map();
+
+    auto it = map->find(name);
+
+    return (it == map->end()) ? NULL : it->second;
+}
+
+#define CONVAR_GET_TYPED_IMPL(name, TYPE)                          \
+    convar_##name##_t* convar_t::get_convar_##name(const char* n)  \
+    {                                                              \
+        convar_t* cvr = get_convar(n);                             \
+        if (!cvr || cvr->get_convar_type() != CONVAR_TYPE::TYPE)   \
+            return NULL;                                           \
+        return (convar_##name##_t*)cvr;                            \
+    }
+
+CONVAR_GET_TYPED_IMPL(int, CONVAR_TYPE_INT);
+CONVAR_GET_TYPED_IMPL(float, CONVAR_TYPE_FLOAT);
+CONVAR_GET_TYPED_IMPL(string, CONVAR_TYPE_STRING);
+
+Uint32 convar_t::add_change_callback(std::function<void()> func)
+{
+    Uint32 id = _change_callbacks_next_id++;
+    _change_callbacks.push_back(std::make_pair(id, func));
+    return id;
+}
 
-    for (size_t i = 0; i < vector->size(); i++)
+void convar_t::remove_change_callback(const Uint32 id)
+{
+    for (auto it = _change_callbacks.begin(); it != _change_callbacks.end(); it++)
     {
-        if (strcmp(name, vector->at(i)->get_name()) == 0)
-        {
-            return vector->at(i);
-        }
+        if (it->first != id)
+            continue;
+        _change_callbacks.erase(it);
+        return;
     }
+}
 
-    return NULL;
+void convar_t::run_change_callbacks()
+{
+    if (_change_callbacks.empty())
+        return;
+
+    /* Callbacks may register or remove other callbacks, so iterate over a copy */
+    std::vector<std::pair<Uint32, std::function<void()>>> callbacks = _change_callbacks;
+    for (auto& it : callbacks)
+        if (it.second)
+            it.second();
 }
 
 bool convar_t::_atexit = true;
@@ -87,14 +139,17 @@ convar_t::~convar_t()
     }
 }
 
-static bool check_if_convar_exists(const char* _name)
+void convar_t::register_convar()
 {
-    int exists = convar_t::get_convar(_name) != NULL;
+    bool inserted = get_convar_map()->insert(std::make_pair(std::string_view(_name), this)).second;
 #ifndef NDEBUG
-    if (exists == 1)
+    if (!inserted)
         util::die("Duplicate convar \"%s\"\n", _name);
+#else
+    (void)inserted;
 #endif
-    return exists;
+    convar_t::get_convar_list()->push_back(this);
+    cli_parser::apply_to(this);
 }
 
 convar_int_t::convar_int_t(const char* name, int default_value, int min, int max, const char* help_string, CONVAR_FLAGS flags, std::function<void()> func)
@@ -114,9 +169,7 @@ convar_int_t::convar_int_t(const char* name, int default_value, int min, int max
     if (_flags & CONVAR_FLAG_CLI_ONLY)
         _flags &= ~CONVAR_FLAG_SAVE;
     _type = CONVAR_TYPE::CONVAR_TYPE_INT;
-    check_if_convar_exists(_name);
-    convar_t::get_convar_list()->push_back(this);
-    cli_parser::apply_to(this);
+    register_convar();
 }
 
 convar_float_t::convar_float_t(
@@ -137,9 +190,7 @@ convar_float_t::convar_float_t(
     if (_flags & CONVAR_FLAG_CLI_ONLY)
         _flags &= ~CONVAR_FLAG_SAVE;
     _type = CONVAR_TYPE::CONVAR_TYPE_FLOAT;
-    check_if_convar_exists(_name);
-    convar_t::get_convar_list()->push_back(this);
-    cli_parser::apply_to(this);
+    register_convar();
 }
 
 convar_string_t::convar_string_t(const char* name, std::string default_value, const char* help_string, CONVAR_FLAGS flags, std::function<void()> func)
@@ -153,9 +204,7 @@ convar_string_t::convar_string_t(const char* name, std::string default_value, co
     if (_flags & CONVAR_FLAG_CLI_ONLY)
         _flags &= ~CONVAR_FLAG_SAVE;
     _type = CONVAR_TYPE::CONVAR_TYPE_STRING;
-    check_if_convar_exists(_name);
-    convar_t::get_convar_list()->push_back(this);
-    cli_parser::apply_to(this);
+    register_convar();
 }
 
 #define CONVAR_SET_IMPL(type)                                \
@@ -167,9 +216,12 @@ convar_string_t::convar_string_t(const char* name, std::string default_value, co
             return false;                                    \
         if (_pre_callback && !_pre_callback(_value, i))      \
             return false;                                    \
+        const bool changed = _value != i;                    \
         _value = i;                                          \
         if (_callback)                                       \
             _callback();                                     \
+        if (changed)                                         \
+            run_change_callbacks();                          \
         return true;                                         \
     }                                                        \
     bool convar_##type##_t::set_default(type i)              \
@@ -189,9 +241,12 @@ bool convar_string_t::set(std::string i)
 {
     if (_pre_callback && !_pre_callback(_value, i))
         return false;
+    const bool changed = _value != i;
     _value = i;
     if (_callback)
         _callback();
+    if (changed)
+        run_change_callbacks();
     return true;
 }
 
@@ -271,9 +326,9 @@ bool convar_string_t::imgui_edit()
 void convar_int_t::log_help()
 {
     if (_bounded)
-        dc_log_internal("\"%s\": %d (default: %d) (Min: %d, Max: %d)", _name, _value, _default, _min, _max);
+        dc_log_internal("\"%s\": %d (default: %d) (Min: %d, Max: %d)", _name, get(), _default, _min, _max);
     else
-        dc_log_internal("\"%s\": %d (default: %d)", _name, _value, _default);
+        dc_log_internal("\"%s\": %d (default: %d)", _name, get(), _default);
     if (_help_string && *_help_string != '\0')
         dc_log_internal("  %s", _help_string);
 }
@@ -281,9 +336,9 @@ void convar_int_t::log_help()
 void convar_float_t::log_help()
 {
     if (_bounded)
-        dc_log_internal("\"%s\": %.3f (default: %.3f) (Min: %.3f, Max: %.3f)", _name, _value, _default, _min, _max);
+        dc_log_internal("\"%s\": %.3f (default: %.3f) (Min: %.3f, Max: %.3f)", _name, get(), _default, _min, _max);
     else
-        dc_log_internal("\"%s\": %.3f (default: %.3f)", _name, _value, _default);
+        dc_log_internal("\"%s\": %.3f (default: %.3f)", _name, get(), _default);
     if (_help_string && *_help_string != '\0')
         dc_log_internal("  %s", _help_string);
 }
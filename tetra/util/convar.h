@@ -24,8 +24,10 @@
 #define TETRA__UTILS__CONVAR_H
 
 #include <SDL3/SDL.h>
+#include <atomic>
 #include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "tetra/gui/imgui.h"
@@ -71,6 +73,10 @@ enum CONVAR_FLAGS_ : Uint32
     CONVAR_FLAG_CLI_ONLY = (1 << 4),
 };
 
+class convar_int_t;
+class convar_float_t;
+class convar_string_t;
+
 /**
  * NOTE: Once a convar has been created, it must not be destroyed before program exit, doing so will lead to an abort(3) call
  */
@@ -111,9 +117,20 @@ public:
 
     /**
      * Get convar_t from corresponding name
+     *
+     * Lookups are hashed, but code that reads a convar repeatedly should still fetch it once and keep the pointer
      */
     static convar_t* get_convar(const char* name);
 
+    /**
+     * Typed variants of convar_t::get_convar()
+     *
+     * @returns NULL if the convar does not exist or is of a different type
+     */
+    static convar_int_t* get_convar_int(const char* name);
+    static convar_float_t* get_convar_float(const char* name);
+    static convar_string_t* get_convar_string(const char* name);
+
     static std::vector<convar_t*>* get_convar_list();
 
     /**
@@ -126,6 +143,26 @@ public:
      */
     virtual std::string get_convar_command() = 0;
 
+    /**
+     * Registers a callback that is called after the value of the convar changes
+     *
+     * Unlike the post-callback any number of these can be registered, which allows subsystems to react to changes instead of polling the value
+     *
+     * NOTE: Callbacks are called on the thread that changed the convar (Almost always the main thread)
+     * NOTE: Callbacks are not called when the convar is set to the value it already has
+     *
+     * @param func Callback function
+     * @returns Id to pass to convar_t::remove_change_callback()
+     */
+    Uint32 add_change_callback(std::function<void()> func);
+
+    /**
+     * Removes a callback registered with convar_t::add_change_callback()
+     *
+     * @param id Id returned by convar_t::add_change_callback()
+     */
+    void remove_change_callback(const Uint32 id);
+
     /**
      * Sets _atexit to true, allows convar_t::~convar_t() to be called with causing an abort(3) call
      */
@@ -145,11 +182,24 @@ protected:
     static bool _atexit;
     static bool _cli_lockout;
 
+    /**
+     * Adds the convar to the convar list and name lookup table, and applies any command line values
+     */
+    void register_convar();
+
+    /**
+     * Calls all callbacks registered with convar_t::add_change_callback()
+     */
+    void run_change_callbacks();
+
     CONVAR_TYPE _type;
     CONVAR_FLAGS _flags;
 
     const char* _help_string;
     const char* _name;
+
+    Uint32 _change_callbacks_next_id = 1;
+    std::vector<std::pair<Uint32, std::function<void()>>> _change_callbacks;
 };
 
 class convar_int_t : public convar_t
@@ -158,7 +208,10 @@ public:
     convar_int_t(
         const char* name, int default_value, int min, int max, const char* help_string, CONVAR_FLAGS flags = 0, std::function<void()> post_callback = NULL);
 
-    inline int get() const { return _value; }
+    /**
+     * Thread safe
+     */
+    inline int get() const { return _value.load(std::memory_order_relaxed); }
 
     inline int get_min() const { return _min; }
 
@@ -211,7 +264,7 @@ public:
     std::string get_convar_command();
 
 protected:
-    int _value;
+    std::atomic<int> _value;
     int _default;
     int _bounded;
     int _min;
@@ -226,7 +279,10 @@ public:
     convar_float_t(const char* name, float default_value, float min, float max, const char* help_string, CONVAR_FLAGS flags = 0,
         std::function<void()> post_callback = NULL);
 
-    inline float get() const { return _value; }
+    /**
+     * Thread safe
+     */
+    inline float get() const { return _value.load(std::memory_order_relaxed); }
 
     inline float get_min() const { return _min; }
 
@@ -279,7 +335,7 @@ public:
     std::string get_convar_command();
 
 protected:
-    float _value;
+    std::atomic<float> _value;
     float _default;
     int _bounded;
     float _min;
@@ -293,6 +349,9 @@ class convar_string_t : public convar_t
 public:
     convar_string_t(const char* name, std::string default_value, const char* help_string, CONVAR_FLAGS flags = 0, std::function<void()> post_callback = NULL);
 
+    /**
+     * NOTE: Unlike the int and float convars this is not thread safe
+     */
     inline std::string get() const { return _value; }
 
     inline std::string get_default() const { return _default; }